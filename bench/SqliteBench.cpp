@@ -0,0 +1,337 @@
+/**
+ * @file SqliteBench.cpp
+ * @brief Microbenchmarks for the sqlitedb hot paths.
+ *
+ * Every benchmark prints one record with its name, the number of measured
+ * operations and the mean cost in nanoseconds per operation, as JSON (the
+ * default) or CSV with `--csv`.  `--filter=<text>` runs only the benchmarks
+ * whose name contains the text and `--min-time=<ms>` sets how long each one
+ * runs.
+ */
+
+#include <SqliteConnectionPool.hpp>
+#include <SqliteDb.hpp>
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+  using namespace sdb;
+  using Clock = std::chrono::steady_clock;
+
+  struct BenchResult {
+    std::string name;
+    std::uint64_t operations;
+    double nsPerOp;
+  };
+
+  struct BenchConfig {
+    std::string filter;
+    std::chrono::milliseconds minTime { 200 };
+    bool csv = false;
+  };
+
+  class BenchRunner {
+    public:
+      explicit BenchRunner(BenchConfig config)
+        : mConfig(std::move(config)) {
+      }
+
+      /**
+       * @brief Run @p body repeatedly until the minimum time is reached.
+       * @param name Benchmark name.
+       * @param opsPerRun Number of operations performed by one call of @p body.
+       * @param body Benchmark body.
+       */
+      void run(const std::string& name, std::uint64_t opsPerRun, const std::function<void()>& body) {
+        if (!mConfig.filter.empty() && name.find(mConfig.filter) == std::string::npos) {
+          return;
+        }
+
+        body(); // warm-up
+
+        std::uint64_t runs = 0;
+        auto start = Clock::now();
+        auto elapsed = Clock::duration::zero();
+        do {
+          body();
+          ++runs;
+          elapsed = Clock::now() - start;
+        } while (elapsed < mConfig.minTime);
+
+        auto ns = std::chrono::duration<double, std::nano>(elapsed).count();
+        std::uint64_t operations = runs * opsPerRun;
+        mResults.push_back(BenchResult { name, operations, ns / static_cast<double>(operations) });
+      }
+
+      void print() const {
+        if (mConfig.csv) {
+          std::printf("name,operations,ns_per_op\n");
+          for (const auto& r : mResults) {
+            std::printf("%s,%llu,%.2f\n", r.name.c_str(), static_cast<unsigned long long>(r.operations), r.nsPerOp);
+          }
+          return;
+        }
+
+        std::printf("{\n  \"library\": \"sqlitedb\",\n  \"sqlite\": \"%s\",\n  \"benchmarks\": [\n", SQLITE_VERSION);
+        for (std::size_t i = 0; i < mResults.size(); ++i) {
+          const auto& r = mResults[i];
+          std::printf("    {\"name\": \"%s\", \"operations\": %llu, \"ns_per_op\": %.2f}%s\n", r.name.c_str(),
+                      static_cast<unsigned long long>(r.operations), r.nsPerOp, i + 1 < mResults.size() ? "," : "");
+        }
+        std::printf("  ]\n}\n");
+      }
+
+    private:
+      BenchConfig mConfig;
+      std::vector<BenchResult> mResults;
+  };
+
+  constexpr int ROW_COUNT = 10000;
+  constexpr int BATCH_ROWS = 10000;
+  const std::string POINT_QUERY = "SELECT id, name, score FROM items WHERE id = ?";
+
+  void populate(SqliteDb& db) {
+    db.execute("CREATE TABLE IF NOT EXISTS items (id INTEGER PRIMARY KEY, name TEXT, score REAL)");
+    db.execute("DELETE FROM items");
+
+    std::vector<std::tuple<std::int64_t, std::string, double>> rows;
+    rows.reserve(ROW_COUNT);
+    for (int i = 0; i < ROW_COUNT; ++i) {
+      rows.emplace_back(i, "item-" + std::to_string(i), i * 0.5);
+    }
+    db.executeBatch("INSERT INTO items (id, name, score) VALUES (?, ?, ?)", rows, SqliteDb::BatchOptions { });
+  }
+
+  void benchPrepare(BenchRunner& runner, SqliteDb& db) {
+    runner.run("prepare/uncached", 1, [&] {
+      auto stmt = db.prepare(POINT_QUERY);
+    });
+
+    runner.run("prepare/cached", 1, [&] {
+      auto stmt = db.cachedPrepare(POINT_QUERY);
+    });
+
+    runner.run("query/point_uncached", 1, [&] {
+      auto stmt = db.prepare(POINT_QUERY);
+      stmt.bind(1, 42);
+      stmt.step();
+    });
+
+    runner.run("query/point_cached", 1, [&] {
+      auto stmt = db.cachedPrepare(POINT_QUERY);
+      stmt->bind(1, 42);
+      stmt->step();
+    });
+  }
+
+  void benchCells(BenchRunner& runner, SqliteDb& db) {
+    const std::string text(64, 'x');
+
+    auto bindStmt = db.prepare("SELECT ?");
+    runner.run("bind/text_transient", 1000, [&] {
+      for (int i = 0; i < 1000; ++i) {
+        bindStmt.bind(1, std::string_view(text));
+      }
+    });
+
+    runner.run("bind/text_static", 1000, [&] {
+      for (int i = 0; i < 1000; ++i) {
+        bindStmt.bind(1, std::string_view(text), BindLifetime::STATIC);
+      }
+    });
+
+    auto scan = db.prepare("SELECT id, name, score FROM items");
+    runner.run("column/get_string", ROW_COUNT, [&] {
+      scan.reset();
+      std::size_t total = 0;
+      while (scan.step()) {
+        total += scan.getString(1).size();
+      }
+    });
+
+    runner.run("column/get_string_view", ROW_COUNT, [&] {
+      scan.reset();
+      std::size_t total = 0;
+      while (scan.step()) {
+        total += scan.getStringView(1).size();
+      }
+    });
+
+    runner.run("column/by_index", ROW_COUNT, [&] {
+      scan.reset();
+      double total = 0;
+      while (scan.step()) {
+        total += static_cast<double>(scan.getInt64(0)) + scan.getDouble(2);
+      }
+    });
+
+    runner.run("column/by_name", ROW_COUNT, [&] {
+      scan.reset();
+      double total = 0;
+      while (scan.step()) {
+        total += static_cast<double>(scan.getInt64("id")) + scan.getDouble("score");
+      }
+    });
+
+    runner.run("column/rows_range", ROW_COUNT, [&] {
+      scan.reset();
+      double total = 0;
+      for (auto [id, name, score] : scan.rows<std::int64_t, std::string_view, double>()) {
+        total += static_cast<double>(id) + score + static_cast<double>(name.size());
+      }
+    });
+  }
+
+  void benchBatch(BenchRunner& runner, SqliteDb& db) {
+    db.execute("CREATE TABLE IF NOT EXISTS sink (a INTEGER, b TEXT, c REAL)");
+
+    std::vector<std::vector<SqliteValue>> values;
+    std::vector<std::tuple<std::int64_t, std::string, double>> tuples;
+    values.reserve(BATCH_ROWS);
+    tuples.reserve(BATCH_ROWS);
+    for (int i = 0; i < BATCH_ROWS; ++i) {
+      values.push_back({ sqliteValue(std::int64_t { i }), sqliteValue(std::string("value")), sqliteValue(1.5) });
+      tuples.emplace_back(i, "value", 1.5);
+    }
+
+    const std::string insert = "INSERT INTO sink (a, b, c) VALUES (?, ?, ?)";
+
+    runner.run("batch/values_no_transaction", BATCH_ROWS, [&] {
+      db.executeBatch(insert, values);
+    });
+
+    SqliteDb::BatchOptions singleRow;
+    singleRow.multiRowValues = false;
+    runner.run("batch/values_transaction", BATCH_ROWS, [&] {
+      db.executeBatch(insert, values, singleRow);
+    });
+
+    runner.run("batch/values_multi_row", BATCH_ROWS, [&] {
+      db.executeBatch(insert, values, SqliteDb::BatchOptions { });
+    });
+
+    runner.run("batch/tuples_transaction", BATCH_ROWS, [&] {
+      db.executeBatch(insert, tuples, singleRow);
+    });
+
+    runner.run("batch/tuples_multi_row", BATCH_ROWS, [&] {
+      db.executeBatch(insert, tuples, SqliteDb::BatchOptions { });
+    });
+
+    db.execute("DELETE FROM sink");
+  }
+
+  void runThreads(unsigned threads, int opsPerThread, const std::function<void()>& op) {
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (unsigned t = 0; t < threads; ++t) {
+      workers.emplace_back([&] {
+        for (int i = 0; i < opsPerThread; ++i) {
+          op();
+        }
+      });
+    }
+    for (auto& w : workers) {
+      w.join();
+    }
+  }
+
+  void benchContention(BenchRunner& runner, const std::filesystem::path& path) {
+    constexpr int OPS_PER_THREAD = 2000;
+    const unsigned threads = std::max(2u, std::thread::hardware_concurrency());
+
+    auto shared = SqliteDb::open(path);
+    std::atomic<int> key { 0 };
+    auto pointRead = [&key](SqliteDb& db) {
+      auto stmt = db.cachedPrepare(POINT_QUERY);
+      stmt->bind(1, key.fetch_add(1, std::memory_order_relaxed) % ROW_COUNT);
+      stmt->step();
+    };
+
+    runner.run("contention/shared_connection_x" + std::to_string(threads), threads * OPS_PER_THREAD, [&] {
+      runThreads(threads, OPS_PER_THREAD, [&] {
+        pointRead(*shared);
+      });
+    });
+
+    SqliteConnectionPool::Options options;
+    options.maxReaders = threads;
+    SqliteConnectionPool pool(path, options);
+    runner.run("contention/pool_readers_x" + std::to_string(threads), threads * OPS_PER_THREAD, [&] {
+      runThreads(threads, OPS_PER_THREAD, [&] {
+        auto reader = pool.acquireReader();
+        pointRead(*reader);
+      });
+    });
+  }
+
+  BenchConfig parseArguments(int argc, char** argv) {
+    auto usage = [argv] {
+      std::fprintf(stderr, "usage: %s [--csv] [--filter=<text>] [--min-time=<ms>]\n", argv[0]);
+      std::exit(2);
+    };
+
+    BenchConfig config;
+    for (int i = 1; i < argc; ++i) {
+      std::string_view arg(argv[i]);
+      if (arg == "--csv") {
+        config.csv = true;
+      } else if (arg.starts_with("--filter=")) {
+        config.filter = std::string(arg.substr(9));
+      } else if (arg.starts_with("--min-time=")) {
+        std::string_view value = arg.substr(11);
+        int ms = 0;
+        auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), ms);
+        if (error != std::errc { } || end != value.data() + value.size() || ms < 0) {
+          usage();
+        }
+        config.minTime = std::chrono::milliseconds(ms);
+      } else {
+        usage();
+      }
+    }
+    return config;
+  }
+
+}
+
+int main(int argc, char** argv) {
+  BenchRunner runner(parseArguments(argc, argv));
+
+  auto dir = std::filesystem::temp_directory_path() / "sqlitedb_bench";
+  std::filesystem::create_directories(dir);
+  auto path = dir / "bench.db";
+
+  try {
+    {
+      auto db = SqliteDb::open(path);
+      db->setJournalMode(JournalMode::WAL);
+      db->setSynchronous(Synchronous::NORMAL);
+      populate(*db);
+
+      benchPrepare(runner, *db);
+      benchCells(runner, *db);
+      benchBatch(runner, *db);
+    }
+    benchContention(runner, path);
+  } catch (const SqliteException& e) {
+    std::fprintf(stderr, "benchmark failed: %s (code %d)\n", e.what(), e.errorCode());
+    return 1;
+  }
+
+  runner.print();
+  std::filesystem::remove_all(dir);
+  return 0;
+}
@@ -0,0 +1,114 @@
+#ifndef INCLUDE_SQLITEASYNCDB_HPP_
+#define INCLUDE_SQLITEASYNCDB_HPP_
+
+/**
+ * @file SqliteAsyncDb.hpp
+ * @brief Runs database jobs on a dedicated worker thread and returns futures.
+ */
+
+#include <SqliteDb.hpp>
+#include <SqliteJob.hpp>
+#include <SqliteJobQueue.hpp>
+#include <future>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace sdb {
+
+  /**
+   * @brief Asynchronous executor owning a `SqliteDb`.
+   *
+   * Jobs are callables taking a `SqliteDb&`.  They are queued on a lock-free
+   * MPSC queue and run in submission order on the executor's thread, so
+   * callers never block on SQLite.  Consecutive write jobs are coalesced
+   * into one `SqliteTransaction`, each inside its own SAVEPOINT: a job that
+   * throws is rolled back alone, and the futures of the others become ready
+   * once the shared transaction has committed.
+   *
+   * Example usage:
+   * @code
+   *   sdb::SqliteAsyncDb async(sdb::SqliteDb::open("app.db"));
+   *   auto count = async.submit([](sdb::SqliteDb& db) {
+   *     auto stmt = db.prepare("SELECT count(*) FROM users");
+   *     stmt.step();
+   *     return stmt.getInt64(0);
+   *   });
+   *   auto done = async.submitWrite([](sdb::SqliteDb& db) {
+   *     db.execute("INSERT INTO users (name) VALUES ('Dana')");
+   *   });
+   *   done.get(); // committed
+   * @endcode
+   */
+  class SqliteAsyncDb {
+    public:
+      struct Options {
+        /** Maximum number of consecutive write jobs sharing one transaction. */
+        std::size_t maxWriteBatch = 64;
+        /** Mode of the transactions wrapping write batches. */
+        SqliteTransaction::Mode writeMode = SqliteTransaction::Mode::Immediate;
+      };
+
+      /**
+       * @brief Take ownership of @p db and start the worker thread.
+       */
+      explicit SqliteAsyncDb(std::unique_ptr<SqliteDb> db);
+
+      /**
+       * @brief Take ownership of @p db and start the worker thread.
+       */
+      SqliteAsyncDb(std::unique_ptr<SqliteDb> db, Options options);
+
+      SqliteAsyncDb(const SqliteAsyncDb&) = delete;
+      SqliteAsyncDb& operator=(const SqliteAsyncDb&) = delete;
+
+      /**
+       * @brief Run every queued job, then stop the worker thread.
+       */
+      ~SqliteAsyncDb();
+
+      /**
+       * @brief Queue a job that runs outside any implicit transaction.
+       * @param job Callable invoked as `job(SqliteDb&)`.
+       * @return Future holding the job's result or exception.
+       */
+      template<typename F>
+        auto submit(F&& job) -> std::future<std::invoke_result_t<std::decay_t<F>&, SqliteDb&>>;
+
+      /**
+       * @brief Queue a write job that may share a transaction with its neighbours.
+       * @param job Callable invoked as `job(SqliteDb&)`.
+       * @return Future that becomes ready after the transaction has committed.
+       */
+      template<typename F>
+        auto submitWrite(F&& job) -> std::future<std::invoke_result_t<std::decay_t<F>&, SqliteDb&>>;
+
+    private:
+      std::unique_ptr<SqliteDb> mDb;
+      Options mOptions;
+      SqliteJobQueue mQueue;
+      std::thread mWorker;
+
+      void push(SqliteJobPtr job);
+      void workerLoop();
+      void runWriteBatch(std::vector<SqliteJobPtr>& batch);
+  };
+
+  template<typename F>
+  auto SqliteAsyncDb::submit(F&& job) -> std::future<std::invoke_result_t<std::decay_t<F>&, SqliteDb&>> {
+      auto [queued, future] = makeSqliteJob(std::forward<F>(job), false);
+      push(std::move(queued));
+      return std::move(future);
+  }
+
+  template<typename F>
+  auto SqliteAsyncDb::submitWrite(F&& job) -> std::future<std::invoke_result_t<std::decay_t<F>&, SqliteDb&>> {
+      auto [queued, future] = makeSqliteJob(std::forward<F>(job), true);
+      push(std::move(queued));
+      return std::move(future);
+  }
+
+} /* namespace sdb */
+
+#endif /* INCLUDE_SQLITEASYNCDB_HPP_ */
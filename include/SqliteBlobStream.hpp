@@ -0,0 +1,121 @@
+#ifndef INCLUDE_SQLITEBLOBSTREAM_HPP_
+#define INCLUDE_SQLITEBLOBSTREAM_HPP_
+
+/**
+ * @file SqliteBlobStream.hpp
+ * @brief Incremental I/O on a single BLOB value.
+ */
+
+#include <SqliteTypes.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace sdb {
+
+  /**
+   * @brief Reads and writes one BLOB in chunks through `sqlite3_blob_*`.
+   *
+   * Opened with `SqliteDb::openBlob()`, the stream never holds more of the
+   * value in memory than the caller's buffer.  It keeps a position like a
+   * file: `read()` and `write()` advance it, `seek()` moves it.  Writes
+   * overwrite bytes in place and cannot change the size of the value, so
+   * large values are inserted with `SqliteStatement::bindZeroBlob()` first.
+   * `reopen()` points the handle at the same column of another row without
+   * paying for a new open.
+   *
+   * The stream must not outlive its `SqliteDb`.  Changing the row through
+   * SQL invalidates the stream, which then throws until reopened.
+   *
+   * Example usage:
+   * @code
+   *   auto insert = db->prepare("INSERT INTO artifacts (data) VALUES (?)");
+   *   insert.bindZeroBlob(1, fileSize);
+   *   insert.step();
+   *
+   *   auto blob = db->openBlob("artifacts", "data", db->getLastInsertedRowId(), true);
+   *   std::vector<std::byte> chunk(1 << 20);
+   *   while (auto n = readFromFile(chunk)) {
+   *     blob.write(std::span(chunk).first(n));
+   *   }
+   * @endcode
+   */
+  class SqliteBlobStream {
+    public:
+      SqliteBlobStream(SqliteBlobStream&& other) noexcept;
+      SqliteBlobStream& operator=(SqliteBlobStream&& other) noexcept;
+      SqliteBlobStream(const SqliteBlobStream&) = delete;
+      SqliteBlobStream& operator=(const SqliteBlobStream&) = delete;
+      ~SqliteBlobStream() = default;
+
+      /**
+       * @brief Size of the BLOB in bytes.
+       */
+      std::size_t size() const noexcept;
+
+      /**
+       * @brief Current position in bytes.
+       */
+      std::size_t tell() const noexcept;
+
+      /**
+       * @brief Move the position.
+       * @throws sdb::SqliteBlobException if @p offset is past the end.
+       */
+      void seek(std::size_t offset);
+
+      /**
+       * @brief Whether the stream was opened for writing.
+       */
+      bool isWritable() const noexcept;
+
+      /**
+       * @brief Read up to `buffer.size()` bytes at the position and advance it.
+       * @return Number of bytes read, 0 at the end of the BLOB.
+       * @throws sdb::SqliteBlobException if the read fails.
+       */
+      std::size_t read(std::span<std::byte> buffer);
+
+      /**
+       * @brief Read exactly `buffer.size()` bytes at @p offset; the position is unchanged.
+       * @throws sdb::SqliteBlobException if the range is out of bounds or the read fails.
+       */
+      void readAt(std::size_t offset, std::span<std::byte> buffer) const;
+
+      /**
+       * @brief Write @p data at the position and advance it.
+       * @throws sdb::SqliteBlobException if the write would pass the end or fails.
+       */
+      void write(std::span<const std::byte> data);
+
+      /**
+       * @brief Write @p data at @p offset; the position is unchanged.
+       * @throws sdb::SqliteBlobException if the range is out of bounds or the write fails.
+       */
+      void writeAt(std::size_t offset, std::span<const std::byte> data);
+
+      /**
+       * @brief Move the handle to the same column of row @p rowid and rewind.
+       * @throws sdb::SqliteBlobException if the row does not exist or its
+       *   value is not a BLOB or TEXT.  The stream is unusable afterwards.
+       */
+      void reopen(std::int64_t rowid);
+
+    private:
+      friend class SqliteDb;
+
+      SqliteBlobStream(SqliteBlobPtr blob, sqlite3* connection, bool writable);
+
+      SqliteBlobPtr mBlob;
+      sqlite3* mConnection;
+      std::size_t mSize;
+      std::size_t mPosition;
+      bool mWritable;
+
+      void checkRange(std::size_t offset, std::size_t length) const;
+      [[noreturn]] void fail(const char* what, int rc) const;
+  };
+
+} /* namespace sdb */
+
+#endif /* INCLUDE_SQLITEBLOBSTREAM_HPP_ */
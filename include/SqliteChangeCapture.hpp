@@ -0,0 +1,330 @@
+#ifndef INCLUDE_SQLITECHANGECAPTURE_HPP_
+#define INCLUDE_SQLITECHANGECAPTURE_HPP_
+
+/**
+ * @file SqliteChangeCapture.hpp
+ * @brief Committed row changes streamed to a consumer thread.
+ */
+
+#include <SqliteChangeListener.hpp>
+#include <SqliteTypes.hpp>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace sdb {
+
+  /**
+   * @brief One changed row of a committed transaction.
+   */
+  struct SqliteChangeRecord {
+    ChangeOperation operation = ChangeOperation::INSERT;
+    /** Views into storage owned by the capture, valid as long as it lives. */
+    std::string_view schema;
+    std::string_view table;
+    /** Rowid after an INSERT or UPDATE, before a DELETE. */
+    std::int64_t rowid = 0;
+    /** Rowid before an UPDATE; differs from `rowid` when the UPDATE moved the row. */
+    std::int64_t oldRowid = 0;
+    /** Full row before an UPDATE or DELETE; empty unless values are captured. */
+    std::vector<SqliteValue> oldValues;
+    /** Full row after an INSERT or UPDATE; empty unless values are captured. */
+    std::vector<SqliteValue> newValues;
+    /** 1-based sequence number of the transaction, in commit order. */
+    std::uint64_t transaction = 0;
+  };
+
+  namespace detail {
+
+    /**
+     * @brief Bounded single-producer, single-consumer queue.
+     *
+     * Head and tail live on separate cache lines and each side keeps a copy
+     * of the other's index, so shared state is only read when the queue
+     * looks full (producer) or empty (consumer).
+     */
+    template<typename T>
+    class SqliteSpscRing {
+      public:
+        explicit SqliteSpscRing(std::size_t capacity)
+          : mSlots(std::bit_ceil(std::max<std::size_t>(capacity, 2)))
+          , mMask(mSlots.size() - 1) {
+        }
+
+        /**
+         * @brief Producer: move @p value in, unless the queue is full.
+         */
+        bool tryPush(T& value) {
+          std::size_t tail = mTail.load(std::memory_order_relaxed);
+          if (tail - mCachedHead == mSlots.size()) {
+            mCachedHead = mHead.load(std::memory_order_acquire);
+            if (tail - mCachedHead == mSlots.size()) {
+              return false;
+            }
+          }
+          mSlots[tail & mMask] = std::move(value);
+          mTail.store(tail + 1, std::memory_order_release);
+          return true;
+        }
+
+        /**
+         * @brief Consumer: move the oldest value out, unless the queue is empty.
+         */
+        bool tryPop(T& value) {
+          std::size_t head = mHead.load(std::memory_order_relaxed);
+          if (head == mCachedTail) {
+            mCachedTail = mTail.load(std::memory_order_acquire);
+            if (head == mCachedTail) {
+              return false;
+            }
+          }
+          value = std::move(mSlots[head & mMask]);
+          mHead.store(head + 1, std::memory_order_release);
+          return true;
+        }
+
+        /**
+         * @brief Producer: block until the consumer frees a slot.
+         */
+        void waitForSpace() {
+          std::size_t tail = mTail.load(std::memory_order_relaxed);
+          std::size_t head = mHead.load(std::memory_order_acquire);
+          while (tail - head == mSlots.size()) {
+            mHead.wait(head, std::memory_order_acquire);
+            head = mHead.load(std::memory_order_acquire);
+          }
+        }
+
+        /**
+         * @brief Consumer: wake a producer blocked in waitForSpace().
+         */
+        void notifySpace() {
+          mHead.notify_one();
+        }
+
+        std::size_t getCapacity() const noexcept {
+          return mSlots.size();
+        }
+
+      private:
+        std::vector<T> mSlots;
+        std::size_t mMask;
+
+        alignas(64) std::atomic<std::size_t> mHead { 0 };
+        std::size_t mCachedTail = 0;
+
+        alignas(64) std::atomic<std::size_t> mTail { 0 };
+        std::size_t mCachedHead = 0;
+    };
+
+  } /* namespace detail */
+
+  /**
+   * @brief Change data capture: row changes of committed transactions,
+   *        delivered in commit order on a dedicated thread.
+   *
+   * Installed with `SqliteDb::enableChangeCapture()`.  While a transaction
+   * runs, the update hook (or the preupdate hook when the library has it)
+   * appends a record per changed row to a buffer private to the writing
+   * connection.  The commit hook publishes the transaction's records into a
+   * lock-free single-producer ring buffer, and the rollback hook discards
+   * them.  The consumer thread drains the ring and calls the consumer once
+   * per transaction, so changes reach it without re-reading the rows.
+   *
+   * A full ring blocks the committing connection until the consumer catches
+   * up, which bounds memory.  The commit waits while holding the
+   * connection, so the consumer must not touch this `SqliteDb` at all:
+   * calls that take the connection throw `SqliteDbException` on the
+   * consumer thread, and statements of the connection must not be stepped
+   * there either.  Nor may the consumer wait on a write to this database
+   * made through another connection.  Records are published from the commit hook,
+   * just before the commit is made durable, so a COMMIT that then fails
+   * with an I/O error has still been delivered.  The records of a statement
+   * that fails inside an explicit transaction, and of changes undone by
+   * `SqliteSavepoint::rollback()`, are dropped; a ROLLBACK TO issued as SQL
+   * is not seen, so what it undid is still delivered.  Without the preupdate
+   * hook, WITHOUT ROWID tables and truncating deletes are not seen (see
+   * `SqliteChangeListener`).
+   *
+   * A change that cannot be recorded (out of memory, or a value SQLite
+   * fails to read) never unwinds into SQLite: the rest of its transaction
+   * is dropped, counted in `Stats::lost`, and the error is rethrown by
+   * flush().
+   *
+   * Example usage:
+   * @code
+   *   db->enableChangeCapture([&](std::span<const sdb::SqliteChangeRecord> changes) {
+   *     for (const auto& change : changes) {
+   *       cacheTier.apply(change.table, change.rowid, change.operation, change.newValues);
+   *     }
+   *   });
+   * @endcode
+   */
+  class SqliteChangeCapture : public SqliteChangeListener {
+    public:
+      /**
+       * @brief Called on the consumer thread with the records of one committed transaction.
+       *
+       * Exceptions are caught so the ring keeps draining; the first one
+       * (or the first recording failure) is rethrown by flush().
+       */
+      using Consumer = std::function<void(std::span<const SqliteChangeRecord>)>;
+
+      struct Options {
+        /** Ring buffer slots, rounded up to a power of two. */
+        std::size_t capacity = 4096;
+        /** Record full old and new rows.  Needs the preupdate hook
+         *  (SQLITE_ENABLE_PREUPDATE_HOOK); ignored without it. */
+        bool captureValues = true;
+      };
+
+      struct Stats {
+        /** Transactions published by the commit hook. */
+        std::uint64_t transactions = 0;
+        /** Records published. */
+        std::uint64_t records = 0;
+        /** Transactions handed to the consumer. */
+        std::uint64_t delivered = 0;
+        /** Records dropped by rollbacks and by lost transactions. */
+        std::uint64_t discarded = 0;
+        /** Committed transactions not delivered because a change could not be recorded. */
+        std::uint64_t lost = 0;
+        /** Commits that had to wait for ring space. */
+        std::uint64_t stalls = 0;
+      };
+
+      explicit SqliteChangeCapture(Consumer consumer);
+      SqliteChangeCapture(Consumer consumer, Options options);
+
+      SqliteChangeCapture(const SqliteChangeCapture&) = delete;
+      SqliteChangeCapture& operator=(const SqliteChangeCapture&) = delete;
+
+      /**
+       * @brief Deliver what was published and stop the consumer thread.
+       *
+       * When the consumer itself destroys the capture, e.g. by releasing
+       * the last owner of the database, the thread is detached instead:
+       * it finishes the current call and ends, and what is still queued is
+       * not delivered.  The consumer must then return without touching
+       * state owned by the capture or the database.
+       */
+      ~SqliteChangeCapture() override;
+
+      /**
+       * @brief Wait until every transaction committed so far has been delivered.
+       * @throws Any exception the consumer threw, or that lost a transaction,
+       *         since the last flush().
+       * @throws sdb::SqliteDbException when called from the consumer, which
+       *         would wait for itself.
+       */
+      void flush();
+
+      Stats getStats() const noexcept;
+
+      /**
+       * @brief Whether records carry full rows, i.e. values were requested
+       *        and the preupdate hook is available.
+       */
+      bool isCapturingValues() const noexcept {
+        return mCaptureValues;
+      }
+
+      /**
+       * @brief Whether the calling thread is the consumer thread.
+       */
+      bool isConsumerThread() const noexcept {
+        return std::this_thread::get_id() == mThread.get_id();
+      }
+
+      void onUpdate(ChangeOperation operation, std::string_view schema, std::string_view table,
+                    std::int64_t rowid) override;
+      void onPreUpdate(const SqlitePreUpdate& change) override;
+      void onCommit() override;
+      void onRollback() override;
+
+    private:
+      friend class SqliteDb;
+      friend class SqliteSavepoint;
+      friend class SqliteStatement;
+
+      /** Key of the capture in the client data of its connection. */
+      static constexpr const char* CLIENT_DATA = "sdb::SqliteChangeCapture";
+
+      struct Slot {
+        SqliteChangeRecord record;
+        /** Last record of its transaction. */
+        bool last = false;
+      };
+
+      Consumer mConsumer;
+      bool mPreUpdate;
+      bool mCaptureValues;
+
+      // Producer side, only touched from the hooks, which SQLite serializes
+      std::vector<SqliteChangeRecord> mPending;
+      std::unordered_set<std::string> mNames;
+      std::string_view mLastSchema;
+      std::string_view mLastTable;
+      std::uint64_t mTransaction = 0;
+      /** A change of the current transaction could not be recorded. */
+      bool mPoisoned = false;
+      /** Top-level statements started in the current transaction, with the
+       *  number of pending records at their start. */
+      std::vector<std::pair<const sqlite3_stmt*, std::size_t>> mStatements;
+
+      detail::SqliteSpscRing<Slot> mRing;
+      std::atomic<std::uint32_t> mSignal { 0 };
+      std::atomic<bool> mStopping { false };
+
+      std::atomic<std::uint64_t> mPublished { 0 };
+      std::atomic<std::uint64_t> mRecords { 0 };
+      std::atomic<std::uint64_t> mDelivered { 0 };
+      std::atomic<std::uint64_t> mDiscarded { 0 };
+      std::atomic<std::uint64_t> mStalls { 0 };
+      std::atomic<std::uint64_t> mLost { 0 };
+
+      std::mutex mErrorMutex;
+      std::exception_ptr mError;
+
+      /** Consumer thread state the destructor hands over when run on that thread. */
+      struct Orphan {
+        bool orphaned = false;
+        Consumer consumer;
+      };
+      /** Set by the consumer thread when it starts; only used from it. */
+      Orphan* mOrphan = nullptr;
+
+      std::thread mThread;
+
+      std::string_view intern(std::string_view name, std::string_view& last);
+      void beginStatement(sqlite3_stmt* statement) noexcept;
+      std::size_t getMark(sqlite3* connection) const noexcept;
+      void discardSince(sqlite3* connection, std::size_t mark) noexcept;
+      void truncate(std::size_t mark) noexcept;
+      void poison() noexcept;
+      void recordError(std::exception_ptr error) noexcept;
+      void wakeConsumer();
+      void run();
+
+      /**
+       * @brief Drop what a statement that failed inside a transaction undid.
+       *        No-op unless a capture is registered on its connection.
+       */
+      static void discardFailedStatement(sqlite3_stmt* statement) noexcept;
+  };
+
+} /* namespace sdb */
+
+#endif /* INCLUDE_SQLITECHANGECAPTURE_HPP_ */
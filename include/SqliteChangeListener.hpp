@@ -0,0 +1,140 @@
+#ifndef INCLUDE_SQLITECHANGELISTENER_HPP_
+#define INCLUDE_SQLITECHANGELISTENER_HPP_
+
+/**
+ * @file SqliteChangeListener.hpp
+ * @brief Observer of the row changes and transaction outcomes of a connection.
+ */
+
+#include <SqliteTypes.hpp>
+#include <cstdint>
+#include <string_view>
+
+namespace sdb {
+
+  /**
+   * @brief Row about to change, as reported by the preupdate hook.
+   *
+   * Only valid during `SqliteChangeListener::onPreUpdate()`.  The hook is
+   * available when the library is built with SQLITE_ENABLE_PREUPDATE_HOOK
+   * (see `SqliteDb::hasPreUpdateHook()`).  Unlike the update hook it also
+   * sees WITHOUT ROWID tables, rows deleted by REPLACE, and deletes that
+   * SQLite would otherwise run as a truncate.
+   */
+  class SqlitePreUpdate {
+    public:
+      SqlitePreUpdate(sqlite3* db, ChangeOperation operation, std::string_view schema, std::string_view table,
+                      std::int64_t oldRowid, std::int64_t newRowid) noexcept
+        : mDb(db)
+        , mOperation(operation)
+        , mSchema(schema)
+        , mTable(table)
+        , mOldRowid(oldRowid)
+        , mNewRowid(newRowid) {
+      }
+
+      ChangeOperation getOperation() const noexcept {
+        return mOperation;
+      }
+
+      std::string_view getSchema() const noexcept {
+        return mSchema;
+      }
+
+      std::string_view getTable() const noexcept {
+        return mTable;
+      }
+
+      /**
+       * @brief Rowid before the change; meaningless for INSERT and WITHOUT ROWID tables.
+       */
+      std::int64_t getOldRowid() const noexcept {
+        return mOldRowid;
+      }
+
+      /**
+       * @brief Rowid after the change; meaningless for DELETE and WITHOUT ROWID tables.
+       */
+      std::int64_t getNewRowid() const noexcept {
+        return mNewRowid;
+      }
+
+      int getColumnCount() const noexcept;
+
+      /**
+       * @brief 0 for a change made by a statement, 1 for a trigger it fired, and so on.
+       */
+      int getDepth() const noexcept;
+
+      /**
+       * @brief Column value before an UPDATE or DELETE.
+       * @throws sdb::SqliteDbException for an INSERT or a column out of range.
+       */
+      SqliteValue getOldValue(int column) const;
+
+      /**
+       * @brief Column value after an INSERT or UPDATE.
+       * @throws sdb::SqliteDbException for a DELETE or a column out of range.
+       */
+      SqliteValue getNewValue(int column) const;
+
+    private:
+      sqlite3* mDb;
+      ChangeOperation mOperation;
+      std::string_view mSchema;
+      std::string_view mTable;
+      std::int64_t mOldRowid;
+      std::int64_t mNewRowid;
+  };
+
+  /**
+   * @brief Receives the update, preupdate, commit and rollback hooks of one connection.
+   *
+   * SQLite keeps a single slot per hook; `SqliteDb::addChangeListener()`
+   * owns those slots and fans every callback out to the registered
+   * listeners, in registration order.  Callbacks run on the thread stepping
+   * the statement, inside SQLite, and must not use the connection.
+   *
+   * The update hook only covers rowid tables: changes to WITHOUT ROWID
+   * tables, rows dropped by the truncate optimization or by REPLACE
+   * conflict resolution, and schema changes are not reported.
+   */
+  class SqliteChangeListener {
+    public:
+      virtual ~SqliteChangeListener() = default;
+
+      /**
+       * @brief A row of @p schema.@p table was inserted, updated or deleted.
+       */
+      virtual void onUpdate(ChangeOperation operation, std::string_view schema, std::string_view table,
+                            std::int64_t rowid) {
+        (void) operation;
+        (void) schema;
+        (void) table;
+        (void) rowid;
+      }
+
+      /**
+       * @brief A row is about to change; only called when the library has
+       *        the preupdate hook.  Called before the matching onUpdate().
+       */
+      virtual void onPreUpdate(const SqlitePreUpdate& change) {
+        (void) change;
+      }
+
+      /**
+       * @brief A transaction is about to commit.
+       */
+      virtual void onCommit() {
+      }
+
+      /**
+       * @brief A transaction was rolled back (not reported for ROLLBACK TO).
+       */
+      virtual void onRollback() {
+      }
+  };
+
+} /* namespace sdb */
+
+#endif /* INCLUDE_SQLITECHANGELISTENER_HPP_ */
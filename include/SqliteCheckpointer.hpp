@@ -0,0 +1,150 @@
+#ifndef INCLUDE_SQLITECHECKPOINTER_HPP_
+#define INCLUDE_SQLITECHECKPOINTER_HPP_
+
+/**
+ * @file SqliteCheckpointer.hpp
+ * @brief Background WAL checkpoints on a dedicated connection and thread.
+ */
+
+#include <SqliteDb.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace sdb {
+
+  /**
+   * @brief Moves WAL checkpoints off the write path.
+   *
+   * The checkpointer opens its own connection to a WAL database and runs
+   * checkpoints from a background thread.  Writers registered with watch()
+   * report the WAL frame count after every commit through the WAL hook; a
+   * PASSIVE checkpoint runs once `walFrameThreshold` frames were added since
+   * the last one.  The WAL file itself is watched as well, so a checkpoint
+   * also runs once writes have been idle for `idleTime`, including writes of
+   * connections that are not watched.  When readers keep a passive checkpoint from
+   * finishing and the WAL is past `restartThreshold`, it escalates to
+   * RESTART, and past `truncateThreshold` to TRUNCATE, which also shrinks the
+   * file.  Writers should disable SQLite's own autocheckpoint
+   * (`Tuning::walAutoCheckpoint = 0`) so that no checkpoint runs on their
+   * thread; `SqliteConnectionPool` does this when its checkpointer is enabled.
+   *
+   * Example usage:
+   * @code
+   *   sdb::SqliteCheckpointer checkpointer("app.db");
+   *   // ... writers run with wal_autocheckpoint = 0
+   *   auto stats = checkpointer.getStats();
+   * @endcode
+   */
+  class SqliteCheckpointer {
+    public:
+      struct Options {
+        /** How often the WAL file is looked at. */
+        std::chrono::milliseconds pollInterval { 100 };
+        /** Checkpoint once watched writers added this many WAL frames
+         *  (pages) since the last checkpoint; SQLite's autocheckpoint default. */
+        int walFrameThreshold = 1000;
+        /** Checkpoint pending frames once no write happened for this long. */
+        std::chrono::milliseconds idleTime { 1000 };
+        /** Escalate an incomplete checkpoint to RESTART past this WAL size, in bytes. */
+        std::uintmax_t restartThreshold = 64 * 1024 * 1024;
+        /** Escalate to TRUNCATE past this WAL size, in bytes. */
+        std::uintmax_t truncateThreshold = 256 * 1024 * 1024;
+        /** How long RESTART and TRUNCATE wait on readers and writers. */
+        std::chrono::milliseconds busyTimeout { 1000 };
+      };
+
+      struct Stats {
+        std::uint64_t checkpoints = 0;
+        std::uint64_t passiveCheckpoints = 0;
+        std::uint64_t restartCheckpoints = 0;
+        std::uint64_t truncateCheckpoints = 0;
+        /** Checkpoints that could not copy every frame back. */
+        std::uint64_t incompleteCheckpoints = 0;
+        std::uint64_t errors = 0;
+        std::chrono::nanoseconds lastDuration { 0 };
+        std::chrono::nanoseconds maxDuration { 0 };
+        std::chrono::nanoseconds totalDuration { 0 };
+        /** Frames in the WAL after the last checkpoint. */
+        int walFrames = 0;
+        /** Frames still waiting to be copied back after the last checkpoint. */
+        int backlogFrames = 0;
+        /** Size of the WAL file when it was last looked at. */
+        std::uintmax_t walBytes = 0;
+      };
+
+      /**
+       * @brief Open a checkpoint connection to @p filename and start the thread.
+       * @throw SqliteDbException if the database cannot be opened or is not in WAL mode.
+       */
+      explicit SqliteCheckpointer(const std::filesystem::path& filename);
+
+      /**
+       * @brief Open a checkpoint connection to @p filename and start the thread.
+       * @throw SqliteDbException if the database cannot be opened or is not in WAL mode.
+       */
+      SqliteCheckpointer(const std::filesystem::path& filename, Options options);
+
+      SqliteCheckpointer(const SqliteCheckpointer&) = delete;
+      SqliteCheckpointer& operator=(const SqliteCheckpointer&) = delete;
+
+      /**
+       * @brief Stop the thread and close the checkpoint connection.
+       */
+      ~SqliteCheckpointer();
+
+      /**
+       * @brief Receive the WAL frame count of @p writer after each of its commits.
+       *
+       * Installs the WAL hook of @p writer, which also turns off its SQLite
+       * autocheckpoint.  Call unwatch() before this checkpointer is destroyed
+       * if @p writer outlives it.
+       */
+      void watch(SqliteDb& writer);
+
+      /**
+       * @brief Remove the WAL hook installed by watch().
+       */
+      void unwatch(SqliteDb& writer);
+
+      /**
+       * @brief Run a checkpoint on the next loop iteration regardless of thresholds.
+       */
+      void requestCheckpoint();
+
+      /**
+       * @brief Snapshot of the checkpoint counters and WAL backlog.
+       */
+      Stats getStats() const;
+
+    private:
+      std::unique_ptr<SqliteDb> mDb;
+      std::filesystem::path mWalPath;
+      Options mOptions;
+
+      mutable std::mutex mMutex;
+      std::condition_variable mWake;
+      bool mStopping;
+      bool mRequested;
+      Stats mStats;
+
+      /** WAL size in frames reported by the latest commit of a watched writer. */
+      std::atomic<int> mWalFrames { 0 };
+      /** Frames watched writers added since the last checkpoint. */
+      std::atomic<int> mNewFrames { 0 };
+
+      std::thread mThread;
+
+      void run();
+      void runCheckpoint(std::uintmax_t walBytes);
+      static int onWalCommit(void* context, sqlite3* connection, const char* schema, int frames);
+  };
+
+} /* namespace sdb */
+
+#endif /* INCLUDE_SQLITECHECKPOINTER_HPP_ */
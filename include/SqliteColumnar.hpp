@@ -0,0 +1,104 @@
+#ifndef INCLUDE_SQLITECOLUMNAR_HPP_
+#define INCLUDE_SQLITECOLUMNAR_HPP_
+
+/**
+ * @file SqliteColumnar.hpp
+ * @brief Column-oriented result batches and their Arrow C Data Interface export.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+/* Structures of the Arrow C Data Interface, ABI-stable by specification. */
+struct ArrowSchema {
+  const char* format;
+  const char* name;
+  const char* metadata;
+  int64_t flags;
+  int64_t n_children;
+  struct ArrowSchema** children;
+  struct ArrowSchema* dictionary;
+  void (*release)(struct ArrowSchema*);
+  void* private_data;
+};
+
+struct ArrowArray {
+  int64_t length;
+  int64_t null_count;
+  int64_t offset;
+  int64_t n_buffers;
+  int64_t n_children;
+  const void** buffers;
+  struct ArrowArray** children;
+  struct ArrowArray* dictionary;
+  void (*release)(struct ArrowArray*);
+  void* private_data;
+};
+
+#endif /* ARROW_C_DATA_INTERFACE */
+
+namespace sdb {
+
+  /**
+   * @brief Physical type of a `SqliteColumnBuffer`.
+   */
+  enum class SqliteColumnType {
+    INT64, DOUBLE, TEXT, BLOB
+  };
+
+  /**
+   * @brief One column of a `SqliteColumnarBatch`, laid out like an Arrow array.
+   *
+   * Fixed-width columns fill `int64s` or `doubles` with one slot per row
+   * (0 for NULL rows).  TEXT and BLOB columns append their bytes to `data`
+   * and store `rows + 1` offsets, value `i` being
+   * `data[offsets[i], offsets[i + 1])`.  Bit `i` of `validity`
+   * (least significant bit first) is set when row `i` is not NULL.
+   */
+  struct SqliteColumnBuffer {
+    std::string name;
+    SqliteColumnType type = SqliteColumnType::INT64;
+    std::vector<std::uint8_t> validity;
+    std::size_t nullCount = 0;
+    std::vector<std::int64_t> int64s;
+    std::vector<double> doubles;
+    std::vector<std::int32_t> offsets;
+    std::vector<std::byte> data;
+
+    bool isNull(std::size_t row) const {
+      return (validity[row / 8] & (1u << (row % 8))) == 0;
+    }
+  };
+
+  /**
+   * @brief Up to `batchRows` rows of a result, stored column by column.
+   */
+  struct SqliteColumnarBatch {
+    std::size_t rows = 0;
+    std::vector<SqliteColumnBuffer> columns;
+
+    /**
+     * @brief Hand the batch to an Arrow consumer as a struct array.
+     *
+     * The buffers are moved into the exported array, which owns them until
+     * its release callback runs; the batch is left empty.  Types map to
+     * int64 (`l`), float64 (`g`), utf8 (`u`) and binary (`z`).
+     *
+     * @param array Receives the struct array.
+     * @param schema Receives the matching schema.
+     */
+    void exportToArrow(ArrowArray* array, ArrowSchema* schema);
+  };
+
+} /* namespace sdb */
+
+#endif /* INCLUDE_SQLITECOLUMNAR_HPP_ */
@@ -0,0 +1,172 @@
+#ifndef INCLUDE_SQLITECONNECTIONPOOL_HPP_
+#define INCLUDE_SQLITECONNECTIONPOOL_HPP_
+
+/**
+ * @file SqliteConnectionPool.hpp
+ * @brief Pool of WAL read-only connections plus a single writer connection.
+ */
+
+#include <SqliteCheckpointer.hpp>
+#include <SqliteDb.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace sdb {
+
+  /**
+   * @brief Hands out connections to one database file.
+   *
+   * The database is switched to `JournalMode::WAL` when the pool is created.
+   * Readers check out one of up to `maxReaders` read-only connections, which
+   * are opened lazily, so reads scale with the number of threads.  All writes
+   * go through the single writer connection, which only one thread can hold at
+   * a time, so writes stay ordered.
+   *
+   * Example usage:
+   * @code
+   *   sdb::SqliteConnectionPool::Options options;
+   *   options.maxReaders = 8;
+   *   options.onConnect = [](sdb::SqliteDb& db) { db.setCacheSize(8000); };
+   *   sdb::SqliteConnectionPool pool("app.db", options);
+   *
+   *   auto reader = pool.acquireReader();
+   *   auto stmt = reader->prepare("SELECT ...");
+   * @endcode
+   */
+  class SqliteConnectionPool {
+    public:
+      struct Options {
+        /** Maximum number of read-only connections. */
+        std::size_t maxReaders = 4;
+        /** How long acquire calls wait before throwing. */
+        std::chrono::milliseconds acquireTimeout { 5000 };
+        /** Synchronous mode applied to every connection. */
+        Synchronous synchronous = Synchronous::NORMAL;
+        /** Setup hook run on every new connection (PRAGMAs, extensions...). */
+        std::function<void(SqliteDb&)> onConnect;
+        /** Run WAL checkpoints on a background `SqliteCheckpointer` instead of
+         *  the writer's autocheckpoint. */
+        bool backgroundCheckpoint = false;
+        /** Options of the background checkpointer. */
+        SqliteCheckpointer::Options checkpointer;
+      };
+
+      /**
+       * @brief RAII lease on a pooled connection.
+       *
+       * Reader leases return the connection to the pool on destruction, the
+       * writer lease unlocks the writer lane.
+       */
+      class Connection {
+        public:
+          Connection(Connection&& other) noexcept;
+          Connection& operator=(Connection&& other) noexcept;
+          Connection(const Connection&) = delete;
+          Connection& operator=(const Connection&) = delete;
+          ~Connection();
+
+          SqliteDb& operator*() {
+            return *mDb;
+          }
+
+          SqliteDb* operator->() {
+            return mDb;
+          }
+
+          SqliteDb& get() {
+            return *mDb;
+          }
+
+        private:
+          friend class SqliteConnectionPool;
+
+          Connection(SqliteConnectionPool* pool, std::unique_ptr<SqliteDb> reader);
+          Connection(SqliteConnectionPool* pool, SqliteDb* writer);
+
+          SqliteConnectionPool* mPool;
+          std::unique_ptr<SqliteDb> mReader;
+          SqliteDb* mDb;
+
+          void release();
+      };
+
+      /**
+       * @brief Create a pool with default options and open its writer connection.
+       * @param filename Path to the database file.  It is created if missing.
+       * @throw SqliteDbException if the writer cannot be opened or WAL cannot be enabled.
+       */
+      explicit SqliteConnectionPool(const std::filesystem::path& filename);
+
+      /**
+       * @brief Create a pool and open its writer connection.
+       * @param filename Path to the database file.  It is created if missing.
+       * @param options Pool options.
+       * @throw SqliteDbException if the writer cannot be opened or WAL cannot be enabled.
+       */
+      SqliteConnectionPool(const std::filesystem::path& filename, Options options);
+
+      SqliteConnectionPool(const SqliteConnectionPool&) = delete;
+      SqliteConnectionPool& operator=(const SqliteConnectionPool&) = delete;
+
+      /**
+       * @brief Destroy the pool.  All leases must have been returned.
+       */
+      ~SqliteConnectionPool();
+
+      /**
+       * @brief Check out a read-only connection.
+       * @return Lease on an idle reader.
+       * @throw SqliteDbException if none becomes available within the acquire timeout.
+       */
+      Connection acquireReader();
+
+      /**
+       * @brief Check out the writer connection.
+       * @return Lease on the writer.
+       * @throw SqliteDbException if the writer stays busy beyond the acquire timeout.
+       */
+      Connection acquireWriter();
+
+      /**
+       * @brief Number of reader connections opened so far.
+       */
+      std::size_t getReaderCount() const;
+
+      /**
+       * @brief Number of idle reader connections.
+       */
+      std::size_t getIdleReaderCount() const;
+
+      /**
+       * @brief Background checkpointer, or nullptr unless `backgroundCheckpoint` is set.
+       */
+      SqliteCheckpointer* getCheckpointer() noexcept;
+
+    private:
+      std::filesystem::path mFilename;
+      Options mOptions;
+
+      std::unique_ptr<SqliteDb> mWriter;
+      std::timed_mutex mWriterMutex;
+
+      mutable std::mutex mMutex;
+      std::condition_variable mReaderAvailable;
+      std::vector<std::unique_ptr<SqliteDb>> mIdleReaders;
+      std::size_t mReaderCount;
+
+      // Declared last so that it stops before any connection closes
+      std::unique_ptr<SqliteCheckpointer> mCheckpointer;
+
+      std::unique_ptr<SqliteDb> openConnection(OpenMode mode);
+      void releaseReader(std::unique_ptr<SqliteDb> db);
+      void releaseWriter();
+  };
+
+} /* namespace sdb */
+
+#endif /* INCLUDE_SQLITECONNECTIONPOOL_HPP_ */
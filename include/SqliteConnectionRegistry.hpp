@@ -0,0 +1,95 @@
+#ifndef INCLUDE_SQLITECONNECTIONREGISTRY_HPP_
+#define INCLUDE_SQLITECONNECTIONREGISTRY_HPP_
+
+/**
+ * @file SqliteConnectionRegistry.hpp
+ * @brief One lazily opened, thread-confined connection per thread.
+ */
+
+#include <SqliteDb.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace sdb {
+
+  /**
+   * @brief Registry giving every thread its own connection to one database.
+   *
+   * The first `get()` on a thread opens a connection and parks it in a
+   * `thread_local` slot; later calls on that thread return it without
+   * taking a lock or touching an atomic.  Connections are opened
+   * thread-confined (`SQLITE_OPEN_NOMUTEX`, no wrapper locks) and keep their
+   * own prepared statement cache, so a hot read path is lock-free from the
+   * caller down to the pager.  A connection is closed when its thread exits
+   * or when the registry is destroyed, whichever comes first.
+   *
+   * Example usage:
+   * @code
+   *   sdb::SqliteConnectionRegistry readers("reference.db");
+   *   // on any worker thread:
+   *   auto stmt = readers.get().cachedPrepare("SELECT name FROM codes WHERE id = ?");
+   * @endcode
+   */
+  class SqliteConnectionRegistry {
+    public:
+      struct Options {
+        /** How the per-thread connections are opened; `threadConfined` is always set. */
+        SqliteDb::OpenOptions open = readOnly();
+        /** Setup hook run on every new connection (PRAGMAs, functions...). */
+        std::function<void(SqliteDb&)> onConnect;
+
+      private:
+        static SqliteDb::OpenOptions readOnly() {
+          SqliteDb::OpenOptions options;
+          options.mode = OpenMode::READ_ONLY;
+          return options;
+        }
+      };
+
+      explicit SqliteConnectionRegistry(const std::filesystem::path& filename);
+      SqliteConnectionRegistry(const std::filesystem::path& filename, Options options);
+
+      SqliteConnectionRegistry(const SqliteConnectionRegistry&) = delete;
+      SqliteConnectionRegistry& operator=(const SqliteConnectionRegistry&) = delete;
+
+      /**
+       * @brief Close every connection.  No thread may still be using one.
+       */
+      ~SqliteConnectionRegistry();
+
+      /**
+       * @brief The calling thread's connection, opened on first use.
+       * @throws sdb::SqliteDbException if the connection cannot be opened.
+       */
+      SqliteDb& get();
+
+      /**
+       * @brief Number of threads currently holding a connection.
+       */
+      std::size_t getConnectionCount() const;
+
+    private:
+      struct State {
+        std::filesystem::path filename;
+        Options options;
+        mutable std::mutex mutex;
+        std::vector<std::unique_ptr<SqliteDb>> connections;
+
+        void release(SqliteDb* db);
+      };
+
+      std::uint64_t mId;
+      std::shared_ptr<State> mState;
+
+      SqliteDb& connect();
+
+      friend struct SqliteThreadSlots;
+  };
+
+} /* namespace sdb */
+
+#endif /* INCLUDE_SQLITECONNECTIONREGISTRY_HPP_ */
@@ -1,21 +1,332 @@
 #ifndef SQLITEDB_HPP_
 #define SQLITEDB_HPP_
 
+#include <SqliteBlobStream.hpp>
+#include <SqliteChangeCapture.hpp>
+#include <SqliteChangeListener.hpp>
 #include <SqliteException.hpp>
+#include <SqliteFunction.hpp>
+#include <SqliteProfiler.hpp>
+#include <SqliteRangeTable.hpp>
+#include <SqliteResult.hpp>
+#include <SqliteResultCache.hpp>
+#include <SqliteSavepoint.hpp>
 #include <SqliteStatement.hpp>
+#include <SqliteStatementCache.hpp>
+#include <SqliteTransaction.hpp>
 #include <SqliteTypes.hpp>
 #include <SqliteValueBinder.hpp>
+#include <chrono>
+#include <condition_variable>
 #include <filesystem>
+#include <functional>
 #include <mutex>
+#include <optional>
 #include <ranges>
 #include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_set>
+#include <vector>
 
 namespace sdb {
 
-  class SqliteTransaction;
-
   class SqliteDb {
     public:
+      /**
+       * @brief Tuning knobs for the batching overload of executeBatch().
+       */
+      struct BatchOptions {
+        /** Rewrite a single-row `INSERT ... VALUES (?, ...)` into multi-row VALUES chunks. */
+        bool multiRowValues = true;
+        /** Upper bound on rows per chunk; 0 sizes chunks to `SQLITE_LIMIT_VARIABLE_NUMBER`. */
+        std::size_t maxRowsPerStatement = 0;
+        /** Run the batch inside a `SqliteTransaction`. */
+        bool useTransaction = true;
+        /** Mode of the transactions opened by the batch. */
+        SqliteTransaction::Mode transactionMode = SqliteTransaction::Mode::Immediate;
+        /** Commit and open a new transaction once N rows are done (checked per statement); 0 commits once at the end. */
+        std::size_t commitEvery = 0;
+      };
+
+      /**
+       * @brief Throughput figures returned by the batching overload of executeBatch().
+       */
+      struct BatchStats {
+        std::size_t rows = 0;
+        std::size_t statements = 0;
+        std::size_t commits = 0;
+        std::size_t rowsPerStatement = 1;
+        std::chrono::nanoseconds elapsed { 0 };
+
+        double rowsPerSecond() const {
+          auto seconds = std::chrono::duration<double>(elapsed).count();
+          return seconds > 0.0 ? static_cast<double>(rows) / seconds : 0.0;
+        }
+      };
+
+      /**
+       * @brief Flags of SQL functions registered with registerFunction() and friends.
+       */
+      struct FunctionOptions {
+        /** Same arguments give the same result, so the planner may factor calls out (`SQLITE_DETERMINISTIC`). */
+        bool deterministic = true;
+        /** Only callable from top-level SQL, not from triggers, views or schema (`SQLITE_DIRECTONLY`). */
+        bool directOnly = false;
+        /** Free of side effects and safe in untrusted schema (`SQLITE_INNOCUOUS`). */
+        bool innocuous = false;
+      };
+
+      /**
+       * @brief Settings of registerRangeTable().
+       */
+      struct RangeTableOptions {
+        /**
+         * Column the range is sorted by in ascending order, BINARY order for
+         * text.  Equality and range constraints on it become binary searches.
+         * The column must not be optional.
+         */
+        std::optional<std::size_t> sortedBy;
+      };
+
+      /**
+       * @brief Settings of importCsv() and importNdjson().
+       */
+      struct ImportOptions {
+        /** CSV field separator. */
+        char delimiter = ',';
+        /** CSV quote character; doubled inside a quoted field to escape it. */
+        char quote = '"';
+        /** The first CSV record holds column names. */
+        bool header = true;
+        /**
+         * Target columns.  Empty takes them from the CSV header or the keys of
+         * the first NDJSON object; a headerless CSV is then inserted by position.
+         */
+        std::vector<std::string> columns;
+        /** Create the table with untyped columns if it does not exist. */
+        bool createTable = true;
+        /** Insert empty unquoted CSV fields as NULL instead of ''. */
+        bool emptyAsNull = false;
+        /** Pad short CSV records with NULL and drop extra fields instead of failing. */
+        bool allowRaggedRows = false;
+        /** Rows per batch handed from the parser to the writer; rounded to whole multi-row statements. */
+        std::size_t batchRows = 8192;
+        /** Parsed batches the queue holds before the parser waits for the writer. */
+        std::size_t queueDepth = 4;
+        /** Commit and open a new transaction once N rows are inserted; 0 commits once at the end. */
+        std::size_t commitEvery = 1000000;
+        /** Mode of the import transactions. */
+        SqliteTransaction::Mode transactionMode = SqliteTransaction::Mode::Immediate;
+      };
+
+      /**
+       * @brief Throughput figures returned by importCsv() and importNdjson().
+       */
+      struct ImportStats {
+        std::size_t rows = 0;
+        std::size_t batches = 0;
+        std::size_t commits = 0;
+        std::size_t bytes = 0;
+        /** Times the writer found the queue empty: parsing is the bottleneck. */
+        std::size_t writerWaits = 0;
+        /** Times the parser found the queue full: inserting is the bottleneck. */
+        std::size_t parserWaits = 0;
+        std::chrono::nanoseconds elapsed { 0 };
+
+        double rowsPerSecond() const {
+          auto seconds = std::chrono::duration<double>(elapsed).count();
+          return seconds > 0.0 ? static_cast<double>(rows) / seconds : 0.0;
+        }
+      };
+
+      /**
+       * @brief Outcome of a WAL checkpoint, see checkpoint().
+       */
+      struct CheckpointResult {
+        /** Frames in the WAL file, or -1 if the database is not in WAL mode. */
+        int logFrames = -1;
+        /** Frames copied back into the database file, or -1. */
+        int checkpointedFrames = -1;
+        /** The checkpoint could not run to completion because of other connections. */
+        bool busy = false;
+      };
+
+      /**
+       * @brief Settings of backupTo().
+       */
+      struct BackupOptions {
+        /** Pages copied per `sqlite3_backup_step`; -1 copies everything in one step. */
+        int pagesPerStep = 256;
+        /** Pause between steps, during which the source is not locked. */
+        std::chrono::milliseconds sleepBetween { 10 };
+        /** Called after every step with the pages remaining and the total; return false to cancel. */
+        std::function<bool(int remaining, int total)> onProgress;
+        /** Attached database to copy, "main" by default. */
+        std::string sourceSchema = "main";
+      };
+
+      /**
+       * @brief Outcome of optimize().
+       */
+      struct OptimizeReport {
+        /** Tables re-analyzed, as "schema.table". */
+        std::vector<std::string> analyzedTables;
+        std::chrono::nanoseconds elapsed { 0 };
+      };
+
+      /**
+       * @brief Settings of setMaintenance().
+       */
+      struct MaintenanceOptions {
+        /** Run optimize() when the connection is closed. */
+        bool optimizeOnClose = false;
+        /** Run optimize() periodically from a background thread; 0 disables the timer. */
+        std::chrono::milliseconds interval { 0 };
+        /** `PRAGMA analysis_limit` used by the maintenance runs. */
+        int analysisLimit = 400;
+        /** Called after every maintenance run, on the thread that ran it. */
+        std::function<void(const OptimizeReport&)> onReport;
+      };
+
+      /**
+       * @brief Statement execution flagged by scan detection.
+       */
+      struct ScanReport {
+        /** SQL text as returned by `SqliteStatement::getSql()`. */
+        std::string sql;
+        std::uint64_t fullscanSteps = 0;
+        std::uint64_t autoindexes = 0;
+      };
+
+      /**
+       * @brief Settings of enableScanDetection().
+       */
+      struct ScanDetection {
+        /** Flag executions with at least this many full-scan steps; 0 ignores full scans. */
+        std::uint64_t minFullScanSteps = 1;
+        /** Flag executions that populated an automatic index. */
+        bool reportAutoIndex = true;
+        /** Flag each SQL text only the first time. */
+        bool reportOnce = true;
+        /**
+         * Invoked on the executing thread while SQLite holds the connection:
+         * it must not use the connection.  Reports are kept for
+         * getScanReports() either way.  Exceptions thrown are dropped so
+         * that they never unwind through SQLite.
+         */
+        std::function<void(const ScanReport&)> onScan;
+      };
+
+      /**
+       * @brief How open() opens the database file.
+       *
+       * The URI parameters are only used when one of them is set, so plain
+       * file names keep working unchanged.
+       */
+      struct OpenOptions {
+        OpenMode mode = OpenMode::READ_WRITE;
+        /** Create the file if it is missing; ignored in read-only mode. */
+        bool create = true;
+        /**
+         * `immutable=1`: the file never changes, so SQLite takes no locks and
+         * skips change detection on every transaction.  Forces read-only;
+         * a write by anyone else yields wrong results or corruption errors.
+         */
+        bool immutable = false;
+        /** `nolock=1`: take no file locks; no other connection may write. */
+        bool noLock = false;
+        /** Share the page cache between connections of this process to the same file. */
+        bool sharedCache = false;
+        ThreadingMode threading = ThreadingMode::DEFAULT;
+        /**
+         * The connection is never used by two threads at once: the wrapper's
+         * connection and statement cache locks are skipped, and DEFAULT
+         * threading becomes MULTI_THREAD.  Scheduled maintenance is refused.
+         */
+        bool threadConfined = false;
+        /** Name of a registered VFS; empty uses the default VFS. */
+        std::string vfs;
+      };
+
+      /**
+       * @brief Lookaside allocator geometry: @p slotCount slots of @p slotSize bytes.
+       *
+       * Lookaside serves a connection's small, short-lived allocations from a
+       * private slab without taking the global allocator lock.  A slot count
+       * of 0 disables lookaside.
+       */
+      struct Lookaside {
+        int slotSize = 1200;
+        int slotCount = 100;
+      };
+
+      /**
+       * @brief Per-connection storage tuning applied by open() or applyTuning().
+       *
+       * Every field is optional; unset fields keep SQLite's default.
+       */
+      struct Tuning {
+        /** `PRAGMA page_size` in bytes, a power of two in [512, 65536].  Only
+         *  takes effect on a new database or before VACUUM, and not in WAL mode. */
+        std::optional<int> pageSize;
+        /** `PRAGMA journal_mode`. */
+        std::optional<JournalMode> journalMode;
+        /** `PRAGMA synchronous`. */
+        std::optional<Synchronous> synchronous;
+        /** `PRAGMA mmap_size` in bytes; 0 disables memory-mapped I/O.  Capped
+         *  by SQLITE_CONFIG_MMAP_SIZE and the SQLITE_MAX_MMAP_SIZE build option. */
+        std::optional<std::int64_t> mmapSize;
+        /** Page cache size in KiB (`PRAGMA cache_size = -N`). */
+        std::optional<std::int64_t> cacheSizeKb;
+        /** `PRAGMA wal_autocheckpoint` in pages; 0 disables automatic checkpoints. */
+        std::optional<int> walAutoCheckpoint;
+        /** `PRAGMA cache_spill`: allow dirty pages to be written before commit. */
+        std::optional<bool> cacheSpill;
+        /** `PRAGMA temp_store`. */
+        std::optional<TempStore> tempStore;
+        /** Per-connection lookaside (`SQLITE_DBCONFIG_LOOKASIDE`). */
+        std::optional<Lookaside> lookaside;
+
+        /**
+         * @brief Large read-mostly databases: 64 GiB of mmap, big cache, in-memory temp tables.
+         */
+        static Tuning readHeavyAnalytics();
+
+        /**
+         * @brief Bulk loading: WAL with NORMAL sync, large cache kept in memory
+         *        until commit, and infrequent automatic checkpoints.
+         */
+        static Tuning writeHeavyIngest();
+      };
+
+      /**
+       * @brief Process-wide `sqlite3_config` settings, see configure().
+       */
+      struct GlobalConfig {
+        /** Default and maximum mmap size of new connections (`SQLITE_CONFIG_MMAP_SIZE`). */
+        std::optional<std::int64_t> defaultMmapSize;
+        std::optional<std::int64_t> maxMmapSize;
+        /** Slot size in bytes of the preallocated page cache (`SQLITE_CONFIG_PAGECACHE`),
+         *  page size plus a small header; SQLite allocates the slots itself. */
+        std::optional<int> pageCacheSlotSize;
+        /** Number of preallocated page cache slots. */
+        std::optional<int> pageCacheSlots;
+        /** Default lookaside of new connections (`SQLITE_CONFIG_LOOKASIDE`). */
+        std::optional<Lookaside> lookaside;
+      };
+
+      /**
+       * @brief Apply process-wide SQLite configuration.
+       *
+       * `sqlite3_config` only works before the library is initialized: call
+       * this at startup, before the first connection is opened.
+       *
+       * @throws sdb::SqliteDbException if SQLite rejects an option, typically
+       *   because it is already initialized.
+       */
+      static void configure(const GlobalConfig& config);
+
       /**
        * @brief Open a new database instance from a file.
        * @param filename Path to the SQLite database file.  If the file
@@ -24,6 +335,40 @@ namespace sdb {
        */
       static std::unique_ptr<SqliteDb> open(const std::filesystem::path& filename, OpenMode mode = OpenMode::READ_WRITE);
 
+      /**
+       * @brief Open a database and apply @p tuning before returning it.
+       *
+       * Either every tuning option is applied or the connection is closed and
+       * the error is thrown, so callers never see a half-tuned connection.
+       *
+       * @throws sdb::SqliteDbException if opening or tuning fails.
+       * @throws std::invalid_argument if a tuning value is out of range.
+       */
+      static std::unique_ptr<SqliteDb> open(const std::filesystem::path& filename, OpenMode mode, const Tuning& tuning);
+
+      /**
+       * @brief Open a database with URI parameters, mutexing and VFS choice.
+       *
+       * Example usage:
+       * @code
+       *   sdb::SqliteDb::OpenOptions options;
+       *   options.immutable = true;
+       *   options.threading = sdb::ThreadingMode::MULTI_THREAD;
+       *   auto reference = sdb::SqliteDb::open("/data/reference.db", options);
+       * @endcode
+       *
+       * @throws sdb::SqliteDbException if the database cannot be opened.
+       */
+      static std::unique_ptr<SqliteDb> open(const std::filesystem::path& filename, const OpenOptions& options);
+
+      /**
+       * @brief Open with @p options and apply @p tuning before returning.
+       * @throws sdb::SqliteDbException if opening or tuning fails.
+       * @throws std::invalid_argument if a tuning value is out of range.
+       */
+      static std::unique_ptr<SqliteDb> open(const std::filesystem::path& filename, const OpenOptions& options,
+                                            const Tuning& tuning);
+
       /**
        * @brief Create an in‑memory database.
        * @return Unique pointer to a new in‑memory `SqliteDb`.
@@ -32,7 +377,16 @@ namespace sdb {
 
       SqliteDb(const SqliteDb&) = delete;
       SqliteDb& operator=(const SqliteDb&) = delete;
-      ~SqliteDb() = default;
+      /**
+       * @brief Stop scheduled maintenance, run the on-close optimize if
+       *        enabled, then close the connection.
+       *
+       * May run on the change capture's consumer thread, e.g. when the
+       * consumer drops the last owner of the database.  The on-close
+       * optimize is skipped there, and the capture stops without
+       * delivering what is still queued.
+       */
+      ~SqliteDb();
 
       /**
        * @brief Check if the database connection is open.
@@ -40,6 +394,16 @@ namespace sdb {
        */
       bool isOpen() const noexcept;
 
+      /**
+       * @brief Whether the connection was opened with `OpenOptions::threadConfined`.
+       */
+      bool isThreadConfined() const noexcept;
+
+      /**
+       * @brief Whether a transaction is open, i.e. the connection is not in autocommit mode.
+       */
+      bool isInTransaction() const noexcept;
+
       /**
        * @brief Load a SQLite extension.
        * @param libraryPath Path to the shared library.
@@ -79,6 +443,60 @@ namespace sdb {
        */
       SqliteStatement prepare(const std::string& sql);
 
+      /**
+       * @brief Prepare a SQL statement through the statement cache.
+       *
+       * If an idle statement with the same SQL text is cached it is reused,
+       * otherwise a new one is prepared.  When the returned lease is released
+       * the statement is reset, its bindings are cleared and it is returned to
+       * the cache.  The lease must not outlive this `SqliteDb`.
+       *
+       * @param sql SQL query.
+       * @return A lease on the prepared statement.
+       */
+      SqliteCachedStatement cachedPrepare(const std::string& sql);
+
+      /**
+       * @brief Non-throwing prepare().
+       *
+       * A closed connection is reported as SQLITE_MISUSE.  The SQLite error
+       * text stays available through getErrorMessage() until the next call.
+       *
+       * @return The statement, or the error it failed with.
+       */
+      SqliteResult<SqliteStatement> tryPrepare(const std::string& sql);
+
+      /**
+       * @brief Non-throwing cachedPrepare().
+       * @return A lease on the statement, or the error it failed with.
+       */
+      SqliteResult<SqliteCachedStatement> tryCachedPrepare(const std::string& sql);
+
+      /**
+       * @brief Open a BLOB value for incremental I/O.
+       * @param table Table name.
+       * @param column Column holding the BLOB.
+       * @param rowid Row of the value.
+       * @param writable Open for writing as well as reading.
+       * @param schema Attached database name, "main" by default.
+       * @return Stream positioned at the start of the value.
+       * @throws sdb::SqliteBlobException if the value cannot be opened.
+       */
+      SqliteBlobStream openBlob(const std::string& table, const std::string& column, std::int64_t rowid,
+                                bool writable = false, const std::string& schema = "main");
+
+      /**
+       * @brief Set the maximum number of idle statements kept by the cache.
+       * @param capacity Number of statements.  0 disables caching.
+       */
+      void setStatementCacheCapacity(std::size_t capacity);
+
+      /**
+       * @brief Retrieve the statement cache hit/miss counters.
+       * @return Snapshot of the cache statistics.
+       */
+      SqliteStatementCache::Stats getStatementCacheStats() const;
+
       /**
        * @brief Execute a SQL statement that does not return rows.
        * @param sql SQL command.
@@ -91,7 +509,8 @@ namespace sdb {
        * The function prepares the supplied SQL once and then binds/executes it for
        * every row contained in @p values.  This is noticeably faster than calling
        * execute() or prepare()/step()/finalize() in a loop because:
-       * - the statement is compiled only once
+       * - the statement is compiled only once, and taken from the statement
+       *   cache when the same SQL was batched before
        * - the statement is reset (instead of being finalized) between rows
        *
        * @note  No transaction boundary is created.  If you need atomicity or
@@ -99,6 +518,11 @@ namespace sdb {
        * For very large batches you can commit every N rows by splitting the vector
        * or by calling execute("COMMIT") / execute("BEGIN") between chunks.
        *
+       * Rows may also be tuples (`std::tuple`, `std::pair`, `std::array`) or
+       * aggregate structs.  Their fields are bound through `SqliteParameterTraits`
+       * selected at compile time, without building `SqliteValue`s, and the
+       * parameter count is checked once for the whole batch.
+       *
        * @param sql    SQL text containing placeholders (`?`, `?NNN`, `:name`, `@name`
        *               or `$name`).  Must be the same for every row.
        * @param values A vector where each inner vector contains the parameter values
@@ -116,9 +540,278 @@ namespace sdb {
         void executeBatch(const std::string& sql, Range&& rows);
 
       /**
-       * @brief Optimize the database by running the VACUUM command.
+       * @brief Execute a batch of parameter sets with multi-row VALUES and transactions.
+       *
+       * When @p sql is a single-row `INSERT ... VALUES (?, ?, ...)` using only
+       * anonymous `?` placeholders, it is rewritten into `VALUES (...), (...), ...`
+       * chunks holding as many rows as `SQLITE_LIMIT_VARIABLE_NUMBER` (or
+       * `BatchOptions::maxRowsPerStatement`) allows, so one VDBE run inserts
+       * many rows.  The full-size chunk statement is prepared once and reused;
+       * a shorter statement handles the remaining rows.  Any other SQL falls
+       * back to one execution per row.
+       *
+       * With `BatchOptions::useTransaction` the batch runs inside a
+       * `SqliteTransaction`, committed every `commitEvery` rows and at the end.
+       * On error the open transaction is rolled back; rows committed by earlier
+       * periodic commits stay committed.  Called inside a transaction the
+       * batch runs in a `SqliteSavepoint` instead: it is undone on error,
+       * `commitEvery` is ignored and committing is left to the caller.
+       *
+       * @param sql     SQL text with one set of placeholders.
+       * @param rows    Range of parameter sets, each a range of `SqliteValue`, a
+       *                tuple or an aggregate struct.  A range row with fewer
+       *                values binds NULL to the rest; one with more is rejected.
+       * @param options Batching and transaction options.
+       * @return Row, statement and commit counts plus elapsed time.
+       * @throw SqliteDbException, SqliteStatementException or SqliteTransactionException on failure.
+       */
+      template<std::ranges::input_range Range>
+        BatchStats executeBatch(const std::string& sql, Range&& rows, const BatchOptions& options);
+
+      /**
+       * @brief Register a C++ callable as a scalar SQL function.
+       *
+       * The arity and argument types are deduced from the callable's
+       * signature, so generic lambdas are not supported.  Arguments are
+       * decoded through `SqliteArgumentTraits`: `std::string_view` and
+       * `std::span<const std::byte>` read SQLite's buffers without copying,
+       * `std::optional<T>` sees NULL and `SqliteValue` keeps the dynamic
+       * type.  The result goes through `SqliteResultTraits`; `void` returns
+       * NULL.  An exception thrown by the callable becomes the SQL error of
+       * the statement.
+       *
+       * Example usage:
+       * @code
+       *   db->registerFunction("str_reverse", [](std::string_view text) {
+       *     return std::string(text.rbegin(), text.rend());
+       *   });
+       * @endcode
+       *
+       * @param name     SQL name; registering it again with the same arity replaces it.
+       * @param function Callable, copied into the connection.
+       * @throw SqliteDbException if SQLite rejects the registration.
+       */
+      template<typename F>
+        void registerFunction(const std::string& name, F&& function, const FunctionOptions& options);
+
+      /**
+       * @brief Register a deterministic scalar SQL function.
+       */
+      template<typename F>
+        void registerFunction(const std::string& name, F&& function);
+
+      /**
+       * @brief Register an aggregate SQL function from a step and a final callable.
+       *
+       * `step(State&, Args...)` folds one row into the group state and
+       * `final(State&)` returns the result.  `State` is deduced from the
+       * first parameter of @p step; it must be default-constructible and is
+       * built in place in `sqlite3_aggregate_context` memory on the group's
+       * first row, then destroyed after @p final.  A group without rows
+       * finishes from a default-constructed state.
+       *
+       * @throw SqliteDbException if SQLite rejects the registration.
+       */
+      template<typename Step, typename Final>
+        void registerAggregate(const std::string& name, Step&& step, Final&& final, const FunctionOptions& options);
+
+      /**
+       * @brief Register a deterministic aggregate SQL function.
+       */
+      template<typename Step, typename Final>
+        void registerAggregate(const std::string& name, Step&& step, Final&& final);
+
+      /**
+       * @brief Register an aggregate that can also run as an efficient window function.
+       *
+       * On top of the aggregate callables, `inverse(State&, Args...)` removes
+       * a row leaving the window frame and `value(const State&)` returns the
+       * result for the current frame, so SQLite slides the frame instead of
+       * recomputing it.
+       *
+       * @throw SqliteDbException if SQLite rejects the registration.
+       */
+      template<typename Step, typename Inverse, typename Value, typename Final>
+        void registerWindowFunction(const std::string& name, Step&& step, Inverse&& inverse, Value&& value,
+                                    Final&& final, const FunctionOptions& options);
+
+      /**
+       * @brief Register a deterministic window function.
+       */
+      template<typename Step, typename Inverse, typename Value, typename Final>
+        void registerWindowFunction(const std::string& name, Step&& step, Inverse&& inverse, Value&& value, Final&& final);
+
+      /**
+       * @brief Remove the SQL function @p name taking @p arity arguments.
+       */
+      void removeFunction(const std::string& name, int arity);
+
+      /**
+       * @brief Expose a random-access range of rows as an eponymous virtual table.
+       *
+       * Elements are tuple-like or aggregate structs; each field is a column
+       * whose declared type follows the field type, and the rowid is the
+       * element's position.  The table name is usable right away in any
+       * query, `SELECT * FROM name`, with no copy of the data: lvalue ranges
+       * are referenced and must outlive the registration unchanged, views
+       * are copied and rvalue containers are moved in.  The table is
+       * read-only.
+       *
+       * Constraints are pushed down: rowid constraints and constraints on
+       * the `sortedBy` column select a slice, the latter by binary search,
+       * and the rest are evaluated by the cursor before SQLite sees the row.
+       *
+       * @param name    Module and table name; registering it again replaces it.
+       * @param range   Rows to expose.
+       * @param columns Column names, one per field; empty names them c1, c2, ...
+       * @throw SqliteDbException if the names do not match the fields, the
+       *        `sortedBy` column cannot be a key, or SQLite rejects the module.
+       */
+      template<std::ranges::random_access_range Range>
+        requires std::ranges::sized_range<Range> && std::ranges::viewable_range<Range>
+        void registerRangeTable(const std::string& name, Range&& range, std::vector<std::string> columns,
+                                const RangeTableOptions& options);
+
+      /**
+       * @brief Expose @p range as an eponymous virtual table without a sort key.
+       */
+      template<std::ranges::random_access_range Range>
+        requires std::ranges::sized_range<Range> && std::ranges::viewable_range<Range>
+        void registerRangeTable(const std::string& name, Range&& range, std::vector<std::string> columns = { });
+
+      /**
+       * @brief Bulk load a CSV file into @p table.
+       *
+       * The file is memory-mapped and parsed on a worker thread into batches
+       * of fields that point into the mapping, so no per-row value is
+       * allocated.  Batches cross a bounded queue to the calling thread,
+       * which inserts them through the multi-row executeBatch() path inside
+       * transactions committed every `commitEvery` rows: parsing and
+       * inserting overlap.  Fields are bound as text and converted by the
+       * column affinity.  On error the open transaction is rolled back; rows
+       * committed earlier stay committed.  Called inside a transaction the
+       * import runs in a `SqliteSavepoint`, undone on error, and committing
+       * is left to the caller.
+       *
+       * @throw SqliteDbException on I/O or parse errors, or any exception of
+       *        executeBatch() and SqliteTransaction.
+       */
+      ImportStats importCsv(const std::filesystem::path& path, const std::string& table, const ImportOptions& options);
+
+      /**
+       * @brief Bulk load a CSV file with default options.
+       */
+      ImportStats importCsv(const std::filesystem::path& path, const std::string& table);
+
+      /**
+       * @brief Bulk load newline-delimited JSON objects into @p table.
+       *
+       * Same pipeline as importCsv().  Each line holds one object; keys map
+       * to columns and missing keys insert NULL.  Strings bind as text,
+       * integers and reals as numbers, booleans as 1/0, and nested objects
+       * or arrays as their JSON text.
+       */
+      ImportStats importNdjson(const std::filesystem::path& path, const std::string& table, const ImportOptions& options);
+
+      /**
+       * @brief Bulk load an NDJSON file with default options.
+       */
+      ImportStats importNdjson(const std::filesystem::path& path, const std::string& table);
+
+      /**
+       * @brief Refresh planner statistics with `PRAGMA optimize`.
+       *
+       * Only tables whose statistics are missing or stale are analyzed, and
+       * `PRAGMA analysis_limit` bounds the rows each ANALYZE looks at, so
+       * the call is cheap enough to run often.  The file is not rewritten;
+       * use vacuum() for that.  The connection's own analysis_limit is
+       * restored afterwards.
+       *
+       * @param analysisLimit Approximate rows examined per index; 0 means no limit.
+       * @return The tables that were re-analyzed.
+       */
+      OptimizeReport optimize(int analysisLimit = 400);
+
+      /**
+       * @brief Run ANALYZE on every table, or on @p table only.
+       * @param table Table or index name; empty analyzes the whole database.
+       */
+      void analyze(const std::string& table = "");
+
+      /**
+       * @brief Rebuild the database file with a full, blocking `VACUUM`.
+       */
+      void vacuum();
+
+      /**
+       * @brief Schedule optimize() on close and/or on a timer.
+       *
+       * The timer thread uses this connection and skips a run while a
+       * transaction is open on it, so a thread-confined connection only
+       * accepts `optimizeOnClose`.  Replaces earlier maintenance settings.
+       */
+      void setMaintenance(MaintenanceOptions options);
+
+      /**
+       * @brief Copy this live database into @p target with the online backup API.
+       *
+       * Pages are copied in steps of `pagesPerStep`, sleeping `sleepBetween`
+       * between steps without holding the source lock, so writers keep
+       * going.  A write through another connection restarts the copy; a
+       * write through this one is applied to the copy as well.  Every page of
+       * @p target is overwritten.
+       *
+       * @throws sdb::SqliteDbException if the backup fails or is cancelled.
+       */
+      void backupTo(SqliteDb& target, const BackupOptions& options);
+
+      /**
+       * @brief Back up into @p target with default options.
+       */
+      void backupTo(SqliteDb& target);
+
+      /**
+       * @brief Back up into the database file at @p target, created if missing.
+       */
+      void backupTo(const std::filesystem::path& target, const BackupOptions& options);
+
+      /**
+       * @brief Write a compacted copy of the database to a new file with `VACUUM INTO`.
+       *
+       * Unlike backupTo() the copy is vacuumed, but it is produced by a
+       * single statement that holds a read transaction until it is done.
+       *
+       * @param target File to create; it must not exist or be empty.
        */
-      void optimize();
+      void vacuumInto(const std::filesystem::path& target);
+
+      /**
+       * @brief Set `PRAGMA auto_vacuum`.
+       *
+       * Switching between NONE and FULL or INCREMENTAL on an existing
+       * database only takes effect after a `VACUUM`.
+       */
+      void setAutoVacuum(AutoVacuum mode);
+
+      /**
+       * @brief Return up to @p pages free pages to the file system (`PRAGMA incremental_vacuum`).
+       *
+       * A no-op unless the file already is in `AutoVacuum::INCREMENTAL`
+       * mode: setAutoVacuum() alone does not convert an existing database,
+       * that takes a vacuum() afterwards.  The returned count then does not
+       * shrink, so loops should stop once it no longer drops.  Calling it
+       * repeatedly with a small @p pages reclaims space in bounded slices
+       * instead of one blocking VACUUM.
+       *
+       * @param pages Maximum pages to free; 0 frees all of them.
+       * @return Free pages left afterwards.
+       */
+      std::int64_t incrementalVacuum(int pages);
+
+      /**
+       * @brief Number of unused pages in the database file (`PRAGMA freelist_count`).
+       */
+      std::int64_t getFreelistCount();
 
       /**
        * @brief Enable or disable foreign key constraint enforcement.
@@ -150,14 +843,313 @@ namespace sdb {
        */
       void setCacheSize(std::size_t sizeKb);
 
+      /**
+       * @brief Apply every option set in @p tuning to this connection.
+       *
+       * Lookaside is configured first, while no lookaside memory is in use,
+       * then the page size since it cannot change once the database is in
+       * WAL mode.
+       *
+       * @throws sdb::SqliteDbException if a pragma fails.
+       * @throws std::invalid_argument if a tuning value is out of range; nothing
+       *         is applied then.
+       */
+      void applyTuning(const Tuning& tuning);
+
+      /**
+       * @brief Set how long a locked database is retried before SQLITE_BUSY.
+       * @param timeout Busy timeout; 0 disables retries.
+       */
+      void setBusyTimeout(std::chrono::milliseconds timeout);
+
+      /**
+       * @brief Exponential backoff used while a database is locked.
+       */
+      struct BusyRetry {
+        /** Sleep before the first retry. */
+        std::chrono::microseconds initialDelay { 100 };
+        /** Upper bound on a single sleep. */
+        std::chrono::microseconds maxDelay { 20000 };
+        /** Growth factor of the sleep between retries. */
+        double multiplier = 2.0;
+        /** Give up with SQLITE_BUSY once this much time has passed. */
+        std::chrono::milliseconds timeout { 5000 };
+        /** Sleep a random duration in [delay / 2, delay] so that contending
+         *  connections do not retry in lockstep. */
+        bool jitter = true;
+      };
+
+      /**
+       * @brief Retry a locked database with exponential backoff instead of
+       *        the fixed polling of setBusyTimeout().
+       *
+       * Replaces any busy timeout; a later setBusyTimeout() replaces this.
+       *
+       * @throws std::invalid_argument if a delay is negative or the multiplier is below 1.
+       */
+      void setBusyRetry(const BusyRetry& retry);
+
+      /**
+       * @brief Run a WAL checkpoint on the main database.
+       *
+       * PASSIVE never waits; the other modes wait on readers and writers
+       * through the busy timeout.  Being blocked is reported through
+       * `CheckpointResult::busy` instead of an exception.
+       *
+       * @param mode Checkpoint mode.
+       * @throws sdb::SqliteDbException if the checkpoint fails for another reason.
+       */
+      CheckpointResult checkpoint(CheckpointMode mode = CheckpointMode::PASSIVE);
+
+      /**
+       * @brief Start collecting per-statement statistics with default options.
+       */
+      void enableProfiling();
+
+      /**
+       * @brief Start collecting per-statement statistics.
+       *
+       * Replaces any profiler already installed, discarding its statistics.
+       * Statistics are read through getProfiler().
+       */
+      void enableProfiling(SqliteProfiler::Options options);
+
+      /**
+       * @brief Remove the profiler and its trace callback.
+       */
+      void disableProfiling();
+
+      /**
+       * @brief Installed profiler, or nullptr if profiling is disabled.
+       */
+      SqliteProfiler* getProfiler() noexcept;
+
+      /**
+       * @brief Flag statements that scan full tables, with default settings.
+       */
+      void enableScanDetection();
+
+      /**
+       * @brief Flag statements that scan full tables or build automatic indexes.
+       *
+       * Meant for development and staging: when a statement finishes, its
+       * `SQLITE_STMTSTATUS_FULLSCAN_STEP` and `SQLITE_STMTSTATUS_AUTOINDEX`
+       * counters are checked and executions that climbed past the thresholds
+       * are reported, which usually points at a missing index.  Use
+       * `SqliteStatement::explainPlan()` on the reported SQL for details.
+       */
+      void enableScanDetection(ScanDetection options);
+
+      /**
+       * @brief Stop flagging statements and drop the collected reports.
+       */
+      void disableScanDetection();
+
+      /**
+       * @brief Executions flagged since scan detection was enabled.
+       */
+      std::vector<ScanReport> getScanReports() const;
+
+      /**
+       * @brief Forward the update, commit and rollback hooks to @p listener.
+       *
+       * The hooks are only registered with SQLite while at least one listener
+       * is installed.  Listeners are not owned and must be removed before
+       * they are destroyed; add and remove them while no statement runs.
+       * An exception thrown by a callback is caught and dropped so that it
+       * never unwinds through SQLite; the other listeners are still called.
+       */
+      void addChangeListener(SqliteChangeListener& listener);
+
+      /**
+       * @brief Stop forwarding hooks to @p listener.  Unknown listeners are ignored.
+       */
+      void removeChangeListener(SqliteChangeListener& listener);
+
+      /**
+       * @brief Decides, while a statement is prepared, whether an action is
+       *        allowed: returns SQLITE_OK, SQLITE_DENY or SQLITE_IGNORE.
+       *
+       * Receives the arguments of `sqlite3_set_authorizer()`; any of the
+       * names may be null.  An exception counts as SQLITE_DENY.
+       */
+      using Authorizer = std::function<int(int action, const char* first, const char* second, const char* schema,
+                                           const char* trigger)>;
+
+      /**
+       * @brief Install @p authorizer for every later prepare; an empty one removes it.
+       *
+       * Use this rather than `sqlite3_set_authorizer()` on the handle: the
+       * result cache installs its own authorizer while planning a query and
+       * chains to this one.
+       */
+      void setAuthorizer(Authorizer authorizer);
+
+      /**
+       * @brief Whether the library was built with SQLITE_ENABLE_PREUPDATE_HOOK,
+       *        i.e. `SqliteChangeListener::onPreUpdate()` is called.
+       */
+      static bool hasPreUpdateHook() noexcept;
+
+      /**
+       * @brief Stream committed row changes to @p consumer with default options.
+       */
+      void enableChangeCapture(SqliteChangeCapture::Consumer consumer);
+
+      /**
+       * @brief Stream committed row changes to @p consumer on a dedicated thread.
+       *
+       * Replaces any change capture already installed, after delivering
+       * what it had published.  The consumer must not use this connection;
+       * calls that lock it throw on the consumer thread.
+       *
+       * @throws std::invalid_argument if @p consumer is empty.
+       */
+      void enableChangeCapture(SqliteChangeCapture::Consumer consumer, SqliteChangeCapture::Options options);
+
+      /**
+       * @brief Deliver the published changes, then remove the change capture.
+       *        Changes of a transaction still open are dropped.
+       */
+      void disableChangeCapture();
+
+      /**
+       * @brief Installed change capture, or nullptr if disabled.
+       */
+      SqliteChangeCapture* getChangeCapture() noexcept;
+
+      /**
+       * @brief Start caching cachedQuery() results with default options.
+       */
+      void enableResultCache();
+
+      /**
+       * @brief Start caching cachedQuery() results.
+       *
+       * Replaces any result cache already installed, discarding its entries.
+       */
+      void enableResultCache(SqliteResultCache::Options options);
+
+      /**
+       * @brief Remove the result cache and its change listener.
+       */
+      void disableResultCache();
+
+      /**
+       * @brief Installed result cache, or nullptr if disabled.
+       */
+      SqliteResultCache* getResultCache() noexcept;
+
+      /**
+       * @brief Run a read-only query, or serve it from the result cache.
+       *
+       * @param sql SELECT (or other read-only) statement.
+       * @throws sdb::SqliteDbException if no result cache is enabled or the
+       *         statement cannot be prepared.
+       * @throws sdb::SqliteStatementException if the statement writes.
+       */
+      SqliteCachedResult cachedQuery(const std::string& sql);
+
+      /**
+       * @brief Like cachedQuery(const std::string&) with @p parameters bound
+       *        in order; they are part of the cache key.
+       */
+      SqliteCachedResult cachedQuery(const std::string& sql, const std::vector<SqliteValue>& parameters);
+
     private:
+      static constexpr std::size_t DEFAULT_STATEMENT_CACHE_CAPACITY = 32;
+
       SqliteConnectionPtr mConnection;
       std::mutex mMutex;
+      bool mThreadConfined = false;
+      SqliteStatementCache mStatementCache;
+      std::size_t mSavepointDepth = 0;
+      std::unique_ptr<SqliteProfiler> mProfiler;
+
+      struct ScanDetector {
+        ScanDetection options;
+        mutable std::mutex mutex;
+        std::vector<ScanReport> reports;
+        std::unordered_set<std::string> reported;
+      };
+
+      std::unique_ptr<ScanDetector> mScanDetector;
+      std::vector<SqliteChangeListener*> mChangeListeners;
+      Authorizer mAuthorizer;
+      std::unique_ptr<SqliteResultCache> mResultCache;
+      std::unique_ptr<SqliteChangeCapture> mChangeCapture;
+
+      struct BusyRetryState {
+        BusyRetry retry;
+        std::chrono::steady_clock::time_point since;
+        std::uint64_t seed;
+      };
+
+      std::unique_ptr<BusyRetryState> mBusyRetry;
+
+      MaintenanceOptions mMaintenance;
+      std::mutex mMaintenanceMutex;
+      std::condition_variable mMaintenanceWake;
+      bool mMaintenanceStopping = false;
+      std::thread mMaintenanceThread;
+
+      /**
+       * @brief `INSERT ... VALUES` statement split around its single row tuple.
+       */
+      struct MultiRowInsert {
+        std::string prefix;
+        std::string tuple;
+
+        std::string build(std::size_t rows) const;
+      };
 
       explicit SqliteDb(SqliteConnectionPtr connection);
       void checkConnection() const;
+      std::unique_lock<std::mutex> lockConnection();
+      void executeCached(const std::string& sql);
+      SqliteStatement prepareUnlocked(const std::string& sql);
+      void executeUnlocked(const std::string& sql);
+      OptimizeReport optimizeUnlocked(int analysisLimit);
+      OptimizeReport optimizeWithLimit();
+      void updateTraceHook();
+      static int dispatchTrace(unsigned type, void* context, void* p, void* x);
+      void updateChangeHooks();
+      /** Unhook the change capture without locking and hand it to the caller. */
+      std::unique_ptr<SqliteChangeCapture> detachChangeCapture();
+      static void dispatchUpdate(void* context, int type, const char* schema, const char* table, sqlite3_int64 rowid);
+      static int dispatchCommit(void* context);
+      static void dispatchRollback(void* context);
+      static void dispatchPreUpdate(void* context, sqlite3* connection, int type, const char* schema,
+                                    const char* table, sqlite3_int64 oldRowid, sqlite3_int64 newRowid);
+      static int dispatchBusy(void* context, int count);
+      void updateAuthorizer();
+      static int dispatchAuthorizer(void* context, int action, const char* first, const char* second,
+                                    const char* schema, const char* trigger);
+      void stopMaintenanceThread();
+      void runMaintenance(const MaintenanceOptions& options);
+      void reportScan(sqlite3_stmt* stmt, const SqliteProfiler::Counters& counters);
+      static std::optional<MultiRowInsert> parseMultiRowInsert(const std::string& sql, int parameterCount);
+      std::size_t getBatchChunkRows(int parameterCount, const BatchOptions& options) const;
+      void createModule(const std::string& name, const sqlite3_module* module, void* data, void (*destroy)(void*));
+      void createFunction(const std::string& name, int arity, const FunctionOptions& options, void* function,
+                          void (*call)(sqlite3_context*, int, sqlite3_value**),
+                          void (*step)(sqlite3_context*, int, sqlite3_value**),
+                          void (*final)(sqlite3_context*),
+                          void (*value)(sqlite3_context*),
+                          void (*inverse)(sqlite3_context*, int, sqlite3_value**),
+                          void (*destroy)(void*));
+      ImportStats runImport(const std::filesystem::path& path, const std::string& table,
+                            const ImportOptions& options, bool json);
+
+      template<typename Row>
+        static void checkBatchRow(int parameterCount);
+      template<typename Row>
+        static void bindBatchRow(SqliteStatement& stmt, int firstIndex, const Row& row, int parameterCount);
 
+      friend class SqliteCheckpointer;
       friend class SqliteTransaction;
+      friend class SqliteSavepoint;
+      friend class SqliteResultCache;
   };
 
   template<std::ranges::input_range Range>
@@ -169,17 +1161,266 @@ namespace sdb {
         throw SqliteDbException("Database not open");
       }
 
-      auto stmt = prepare(sql);
-      SqliteValueBinder binder(stmt);
+      auto cached = cachedPrepare(sql);
+      auto& stmt = cached.get();
+
+      using Row = std::remove_cvref_t<std::ranges::range_reference_t<Range>>;
+      const int parameterCount = stmt.getParameterCount();
+      checkBatchRow<Row>(parameterCount);
 
       for (auto&& row : std::forward<Range>(rows)) {
-        std::size_t idx = 1;
-        for (const auto& v : row) {
-          binder.bind(static_cast<int>(idx++), v);
+        bindBatchRow(stmt, 1, row, parameterCount);
+        stmt.step();
+        stmt.reset();
+        if constexpr (!SqliteFieldRow<Row>) {
+          stmt.clearBindings();
+        }
+      }
+  }
+
+  template<std::ranges::input_range Range>
+  SqliteDb::BatchStats SqliteDb::executeBatch(const std::string& sql, Range&& rows, const BatchOptions& options) {
+      checkConnection();
+
+      const auto start = std::chrono::steady_clock::now();
+      BatchStats stats;
+
+      auto single = cachedPrepare(sql);
+      const int parameterCount = single->getParameterCount();
+
+      using Row = std::remove_cvref_t<std::ranges::range_reference_t<Range>>;
+      checkBatchRow<Row>(parameterCount);
+
+      std::optional<MultiRowInsert> insert;
+      std::size_t chunkRows = 1;
+      if (options.multiRowValues && parameterCount > 0) {
+        insert = parseMultiRowInsert(sql, parameterCount);
+        chunkRows = insert ? getBatchChunkRows(parameterCount, options) : 1;
+        if (chunkRows < 2) {
+          insert.reset();
+          chunkRows = 1;
+        }
+      }
+      stats.rowsPerStatement = chunkRows;
+
+      // Periodic commits would also commit the work of an enclosing transaction
+      std::optional<SqliteTransaction> transaction;
+      std::optional<SqliteSavepoint> savepoint;
+      if (options.useTransaction && isInTransaction()) {
+        savepoint.emplace(*this);
+      } else if (options.useTransaction) {
+        transaction.emplace(*this, options.transactionMode);
+      }
+
+      std::size_t rowsSinceCommit = 0;
+      auto rowsDone = [&](std::size_t count) {
+        stats.rows += count;
+        ++stats.statements;
+        rowsSinceCommit += count;
+        if (transaction && options.commitEvery > 0 && rowsSinceCommit >= options.commitEvery) {
+          transaction->commit();
+          ++stats.commits;
+          transaction.emplace(*this, options.transactionMode);
+          rowsSinceCommit = 0;
+        }
+      };
+
+      // Rows of a chunk are kept until the chunk is full.  Elements of a
+      // container are referenced in place, anything else is copied.
+      using Reference = std::ranges::range_reference_t<Range>;
+      constexpr bool byPointer = std::is_lvalue_reference_v<Reference> && std::ranges::forward_range<Range>;
+      using Slot = std::conditional_t<byPointer, std::remove_reference_t<Reference>*, std::ranges::range_value_t<Range>>;
+
+      std::vector<Slot> pending;
+      std::optional<SqliteCachedStatement> chunk;
+      if (insert) {
+        pending.reserve(chunkRows);
+        chunk.emplace(cachedPrepare(insert->build(chunkRows)));
+      }
+
+      auto flush = [&](SqliteStatement& stmt) {
+        int index = 1;
+        for (const auto& slot : pending) {
+          if constexpr (byPointer) {
+            bindBatchRow(stmt, index, *slot, parameterCount);
+          } else {
+            bindBatchRow(stmt, index, slot, parameterCount);
+          }
+          index += parameterCount;
         }
         stmt.step();
         stmt.reset();
-        stmt.clearBindings();
+        // A short row of the next chunk must bind NULL, as on the per-row path
+        if constexpr (!SqliteFieldRow<Row>) {
+          stmt.clearBindings();
+        }
+        std::size_t count = pending.size();
+        pending.clear();
+        rowsDone(count);
+      };
+
+      for (auto&& row : std::forward<Range>(rows)) {
+        if (!chunk) {
+          bindBatchRow(single.get(), 1, row, parameterCount);
+          single->step();
+          single->reset();
+          if constexpr (!SqliteFieldRow<Row>) {
+            single->clearBindings();
+          }
+          rowsDone(1);
+          continue;
+        }
+
+        if constexpr (byPointer) {
+          pending.push_back(&row);
+        } else {
+          pending.push_back(row);
+        }
+
+        if (pending.size() == chunkRows) {
+          flush(chunk->get());
+        }
+      }
+
+      if (!pending.empty()) {
+        auto tail = prepare(insert->build(pending.size()));
+        flush(tail);
+      }
+
+      if (transaction) {
+        transaction->commit();
+        ++stats.commits;
+      }
+      if (savepoint) {
+        savepoint->release();
+      }
+
+      stats.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+      return stats;
+  }
+
+  template<typename F>
+  void SqliteDb::registerFunction(const std::string& name, F&& function, const FunctionOptions& options) {
+      using Function = detail::ScalarFunction<std::decay_t<F>>;
+      constexpr int arity = static_cast<int>(std::tuple_size_v<typename Function::Arguments>);
+
+      checkConnection();
+      auto holder = std::make_unique<Function>(Function { std::forward<F>(function) });
+      createFunction(name, arity, options, holder.release(), &Function::call, nullptr, nullptr, nullptr, nullptr,
+                     &detail::deleteFunction<Function>);
+  }
+
+  template<typename F>
+  void SqliteDb::registerFunction(const std::string& name, F&& function) {
+      registerFunction(name, std::forward<F>(function), FunctionOptions { });
+  }
+
+  template<typename Step, typename Final>
+  void SqliteDb::registerAggregate(const std::string& name, Step&& step, Final&& final, const FunctionOptions& options) {
+      using Function = detail::AggregateFunction<std::decay_t<Step>, std::decay_t<Final>>;
+      constexpr int arity = static_cast<int>(std::tuple_size_v<typename Function::Arguments>);
+
+      checkConnection();
+      auto holder = std::make_unique<Function>(Function { std::forward<Step>(step), std::forward<Final>(final) });
+      createFunction(name, arity, options, holder.release(), nullptr, &Function::callStep, &Function::callFinal,
+                     nullptr, nullptr, &detail::deleteFunction<Function>);
+  }
+
+  template<typename Step, typename Final>
+  void SqliteDb::registerAggregate(const std::string& name, Step&& step, Final&& final) {
+      registerAggregate(name, std::forward<Step>(step), std::forward<Final>(final), FunctionOptions { });
+  }
+
+  template<typename Step, typename Inverse, typename Value, typename Final>
+  void SqliteDb::registerWindowFunction(const std::string& name, Step&& step, Inverse&& inverse, Value&& value,
+                                        Final&& final, const FunctionOptions& options) {
+      using Function = detail::WindowFunction<std::decay_t<Step>, std::decay_t<Inverse>, std::decay_t<Value>, std::decay_t<Final>>;
+      constexpr int arity = static_cast<int>(std::tuple_size_v<typename Function::Arguments>);
+
+      checkConnection();
+      auto holder = std::make_unique<Function>(Function { std::forward<Step>(step), std::forward<Inverse>(inverse),
+                                                          std::forward<Value>(value), std::forward<Final>(final) });
+      createFunction(name, arity, options, holder.release(), nullptr, &Function::callStep, &Function::callFinal,
+                     &Function::callValue, &Function::callInverse, &detail::deleteFunction<Function>);
+  }
+
+  template<typename Step, typename Inverse, typename Value, typename Final>
+  void SqliteDb::registerWindowFunction(const std::string& name, Step&& step, Inverse&& inverse, Value&& value, Final&& final) {
+      registerWindowFunction(name, std::forward<Step>(step), std::forward<Inverse>(inverse), std::forward<Value>(value),
+                             std::forward<Final>(final), FunctionOptions { });
+  }
+
+  template<std::ranges::random_access_range Range>
+    requires std::ranges::sized_range<Range> && std::ranges::viewable_range<Range>
+  void SqliteDb::registerRangeTable(const std::string& name, Range&& range, std::vector<std::string> columns,
+                                    const RangeTableOptions& options) {
+      using Module = detail::SqliteRangeModule<std::views::all_t<Range>>;
+
+      checkConnection();
+      if (columns.empty()) {
+        for (std::size_t i = 0; i < Module::COLUMN_COUNT; ++i) {
+          columns.push_back("c" + std::to_string(i + 1));
+        }
+      }
+      if (columns.size() != Module::COLUMN_COUNT) {
+        throw SqliteDbException(
+            "Range table " + name + " has " + std::to_string(Module::COLUMN_COUNT) + " fields, got "
+                + std::to_string(columns.size()) + " column names");
+      }
+      if (options.sortedBy && !Module::isKeyColumn(*options.sortedBy)) {
+        throw SqliteDbException("Range table " + name + " cannot be sorted by column " + std::to_string(*options.sortedBy));
+      }
+
+      auto module = std::make_unique<Module>(std::views::all(std::forward<Range>(range)), std::move(columns), options.sortedBy);
+      createModule(name, Module::getModule(), module.release(), &detail::deleteFunction<Module>);
+  }
+
+  template<std::ranges::random_access_range Range>
+    requires std::ranges::sized_range<Range> && std::ranges::viewable_range<Range>
+  void SqliteDb::registerRangeTable(const std::string& name, Range&& range, std::vector<std::string> columns) {
+      registerRangeTable(name, std::forward<Range>(range), std::move(columns), RangeTableOptions { });
+  }
+
+  template<typename Row>
+  void SqliteDb::checkBatchRow(int parameterCount) {
+      if constexpr (SqliteFieldRow<Row>) {
+        constexpr std::size_t fieldCount = sqliteRowFieldCount<Row>();
+        if (fieldCount != static_cast<std::size_t>(parameterCount)) {
+          throw SqliteDbException(
+              "Batch rows have " + std::to_string(fieldCount) + " fields, statement expects "
+                  + std::to_string(parameterCount) + " parameters");
+        }
+      }
+  }
+
+  template<typename Row>
+  void SqliteDb::bindBatchRow(SqliteStatement& stmt, int firstIndex, const Row& row, int parameterCount) {
+      if constexpr (SqliteFieldRow<Row>) {
+        stmt.bindFields(firstIndex, row);
+      } else {
+        // In a multi-row chunk a long row would bind into the next row's parameters
+        if (static_cast<std::size_t>(std::ranges::distance(row)) > static_cast<std::size_t>(parameterCount)) {
+          throw SqliteDbException("Batch row has " + std::to_string(std::ranges::distance(row))
+                                  + " values, statement expects " + std::to_string(parameterCount) + " parameters");
+        }
+        using Value = std::remove_cvref_t<std::ranges::range_reference_t<const Row&>>;
+        if constexpr (SqliteBindable<Value> && !std::is_same_v<Value, SqliteValue>) {
+          // Views and static text bind straight through the traits
+          sqlite3_stmt* handle = stmt.mStatement.get();
+          int index = firstIndex;
+          for (const auto& v : row) {
+            if (SqliteParameterTraits<Value>::bind(handle, index, v) != SQLITE_OK) {
+              throw SqliteStatementException("Failed to bind parameter at index " + std::to_string(index));
+            }
+            ++index;
+          }
+        } else {
+          SqliteValueBinder binder(stmt);
+          int index = firstIndex;
+          for (const auto& v : row) {
+            binder.bind(index++, v);
+          }
+        }
       }
   }
 
@@ -33,6 +33,11 @@ namespace sdb {
       using SqliteException::SqliteException;
   };
 
+  class SqliteBlobException : public SqliteException {
+    public:
+      using SqliteException::SqliteException;
+  };
+
 }
 
 #endif /* INCLUDE_SQLITEEXCEPTION_HPP_ */
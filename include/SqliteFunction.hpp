@@ -0,0 +1,499 @@
+#ifndef INCLUDE_SQLITEFUNCTION_HPP_
+#define INCLUDE_SQLITEFUNCTION_HPP_
+
+/**
+ * @file SqliteFunction.hpp
+ * @brief Adapters exposing C++ callables as SQL scalar, aggregate and window functions.
+ *
+ * `SqliteArgumentTraits` decodes function arguments and
+ * `SqliteResultTraits` sets the function result; the trampolines in
+ * `detail` deduce the arity from the callable's signature and translate
+ * C++ exceptions into SQL errors.
+ */
+
+#include "../sqlite/sqlite3.h"
+#include <SqliteTypes.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <new>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace sdb {
+
+  template<typename T>
+  struct SqliteArgumentTraits;
+
+  template<>
+  struct SqliteArgumentTraits<int> {
+    static int read(sqlite3_value* value) {
+      return sqlite3_value_int(value);
+    }
+  };
+
+  template<>
+  struct SqliteArgumentTraits<std::int64_t> {
+    static std::int64_t read(sqlite3_value* value) {
+      return sqlite3_value_int64(value);
+    }
+  };
+
+  template<>
+  struct SqliteArgumentTraits<double> {
+    static double read(sqlite3_value* value) {
+      return sqlite3_value_double(value);
+    }
+  };
+
+  template<>
+  struct SqliteArgumentTraits<bool> {
+    static bool read(sqlite3_value* value) {
+      return sqlite3_value_int64(value) != 0;
+    }
+  };
+
+  /**
+   * @brief Text view into SQLite's argument buffer, valid until the function returns.
+   */
+  template<>
+  struct SqliteArgumentTraits<std::string_view> {
+    static std::string_view read(sqlite3_value* value) {
+      const unsigned char* text = sqlite3_value_text(value);
+      if (!text) {
+        return { };
+      }
+      return std::string_view(reinterpret_cast<const char*>(text), static_cast<std::size_t>(sqlite3_value_bytes(value)));
+    }
+  };
+
+  template<>
+  struct SqliteArgumentTraits<std::string> {
+    static std::string read(sqlite3_value* value) {
+      return std::string(SqliteArgumentTraits<std::string_view>::read(value));
+    }
+  };
+
+  /**
+   * @brief Blob span over SQLite's argument buffer, valid until the function returns.
+   */
+  template<>
+  struct SqliteArgumentTraits<std::span<const std::byte>> {
+    static std::span<const std::byte> read(sqlite3_value* value) {
+      const std::byte* data = reinterpret_cast<const std::byte*>(sqlite3_value_blob(value));
+      if (!data) {
+        return { };
+      }
+      return std::span<const std::byte>(data, static_cast<std::size_t>(sqlite3_value_bytes(value)));
+    }
+  };
+
+  template<>
+  struct SqliteArgumentTraits<std::vector<std::byte>> {
+    static std::vector<std::byte> read(sqlite3_value* value) {
+      auto blob = SqliteArgumentTraits<std::span<const std::byte>>::read(value);
+      return std::vector<std::byte>(blob.begin(), blob.end());
+    }
+  };
+
+  /**
+   * @brief NULL maps to an empty optional, anything else to the wrapped type.
+   */
+  template<typename T>
+  struct SqliteArgumentTraits<std::optional<T>> {
+    static std::optional<T> read(sqlite3_value* value) {
+      if (sqlite3_value_type(value) == SQLITE_NULL) {
+        return std::nullopt;
+      }
+      return SqliteArgumentTraits<T>::read(value);
+    }
+  };
+
+  /**
+   * @brief The argument with its dynamic type.
+   */
+  template<>
+  struct SqliteArgumentTraits<SqliteValue> {
+    static SqliteValue read(sqlite3_value* value) {
+      switch (sqlite3_value_type(value)) {
+        case SQLITE_INTEGER:
+          return sqlite3_value_int64(value);
+        case SQLITE_FLOAT:
+          return sqlite3_value_double(value);
+        case SQLITE_TEXT:
+          return SqliteArgumentTraits<std::string>::read(value);
+        case SQLITE_BLOB:
+          return SqliteArgumentTraits<std::vector<std::byte>>::read(value);
+        default:
+          return std::monostate { };
+      }
+    }
+  };
+
+  template<typename T>
+  struct SqliteResultTraits;
+
+  template<>
+  struct SqliteResultTraits<int> {
+    static void set(sqlite3_context* context, int value) {
+      sqlite3_result_int(context, value);
+    }
+  };
+
+  template<>
+  struct SqliteResultTraits<std::int64_t> {
+    static void set(sqlite3_context* context, std::int64_t value) {
+      sqlite3_result_int64(context, value);
+    }
+  };
+
+  template<>
+  struct SqliteResultTraits<double> {
+    static void set(sqlite3_context* context, double value) {
+      sqlite3_result_double(context, value);
+    }
+  };
+
+  template<>
+  struct SqliteResultTraits<bool> {
+    static void set(sqlite3_context* context, bool value) {
+      sqlite3_result_int(context, value ? 1 : 0);
+    }
+  };
+
+  template<>
+  struct SqliteResultTraits<std::string_view> {
+    static void set(sqlite3_context* context, std::string_view value) {
+      const char* text = value.data() ? value.data() : "";
+      sqlite3_result_text64(context, text, value.size(), SQLITE_TRANSIENT, SQLITE_UTF8);
+    }
+  };
+
+  template<>
+  struct SqliteResultTraits<std::string> {
+    static void set(sqlite3_context* context, const std::string& value) {
+      SqliteResultTraits<std::string_view>::set(context, value);
+    }
+  };
+
+  template<>
+  struct SqliteResultTraits<const char*> {
+    static void set(sqlite3_context* context, const char* value) {
+      sqlite3_result_text(context, value, -1, SQLITE_TRANSIENT);
+    }
+  };
+
+  template<>
+  struct SqliteResultTraits<std::span<const std::byte>> {
+    static void set(sqlite3_context* context, std::span<const std::byte> value) {
+      sqlite3_result_blob64(context, value.data(), value.size(), SQLITE_TRANSIENT);
+    }
+  };
+
+  template<>
+  struct SqliteResultTraits<std::vector<std::byte>> {
+    static void set(sqlite3_context* context, const std::vector<std::byte>& value) {
+      SqliteResultTraits<std::span<const std::byte>>::set(context, value);
+    }
+  };
+
+  template<>
+  struct SqliteResultTraits<std::nullptr_t> {
+    static void set(sqlite3_context* context, std::nullptr_t) {
+      sqlite3_result_null(context);
+    }
+  };
+
+  template<>
+  struct SqliteResultTraits<std::monostate> {
+    static void set(sqlite3_context* context, std::monostate) {
+      sqlite3_result_null(context);
+    }
+  };
+
+  /**
+   * @brief An empty optional returns NULL.
+   */
+  template<typename T>
+  struct SqliteResultTraits<std::optional<T>> {
+    static void set(sqlite3_context* context, const std::optional<T>& value) {
+      if (value) {
+        SqliteResultTraits<T>::set(context, *value);
+      } else {
+        sqlite3_result_null(context);
+      }
+    }
+  };
+
+  /**
+   * @brief Variants, `SqliteValue` among them, return their active alternative.
+   */
+  template<typename... Ts>
+  struct SqliteResultTraits<std::variant<Ts...>> {
+    static void set(sqlite3_context* context, const std::variant<Ts...>& value) {
+      std::visit([context](const auto& v) {
+        SqliteResultTraits<std::decay_t<decltype(v)>>::set(context, v);
+      }, value);
+    }
+  };
+
+  namespace detail {
+
+    /**
+     * @brief Parameter and result types of a function object or function pointer.
+     */
+    template<typename F>
+    struct CallableTraits : CallableTraits<decltype(&F::operator())> {
+    };
+
+    template<typename R, typename... A>
+    struct CallableTraits<R (*)(A...)> {
+      using Result = R;
+      using Arguments = std::tuple<A...>;
+    };
+
+    template<typename R, typename... A>
+    struct CallableTraits<R (*)(A...) noexcept> : CallableTraits<R (*)(A...)> {
+    };
+
+    template<typename C, typename R, typename... A>
+    struct CallableTraits<R (C::*)(A...)> : CallableTraits<R (*)(A...)> {
+    };
+
+    template<typename C, typename R, typename... A>
+    struct CallableTraits<R (C::*)(A...) const> : CallableTraits<R (*)(A...)> {
+    };
+
+    template<typename C, typename R, typename... A>
+    struct CallableTraits<R (C::*)(A...) noexcept> : CallableTraits<R (*)(A...)> {
+    };
+
+    template<typename C, typename R, typename... A>
+    struct CallableTraits<R (C::*)(A...) const noexcept> : CallableTraits<R (*)(A...)> {
+    };
+
+    template<typename Tuple>
+    struct TupleTail;
+
+    template<typename Head, typename... Tail>
+    struct TupleTail<std::tuple<Head, Tail...>> {
+      using type = std::tuple<Tail...>;
+    };
+
+    /**
+     * @brief Aggregate state type: the decayed first parameter of the step callable.
+     */
+    template<typename Step>
+    using AggregateStateOf = std::remove_cvref_t<std::tuple_element_t<0, typename CallableTraits<Step>::Arguments>>;
+
+    /**
+     * @brief SQL arguments of the aggregate step callable, without the state.
+     */
+    template<typename Step>
+    using AggregateArgumentsOf = typename TupleTail<typename CallableTraits<Step>::Arguments>::type;
+
+    /**
+     * @brief Call @p function with `argv` decoded into its parameter types.
+     */
+    template<typename Arguments, typename F, typename... Leading>
+    decltype(auto) invokeWithArguments(F& function, sqlite3_value** argv, Leading&... leading) {
+      return [&]<std::size_t... I>(std::index_sequence<I...>) -> decltype(auto) {
+        return function(leading...,
+            SqliteArgumentTraits<std::remove_cvref_t<std::tuple_element_t<I, Arguments>>>::read(argv[I])...);
+      }(std::make_index_sequence<std::tuple_size_v<Arguments>> { });
+    }
+
+    /**
+     * @brief Run @p body and report its exception as the SQL error of @p context.
+     */
+    template<typename Body>
+    void guardSqlFunction(sqlite3_context* context, Body&& body) noexcept {
+      try {
+        body();
+      } catch (const std::bad_alloc&) {
+        sqlite3_result_error_nomem(context);
+      } catch (const std::exception& e) {
+        sqlite3_result_error(context, e.what(), -1);
+      } catch (...) {
+        sqlite3_result_error(context, "unknown exception in SQL function", -1);
+      }
+    }
+
+    /**
+     * @brief Set the result of @p context from the value returned by @p call.
+     */
+    template<typename Call>
+    void setSqlResult(sqlite3_context* context, Call&& call) {
+      using Result = decltype(call());
+      if constexpr (std::is_void_v<Result>) {
+        call();
+        sqlite3_result_null(context);
+      } else {
+        SqliteResultTraits<std::remove_cvref_t<Result>>::set(context, call());
+      }
+    }
+
+    template<typename F>
+    struct ScalarFunction {
+      using Arguments = typename CallableTraits<F>::Arguments;
+
+      F function;
+
+      static void call(sqlite3_context* context, int, sqlite3_value** argv) {
+        auto* self = static_cast<ScalarFunction*>(sqlite3_user_data(context));
+        guardSqlFunction(context, [&] {
+          setSqlResult(context, [&]() -> decltype(auto) {
+            return invokeWithArguments<Arguments>(self->function, argv);
+          });
+        });
+      }
+    };
+
+    /**
+     * @brief Aggregate state living in the memory of `sqlite3_aggregate_context`.
+     *
+     * SQLite hands out zeroed memory on the first call of a group, so the
+     * flag tells whether the state was constructed yet.
+     */
+    template<typename State>
+    struct AggregateSlot {
+      bool constructed;
+      alignas(State) unsigned char storage[sizeof(State)];
+
+      State& state() noexcept {
+        return *std::launder(reinterpret_cast<State*>(storage));
+      }
+    };
+
+    /**
+     * @brief The state of the current group, constructed on first use.
+     * @return nullptr if @p create is false and the group has no state yet.
+     */
+    template<typename State>
+    AggregateSlot<State>* aggregateSlot(sqlite3_context* context, bool create) {
+      static_assert(alignof(State) <= 8, "SQLite aligns aggregate context memory to 8 bytes");
+      void* memory = sqlite3_aggregate_context(context, create ? static_cast<int>(sizeof(AggregateSlot<State>)) : 0);
+      if (!memory) {
+        if (create) {
+          throw std::bad_alloc();
+        }
+        return nullptr;
+      }
+      auto* slot = static_cast<AggregateSlot<State>*>(memory);
+      if (!slot->constructed) {
+        ::new (static_cast<void*>(slot->storage)) State();
+        slot->constructed = true;
+      }
+      return slot;
+    }
+
+    /**
+     * @brief Produce the final result of the group and destroy its state.
+     */
+    template<typename State, typename Final>
+    void finalizeAggregate(sqlite3_context* context, Final& final) {
+      AggregateSlot<State>* slot = aggregateSlot<State>(context, false);
+      if (!slot) {
+        // No row reached the group: finish from a fresh state
+        State empty { };
+        guardSqlFunction(context, [&] {
+          setSqlResult(context, [&]() -> decltype(auto) {
+            return final(empty);
+          });
+        });
+        return;
+      }
+
+      guardSqlFunction(context, [&] {
+        setSqlResult(context, [&]() -> decltype(auto) {
+          return final(slot->state());
+        });
+      });
+      slot->state().~State();
+      slot->constructed = false;
+    }
+
+    template<typename Step, typename Final>
+    struct AggregateFunction {
+      using State = AggregateStateOf<Step>;
+      using Arguments = AggregateArgumentsOf<Step>;
+
+      Step step;
+      Final final;
+
+      static void callStep(sqlite3_context* context, int, sqlite3_value** argv) {
+        auto* self = static_cast<AggregateFunction*>(sqlite3_user_data(context));
+        guardSqlFunction(context, [&] {
+          State& state = aggregateSlot<State>(context, true)->state();
+          invokeWithArguments<Arguments>(self->step, argv, state);
+        });
+      }
+
+      static void callFinal(sqlite3_context* context) {
+        auto* self = static_cast<AggregateFunction*>(sqlite3_user_data(context));
+        finalizeAggregate<State>(context, self->final);
+      }
+    };
+
+    template<typename Step, typename Inverse, typename Value, typename Final>
+    struct WindowFunction {
+      using State = AggregateStateOf<Step>;
+      using Arguments = AggregateArgumentsOf<Step>;
+
+      static_assert(std::is_same_v<State, AggregateStateOf<Inverse>>,
+          "step and inverse must take the same state type");
+
+      Step step;
+      Inverse inverse;
+      Value value;
+      Final final;
+
+      static void callStep(sqlite3_context* context, int, sqlite3_value** argv) {
+        auto* self = static_cast<WindowFunction*>(sqlite3_user_data(context));
+        guardSqlFunction(context, [&] {
+          State& state = aggregateSlot<State>(context, true)->state();
+          invokeWithArguments<Arguments>(self->step, argv, state);
+        });
+      }
+
+      static void callInverse(sqlite3_context* context, int, sqlite3_value** argv) {
+        auto* self = static_cast<WindowFunction*>(sqlite3_user_data(context));
+        guardSqlFunction(context, [&] {
+          State& state = aggregateSlot<State>(context, true)->state();
+          invokeWithArguments<Arguments>(self->inverse, argv, state);
+        });
+      }
+
+      static void callValue(sqlite3_context* context) {
+        auto* self = static_cast<WindowFunction*>(sqlite3_user_data(context));
+        guardSqlFunction(context, [&] {
+          State& state = aggregateSlot<State>(context, true)->state();
+          setSqlResult(context, [&]() -> decltype(auto) {
+            return self->value(static_cast<const State&>(state));
+          });
+        });
+      }
+
+      static void callFinal(sqlite3_context* context) {
+        auto* self = static_cast<WindowFunction*>(sqlite3_user_data(context));
+        finalizeAggregate<State>(context, self->final);
+      }
+    };
+
+    template<typename T>
+    void deleteFunction(void* function) {
+      delete static_cast<T*>(function);
+    }
+
+  } /* namespace detail */
+
+} /* namespace sdb */
+
+#endif /* INCLUDE_SQLITEFUNCTION_HPP_ */
@@ -0,0 +1,118 @@
+#ifndef INCLUDE_SQLITEGROUPCOMMITTER_HPP_
+#define INCLUDE_SQLITEGROUPCOMMITTER_HPP_
+
+/**
+ * @file SqliteGroupCommitter.hpp
+ * @brief Group commit of small writes submitted by many threads.
+ */
+
+#include <SqliteDb.hpp>
+#include <SqliteJob.hpp>
+#include <SqliteJobQueue.hpp>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+namespace sdb {
+
+  /**
+   * @brief Amortizes fsync across many small write transactions.
+   *
+   * Producers submit write closures from any thread.  A writer thread runs
+   * them back-to-back inside one `BEGIN IMMEDIATE` transaction, each in its
+   * own SAVEPOINT so a failing job rolls back alone, and commits once
+   * `maxBatchJobs` jobs have run or `maxLatency` has elapsed since the first
+   * job of the batch.  A job's future becomes ready only after the commit
+   * that made it durable, so write throughput is bounded by batch size
+   * rather than fsync latency.
+   *
+   * Example usage:
+   * @code
+   *   sdb::SqliteGroupCommitter writer(sdb::SqliteDb::open("app.db"));
+   *   auto durable = writer.submit([](sdb::SqliteDb& db) {
+   *     db.execute("INSERT INTO events (kind) VALUES ('login')");
+   *   });
+   *   durable.get(); // committed and synced
+   * @endcode
+   */
+  class SqliteGroupCommitter {
+    public:
+      struct Options {
+        /** Commit once this many jobs ran in the current batch. */
+        std::size_t maxBatchJobs = 256;
+        /** Commit once this much time passed since the first job of the batch. */
+        std::chrono::microseconds maxLatency { 2000 };
+      };
+
+      struct Stats {
+        std::uint64_t jobs = 0;
+        std::uint64_t failedJobs = 0;
+        std::uint64_t commits = 0;
+        std::uint64_t failedCommits = 0;
+        std::chrono::nanoseconds lastCommitDuration { 0 };
+        std::chrono::nanoseconds maxCommitDuration { 0 };
+
+        double averageBatchSize() const {
+          return commits > 0 ? static_cast<double>(jobs) / static_cast<double>(commits) : 0.0;
+        }
+      };
+
+      /**
+       * @brief Take ownership of @p db and start the writer thread.
+       */
+      explicit SqliteGroupCommitter(std::unique_ptr<SqliteDb> db);
+
+      /**
+       * @brief Take ownership of @p db and start the writer thread.
+       */
+      SqliteGroupCommitter(std::unique_ptr<SqliteDb> db, Options options);
+
+      SqliteGroupCommitter(const SqliteGroupCommitter&) = delete;
+      SqliteGroupCommitter& operator=(const SqliteGroupCommitter&) = delete;
+
+      /**
+       * @brief Commit every queued job, then stop the writer thread.
+       */
+      ~SqliteGroupCommitter();
+
+      /**
+       * @brief Queue a write job.
+       * @param job Callable invoked as `job(SqliteDb&)` inside the group transaction.
+       * @return Future that becomes ready once the job's batch has committed.
+       */
+      template<typename F>
+        auto submit(F&& job) -> std::future<std::invoke_result_t<std::decay_t<F>&, SqliteDb&>>;
+
+      /**
+       * @brief Snapshot of the batching counters.
+       */
+      Stats getStats() const;
+
+    private:
+      std::unique_ptr<SqliteDb> mDb;
+      Options mOptions;
+      SqliteJobQueue mQueue;
+
+      mutable std::mutex mStatsMutex;
+      Stats mStats;
+
+      std::thread mWriter;
+
+      void push(SqliteJobPtr job);
+      void writerLoop();
+  };
+
+  template<typename F>
+  auto SqliteGroupCommitter::submit(F&& job) -> std::future<std::invoke_result_t<std::decay_t<F>&, SqliteDb&>> {
+      auto [queued, future] = makeSqliteJob(std::forward<F>(job), true);
+      push(std::move(queued));
+      return std::move(future);
+  }
+
+} /* namespace sdb */
+
+#endif /* INCLUDE_SQLITEGROUPCOMMITTER_HPP_ */
@@ -0,0 +1,167 @@
+#ifndef INCLUDE_SQLITEJOB_HPP_
+#define INCLUDE_SQLITEJOB_HPP_
+
+/**
+ * @file SqliteJob.hpp
+ * @brief Type-erased database jobs and the transaction batch that runs them.
+ */
+
+#include <SqliteTransaction.hpp>
+#include <exception>
+#include <future>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace sdb {
+
+  class SqliteDb;
+
+  /**
+   * @brief A unit of work queued for a database worker thread.
+   *
+   * `run()` executes the work; the outcome is only published to the
+   * submitter by `complete()` or `fail()`, which lets write jobs report
+   * success after their transaction has committed.
+   */
+  class SqliteJob {
+    public:
+      explicit SqliteJob(bool write)
+        : mWrite(write) {
+      }
+
+      virtual ~SqliteJob() = default;
+
+      virtual void run(SqliteDb& db) = 0;
+      virtual void complete() = 0;
+      virtual void fail(std::exception_ptr error) = 0;
+
+      bool isWrite() const noexcept {
+        return mWrite;
+      }
+
+    private:
+      bool mWrite;
+  };
+
+  using SqliteJobPtr = std::unique_ptr<SqliteJob>;
+
+  /**
+   * @brief `SqliteJob` wrapping a callable and the promise of its result.
+   */
+  template<typename F, typename R>
+  class SqliteTypedJob : public SqliteJob {
+    public:
+      SqliteTypedJob(F function, bool write)
+        : SqliteJob(write)
+        , mFunction(std::move(function)) {
+      }
+
+      void run(SqliteDb& db) override {
+        if constexpr (std::is_void_v<R>) {
+          mFunction(db);
+          mResult = true;
+        } else {
+          mResult.emplace(mFunction(db));
+        }
+      }
+
+      void complete() override {
+        if constexpr (std::is_void_v<R>) {
+          mPromise.set_value();
+        } else {
+          mPromise.set_value(std::move(*mResult));
+        }
+      }
+
+      void fail(std::exception_ptr error) override {
+        mPromise.set_exception(error);
+      }
+
+      std::future<R> getFuture() {
+        return mPromise.get_future();
+      }
+
+    private:
+      F mFunction;
+      std::promise<R> mPromise;
+      std::optional<std::conditional_t<std::is_void_v<R>, bool, R>> mResult;
+  };
+
+  /**
+   * @brief Wrap a callable taking `SqliteDb&` into a job and its future.
+   */
+  template<typename F>
+  auto makeSqliteJob(F&& function, bool write) {
+    using Function = std::decay_t<F>;
+    using Result = std::invoke_result_t<Function&, SqliteDb&>;
+
+    auto job = std::make_unique<SqliteTypedJob<Function, Result>>(Function(std::forward<F>(function)), write);
+    auto future = job->getFuture();
+    return std::pair<SqliteJobPtr, std::future<Result>>(std::move(job), std::move(future));
+  }
+
+  /**
+   * @brief Runs write jobs back-to-back inside one transaction.
+   *
+   * Every job runs in its own SAVEPOINT, so a job that throws is rolled back
+   * alone and fails immediately.  The others are completed by `commit()`
+   * once the transaction is durable, or failed if the commit does not go
+   * through.  A batch destroyed without `commit()` rolls back and fails its
+   * jobs.
+   */
+  class SqliteJobBatch {
+    public:
+      /**
+       * @brief Begin the batch transaction.
+       * @throw SqliteTransactionException if the transaction cannot be started.
+       */
+      SqliteJobBatch(SqliteDb& db, SqliteTransaction::Mode mode);
+
+      SqliteJobBatch(const SqliteJobBatch&) = delete;
+      SqliteJobBatch& operator=(const SqliteJobBatch&) = delete;
+
+      ~SqliteJobBatch();
+
+      /**
+       * @brief Run one job inside the batch.
+       * @return false if the batch transaction itself failed; the job and all
+       *         jobs run so far have then been failed and nothing more may run.
+       */
+      bool run(SqliteJobPtr job);
+
+      /**
+       * @brief Commit and publish the outcome of every job run so far.
+       * @return true if the transaction committed.
+       */
+      bool commit();
+
+      /**
+       * @brief Number of jobs run in this batch, successful or not.
+       */
+      std::size_t size() const noexcept {
+        return mJobCount;
+      }
+
+      /**
+       * @brief Number of jobs that threw and were rolled back to their savepoint.
+       */
+      std::size_t failedCount() const noexcept {
+        return mFailedCount;
+      }
+
+    private:
+      SqliteDb& mDb;
+      std::optional<SqliteTransaction> mTransaction;
+      std::vector<SqliteJobPtr> mSucceeded;
+      std::size_t mJobCount;
+      std::size_t mFailedCount;
+
+      void abort(std::exception_ptr error);
+  };
+
+} /* namespace sdb */
+
+#endif /* INCLUDE_SQLITEJOB_HPP_ */
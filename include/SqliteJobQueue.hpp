@@ -0,0 +1,76 @@
+#ifndef INCLUDE_SQLITEJOBQUEUE_HPP_
+#define INCLUDE_SQLITEJOBQUEUE_HPP_
+
+/**
+ * @file SqliteJobQueue.hpp
+ * @brief Job queue feeding a single database worker thread.
+ */
+
+#include <SqliteJob.hpp>
+#include <SqliteMpscQueue.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <semaphore>
+
+namespace sdb {
+
+  /**
+   * @brief Queue of `SqliteJobPtr` with any number of producers and one worker.
+   *
+   * Jobs travel over a `SqliteMpscQueue` and are counted by a semaphore the
+   * worker blocks on.  close() stops accepting jobs and appends a null job
+   * once every push() already under way has landed, so the worker sees each
+   * accepted job before the null one that tells it to stop.
+   */
+  class SqliteJobQueue {
+    public:
+      SqliteJobQueue() = default;
+
+      SqliteJobQueue(const SqliteJobQueue&) = delete;
+      SqliteJobQueue& operator=(const SqliteJobQueue&) = delete;
+
+      /**
+       * @brief Append a job.  Safe to call from any thread.
+       * @return false if the queue is closed and @p job was dropped.
+       */
+      bool push(SqliteJobPtr job);
+
+      /**
+       * @brief Stop accepting jobs and queue the null job after the accepted ones.
+       *
+       * Call once, from the thread that owns the worker.
+       */
+      void close();
+
+      /**
+       * @brief Wait for the next job.  Worker thread only.
+       * @return The job; null once the queue was closed and drained.
+       */
+      SqliteJobPtr pop();
+
+      /**
+       * @brief Take the next job if one is queued.  Worker thread only.
+       */
+      std::optional<SqliteJobPtr> tryPop();
+
+      /**
+       * @brief Wait until @p deadline for the next job.  Worker thread only.
+       */
+      std::optional<SqliteJobPtr> tryPopUntil(std::chrono::steady_clock::time_point deadline);
+
+    private:
+      /** Set in mProducers once the queue is closed; the low bits count pushes under way. */
+      static constexpr std::uint64_t CLOSED = std::uint64_t(1) << 63;
+
+      SqliteMpscQueue<SqliteJobPtr> mQueue;
+      std::counting_semaphore<> mPending { 0 };
+      std::atomic<std::uint64_t> mProducers { 0 };
+
+      SqliteJobPtr popCounted();
+  };
+
+} /* namespace sdb */
+
+#endif /* INCLUDE_SQLITEJOBQUEUE_HPP_ */
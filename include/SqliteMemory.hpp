@@ -0,0 +1,66 @@
+#ifndef INCLUDE_SQLITEMEMORY_HPP_
+#define INCLUDE_SQLITEMEMORY_HPP_
+
+/**
+ * @file SqliteMemory.hpp
+ * @brief Process-wide allocators installed underneath SQLite.
+ */
+
+#include <cstddef>
+
+namespace sdb {
+
+  /**
+   * @brief Replaces SQLite's default `malloc`-based allocator.
+   *
+   * Like every `sqlite3_config` option, an allocator can only be installed
+   * before the library is initialized, i.e. before the first connection is
+   * opened, and only once per process.  Per-connection lookaside is
+   * configured separately through `SqliteDb::Tuning::lookaside`.
+   *
+   * Example usage:
+   * @code
+   *   int main() {
+   *     sdb::SqliteMemory::installThreadCachingPool();
+   *     auto db = sdb::SqliteDb::open("app.db");
+   *     // ...
+   *   }
+   * @endcode
+   */
+  class SqliteMemory {
+    public:
+      SqliteMemory() = delete;
+
+      /**
+       * @brief Install a pool allocator with per-thread free lists.
+       *
+       * Allocations up to 4 KiB are rounded to a power-of-two size class
+       * and recycled through a free list owned by the freeing thread, so
+       * connections on different threads stop contending on the global
+       * `malloc` lock.  Larger allocations go straight to `malloc`.  Each
+       * thread keeps at most @p maxCachedPerClass idle blocks per class
+       * and returns its cache to `malloc` when it exits.
+       *
+       * @throws sdb::SqliteDbException if SQLite is already initialized.
+       */
+      static void installThreadCachingPool(std::size_t maxCachedPerClass = 256);
+
+      /**
+       * @brief Serve every SQLite allocation from one preallocated arena.
+       *
+       * Uses SQLite's memsys5 buddy allocator (`SQLITE_CONFIG_HEAP`), which
+       * requires building with the `SQLITE_ENABLE_MEMSYS5` CMake option.
+       * The arena is allocated once and lives until the process exits;
+       * allocation fails with SQLITE_NOMEM once it is exhausted.
+       *
+       * @param bytes Arena size.
+       * @param minAllocation Smallest allocation, rounded up to a power of two.
+       * @throws sdb::SqliteDbException if memsys5 is not compiled in or SQLite
+       *   is already initialized.
+       */
+      static void installArena(std::size_t bytes, int minAllocation = 64);
+  };
+
+} /* namespace sdb */
+
+#endif /* INCLUDE_SQLITEMEMORY_HPP_ */
@@ -0,0 +1,80 @@
+#ifndef INCLUDE_SQLITEMPSCQUEUE_HPP_
+#define INCLUDE_SQLITEMPSCQUEUE_HPP_
+
+/**
+ * @file SqliteMpscQueue.hpp
+ * @brief Lock-free multi-producer single-consumer queue.
+ */
+
+#include <atomic>
+#include <optional>
+#include <utility>
+
+namespace sdb {
+
+  /**
+   * @brief Unbounded lock-free MPSC queue (Vyukov's linked-list queue).
+   *
+   * Any number of threads may call `push()`; only one thread may call
+   * `pop()`.  `pop()` can briefly report an empty queue while a concurrent
+   * `push()` is half-way through linking its node, so consumers that count
+   * items separately (e.g. with a semaphore) should retry.
+   */
+  template<typename T>
+  class SqliteMpscQueue {
+    public:
+      SqliteMpscQueue()
+        : mHead(new Node)
+        , mTail(mHead.load(std::memory_order_relaxed)) {
+      }
+
+      SqliteMpscQueue(const SqliteMpscQueue&) = delete;
+      SqliteMpscQueue& operator=(const SqliteMpscQueue&) = delete;
+
+      ~SqliteMpscQueue() {
+        while (pop()) {
+        }
+        delete mTail;
+      }
+
+      /**
+       * @brief Append an element.  Safe to call from any thread.
+       */
+      void push(T value) {
+        Node* node = new Node;
+        node->value.emplace(std::move(value));
+        Node* previous = mHead.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+      }
+
+      /**
+       * @brief Remove the oldest element.  Consumer thread only.
+       * @return The element, or an empty optional if none is visible yet.
+       */
+      std::optional<T> pop() {
+        Node* tail = mTail;
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (!next) {
+          return std::nullopt;
+        }
+
+        std::optional<T> value(std::move(next->value));
+        next->value.reset();
+        mTail = next;
+        delete tail;
+        return value;
+      }
+
+    private:
+      struct Node {
+        std::atomic<Node*> next { nullptr };
+        std::optional<T> value;
+      };
+
+      std::atomic<Node*> mHead;
+      Node* mTail;
+  };
+
+} /* namespace sdb */
+
+#endif /* INCLUDE_SQLITEMPSCQUEUE_HPP_ */
@@ -0,0 +1,64 @@
+#ifndef INCLUDE_SQLITEPLAN_HPP_
+#define INCLUDE_SQLITEPLAN_HPP_
+
+/**
+ * @file SqlitePlan.hpp
+ * @brief Structured result of `EXPLAIN QUERY PLAN`.
+ */
+
+#include <string>
+#include <vector>
+
+namespace sdb {
+
+  /**
+   * @brief One line of a query plan and the lines nested under it.
+   */
+  struct SqlitePlanNode {
+    int id = 0;
+    int parent = 0;
+    /** Text as printed by the sqlite3 shell, e.g. "SEARCH users USING INDEX idx_name (name=?)". */
+    std::string detail;
+    std::vector<SqlitePlanNode> children;
+
+    /**
+     * @brief Whether this step reads a whole table or index ("SCAN ...").
+     */
+    bool isFullScan() const;
+
+    /**
+     * @brief Whether this step builds a transient automatic index.
+     */
+    bool usesAutomaticIndex() const;
+  };
+
+  /**
+   * @brief Query plan as a tree of `SqlitePlanNode`.
+   */
+  struct SqlitePlan {
+    std::vector<SqlitePlanNode> roots;
+
+    /**
+     * @brief Build the tree from plan rows in the order SQLite returns them.
+     */
+    static SqlitePlan fromRows(std::vector<SqlitePlanNode> rows);
+
+    /**
+     * @brief Whether any step of the plan is a full scan.
+     */
+    bool hasFullScan() const;
+
+    /**
+     * @brief Whether any step of the plan builds an automatic index.
+     */
+    bool hasAutomaticIndex() const;
+
+    /**
+     * @brief Render the plan as an indented tree like the sqlite3 shell does.
+     */
+    std::string toString() const;
+  };
+
+} /* namespace sdb */
+
+#endif /* INCLUDE_SQLITEPLAN_HPP_ */
@@ -0,0 +1,179 @@
+#ifndef INCLUDE_SQLITEPROFILER_HPP_
+#define INCLUDE_SQLITEPROFILER_HPP_
+
+/**
+ * @file SqliteProfiler.hpp
+ * @brief Per-statement latency histograms and slow-query reporting.
+ */
+
+#include <SqliteTypes.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace sdb {
+
+  /**
+   * @brief Collects statistics for every statement run on one connection.
+   *
+   * Installed with `SqliteDb::enableProfiling()`, it is fed by
+   * `SQLITE_TRACE_STMT` when a statement starts and `SQLITE_TRACE_PROFILE`
+   * when it finishes, and is handed the statement's `sqlite3_stmt_status`
+   * counters for that execution.  Latency is measured with `steady_clock`, as the
+   * time SQLite reports with PROFILE only has millisecond resolution on
+   * most platforms.  Statistics are
+   * keyed by SQL text, so every execution of a cached statement lands in the
+   * same entry.  A connection without a profiler registers no trace callback
+   * and pays nothing.
+   */
+  class SqliteProfiler {
+    public:
+      /**
+       * @brief Latency histogram with power-of-two microsecond buckets.
+       *
+       * Bucket `i < BUCKETS - 1` counts durations up to `2^i` microseconds;
+       * the last bucket counts everything slower.
+       */
+      struct Histogram {
+        static constexpr std::size_t BUCKETS = 24;
+
+        std::array<std::uint64_t, BUCKETS> counts { };
+        std::uint64_t count = 0;
+        std::chrono::nanoseconds sum { 0 };
+        std::chrono::nanoseconds max { 0 };
+
+        void add(std::chrono::nanoseconds duration);
+
+        /**
+         * @brief Upper bound of bucket @p index, or `nanoseconds::max()` for the last one.
+         */
+        static std::chrono::nanoseconds upperBound(std::size_t index);
+
+        /**
+         * @brief Approximate quantile, reported as the upper bound of its bucket.
+         * @param q Quantile in [0, 1].
+         */
+        std::chrono::nanoseconds quantile(double q) const;
+      };
+
+      /**
+       * @brief `sqlite3_stmt_status` counters accumulated over executions.
+       */
+      struct Counters {
+        std::uint64_t fullscanSteps = 0;
+        std::uint64_t sorts = 0;
+        std::uint64_t autoindexes = 0;
+        std::uint64_t vmSteps = 0;
+        /** Largest heap footprint of the prepared statement, in bytes. */
+        std::uint64_t memoryUsed = 0;
+      };
+
+      struct StatementProfile {
+        std::string sql;
+        Histogram latency;
+        Counters counters;
+      };
+
+      struct SlowQuery {
+        /** SQL text with bound parameters expanded when `expandSlowQueries` is set. */
+        std::string sql;
+        std::chrono::nanoseconds duration { 0 };
+        /** Counters of this execution alone. */
+        Counters counters;
+      };
+
+      struct Snapshot {
+        std::vector<StatementProfile> statements;
+        /** Executions not recorded because `maxStatements` distinct SQL texts were already tracked. */
+        std::uint64_t droppedExecutions = 0;
+        /** Executions whose recording or `onSlowQuery` threw.  The exception
+         *  is dropped: it must not unwind through SQLite's trace hook. */
+        std::uint64_t failedExecutions = 0;
+
+        /**
+         * @brief Render the snapshot in the Prometheus text exposition format.
+         * @param prefix Metric name prefix.
+         */
+        std::string toPrometheus(std::string_view prefix = "sqlitedb") const;
+      };
+
+      struct Options {
+        /** Report executions slower than this to `onSlowQuery`; 0 reports none. */
+        std::chrono::nanoseconds slowThreshold { 0 };
+        /**
+         * Invoked on the executing thread while SQLite holds the connection:
+         * it must not use the connection.
+         */
+        std::function<void(const SlowQuery&)> onSlowQuery;
+        /** Expand bound parameters into the SQL text of slow queries. */
+        bool expandSlowQueries = false;
+        /** Maximum number of distinct SQL texts tracked. */
+        std::size_t maxStatements = 1000;
+      };
+
+      explicit SqliteProfiler(Options options);
+
+      SqliteProfiler(const SqliteProfiler&) = delete;
+      SqliteProfiler& operator=(const SqliteProfiler&) = delete;
+
+      /**
+       * @brief Note that @p stmt started running.
+       */
+      void begin(sqlite3_stmt* stmt);
+
+      /**
+       * @brief Record one finished execution of @p stmt.
+       * @param sqliteDuration Duration reported by SQLite, used when begin() was not seen.
+       * @param counters `sqlite3_stmt_status` counters of this execution.
+       */
+      void record(sqlite3_stmt* stmt, std::chrono::nanoseconds sqliteDuration, const Counters& counters);
+
+      /**
+       * @brief Count an execution that begin() or record() failed on.
+       */
+      void recordFailure() noexcept;
+
+      /**
+       * @brief Copy the statistics collected so far, slowest total time first.
+       */
+      Snapshot snapshot() const;
+
+      /**
+       * @brief Drop every statistic collected so far.
+       */
+      void reset();
+
+    private:
+      struct SqlHash {
+        using is_transparent = void;
+
+        std::size_t operator()(std::string_view sql) const noexcept {
+          return std::hash<std::string_view> { }(sql);
+        }
+      };
+
+      struct Entry {
+        Histogram latency;
+        Counters counters;
+      };
+
+      Options mOptions;
+      // Only the running statements of one connection: a few entries at most
+      std::vector<std::pair<sqlite3_stmt*, std::chrono::steady_clock::time_point>> mRunning;
+      mutable std::mutex mMutex;
+      std::unordered_map<std::string, Entry, SqlHash, std::equal_to<>> mEntries;
+      std::uint64_t mDroppedExecutions;
+      std::atomic<std::uint64_t> mFailedExecutions { 0 };
+  };
+
+} /* namespace sdb */
+
+#endif /* INCLUDE_SQLITEPROFILER_HPP_ */
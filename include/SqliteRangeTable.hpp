@@ -0,0 +1,670 @@
+#ifndef INCLUDE_SQLITERANGETABLE_HPP_
+#define INCLUDE_SQLITERANGETABLE_HPP_
+
+/**
+ * @file SqliteRangeTable.hpp
+ * @brief Read-only eponymous virtual table over a random-access range of rows.
+ */
+
+#include "../sqlite/sqlite3.h"
+#include <SqliteFunction.hpp>
+#include <SqliteTraits.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <new>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace sdb {
+
+  namespace detail {
+
+    /**
+     * @brief Outcome of comparing a row field against a constraint value.
+     *
+     * `NO_MATCH` means the comparison is NULL, so the row fails every
+     * operator; `UNKNOWN` means SQLite's type rules are needed to decide.
+     */
+    enum class FieldOrder {
+      LESS,
+      EQUAL,
+      GREATER,
+      NO_MATCH,
+      UNKNOWN
+    };
+
+    template<typename T>
+    struct IsOptional : std::false_type {
+    };
+
+    template<typename T>
+    struct IsOptional<std::optional<T>> : std::true_type {
+    };
+
+    template<typename T>
+    constexpr bool isTextField = std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>
+        || std::is_same_v<T, const char*>;
+
+    template<typename T>
+    constexpr bool isBlobField = std::is_same_v<T, std::vector<std::byte>> || std::is_same_v<T, std::span<const std::byte>>;
+
+    /**
+     * @brief Declared column type, which gives the column its affinity.
+     */
+    template<typename T>
+    constexpr const char* fieldDeclaredType() {
+      if constexpr (IsOptional<T>::value) {
+        return fieldDeclaredType<typename T::value_type>();
+      } else if constexpr (std::is_integral_v<T>) {
+        return "INTEGER";
+      } else if constexpr (std::is_floating_point_v<T>) {
+        return "REAL";
+      } else if constexpr (isTextField<T>) {
+        return "TEXT";
+      } else if constexpr (isBlobField<T>) {
+        return "BLOB";
+      } else {
+        return "";
+      }
+    }
+
+    inline FieldOrder toFieldOrder(std::partial_ordering order) {
+      if (order < 0) {
+        return FieldOrder::LESS;
+      }
+      if (order > 0) {
+        return FieldOrder::GREATER;
+      }
+      return order == 0 ? FieldOrder::EQUAL : FieldOrder::UNKNOWN;
+    }
+
+    /**
+     * @brief Order an integer against a real exactly, like SQLite, also beyond 2^53.
+     */
+    inline std::partial_ordering compareIntegerReal(std::int64_t integer, double real) {
+      if (std::isnan(real)) {
+        return std::partial_ordering::unordered;
+      }
+      if (real < -9223372036854775808.0) {
+        return std::partial_ordering::greater;
+      }
+      if (real >= 9223372036854775808.0) {
+        return std::partial_ordering::less;
+      }
+      std::int64_t truncated = static_cast<std::int64_t>(real);
+      if (integer != truncated) {
+        return integer <=> truncated;
+      }
+      return 0.0 <=> real - static_cast<double>(truncated);
+    }
+
+    /**
+     * @brief Compare @p field with @p value where C++ and SQLite agree on the result.
+     * @param binaryText The constraint uses the BINARY collation.
+     */
+    template<typename T>
+    FieldOrder compareField(const T& field, sqlite3_value* value, bool binaryText) {
+      int type = sqlite3_value_type(value);
+      if (type == SQLITE_NULL) {
+        return FieldOrder::NO_MATCH;
+      }
+
+      if constexpr (IsOptional<T>::value) {
+        return field ? compareField(*field, value, binaryText) : FieldOrder::NO_MATCH;
+      } else if constexpr (std::is_integral_v<T>) {
+        if (type == SQLITE_INTEGER) {
+          return toFieldOrder(static_cast<std::int64_t>(field) <=> sqlite3_value_int64(value));
+        }
+        if (type == SQLITE_FLOAT) {
+          return toFieldOrder(compareIntegerReal(static_cast<std::int64_t>(field), sqlite3_value_double(value)));
+        }
+      } else if constexpr (std::is_floating_point_v<T>) {
+        if (type == SQLITE_INTEGER) {
+          return toFieldOrder(0 <=> compareIntegerReal(sqlite3_value_int64(value), static_cast<double>(field)));
+        }
+        if (type == SQLITE_FLOAT) {
+          return toFieldOrder(static_cast<double>(field) <=> sqlite3_value_double(value));
+        }
+      } else if constexpr (isTextField<T>) {
+        if (type == SQLITE_TEXT && binaryText) {
+          std::string_view text = SqliteArgumentTraits<std::string_view>::read(value);
+          return toFieldOrder(std::string_view(field) <=> text);
+        }
+      } else if constexpr (isBlobField<T>) {
+        if (type == SQLITE_BLOB) {
+          auto blob = SqliteArgumentTraits<std::span<const std::byte>>::read(value);
+          std::span<const std::byte> bytes(field);
+          std::size_t common = std::min(bytes.size(), blob.size());
+          int order = common > 0 ? std::memcmp(bytes.data(), blob.data(), common) : 0;
+          return toFieldOrder(order != 0 ? order <=> 0 : bytes.size() <=> blob.size());
+        }
+      }
+      return FieldOrder::UNKNOWN;
+    }
+
+    /**
+     * @brief Set a field as the column result, without a copy when its storage is stable.
+     */
+    template<bool Stable, typename T>
+    void setFieldResult(sqlite3_context* context, const T& field) {
+      if constexpr (IsOptional<T>::value) {
+        if (field) {
+          setFieldResult<Stable>(context, *field);
+        } else {
+          sqlite3_result_null(context);
+        }
+      } else if constexpr (Stable && (std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>)) {
+        const char* text = field.data() ? field.data() : "";
+        sqlite3_result_text64(context, text, field.size(), SQLITE_STATIC, SQLITE_UTF8);
+      } else if constexpr (Stable && isBlobField<T>) {
+        sqlite3_result_blob64(context, field.data(), field.size(), SQLITE_STATIC);
+      } else if constexpr (std::is_integral_v<T> && !std::is_same_v<T, bool>) {
+        sqlite3_result_int64(context, static_cast<std::int64_t>(field));
+      } else {
+        SqliteResultTraits<T>::set(context, field);
+      }
+    }
+
+    /**
+     * @brief Virtual table module exposing @p View, one row per element.
+     *
+     * The rowid of a row is its position in the range.
+     */
+    template<std::ranges::random_access_range View>
+    class SqliteRangeModule {
+      public:
+        using Row = std::remove_cvref_t<std::ranges::range_reference_t<View>>;
+
+        static_assert(SqliteFieldRow<Row>, "Range elements must be tuple-like or aggregate structs");
+
+        static constexpr std::size_t COLUMN_COUNT = sqliteRowFieldCount<Row>();
+
+        SqliteRangeModule(View view, std::vector<std::string> columns, std::optional<std::size_t> sortedBy)
+          : mView(std::move(view))
+          , mColumns(std::move(columns))
+          , mSortedBy(sortedBy) {
+        }
+
+        /**
+         * @brief `CREATE TABLE` statement declaring the columns.
+         */
+        std::string getSchema() const {
+          static constexpr auto declaredTypes = makeDeclaredTypes(std::make_index_sequence<COLUMN_COUNT> { });
+          std::string schema = "CREATE TABLE x(";
+          for (std::size_t i = 0; i < COLUMN_COUNT; ++i) {
+            schema += i > 0 ? ", \"" : "\"";
+            for (char c : mColumns[i]) {
+              schema += c;
+              if (c == '"') {
+                schema += '"';
+              }
+            }
+            schema += "\" ";
+            schema += declaredTypes[i];
+          }
+          schema += ")";
+          return schema;
+        }
+
+        /**
+         * @brief Whether column @p column can serve as a binary-search key.
+         */
+        static bool isKeyColumn(std::size_t column) {
+          static constexpr auto keyable = makeKeyable(std::make_index_sequence<COLUMN_COUNT> { });
+          return column < COLUMN_COUNT && keyable[column];
+        }
+
+        static const sqlite3_module* getModule() {
+          static constexpr sqlite3_module module = {
+            0,           /* iVersion */
+            nullptr,     /* xCreate: eponymous-only */
+            &connect,    /* xConnect */
+            &bestIndex,  /* xBestIndex */
+            &disconnect, /* xDisconnect */
+            &disconnect, /* xDestroy */
+            &open,       /* xOpen */
+            &close,      /* xClose */
+            &filter,     /* xFilter */
+            &next,       /* xNext */
+            &eof,        /* xEof */
+            &column,     /* xColumn */
+            &rowid,      /* xRowid */
+            nullptr,     /* xUpdate: read-only */
+            nullptr,     /* xBegin */
+            nullptr,     /* xSync */
+            nullptr,     /* xCommit */
+            nullptr,     /* xRollback */
+            nullptr,     /* xFindFunction */
+            nullptr,     /* xRename */
+            nullptr,     /* xSavepoint */
+            nullptr,     /* xRelease */
+            nullptr,     /* xRollbackTo */
+            nullptr,     /* xShadowName */
+            nullptr      /* xIntegrity */
+          };
+          return &module;
+        }
+
+      private:
+        struct Table : sqlite3_vtab {
+          SqliteRangeModule* module;
+        };
+
+        struct Filter {
+          int column;
+          int op;
+          bool binaryText;
+          sqlite3_value* value;
+        };
+
+        struct Cursor : sqlite3_vtab_cursor {
+          std::size_t current = 0;
+          std::size_t end = 0;
+          std::vector<Filter> filters;
+
+          void clearFilters() {
+            for (auto& filter : filters) {
+              sqlite3_value_free(filter.value);
+            }
+            filters.clear();
+          }
+
+          ~Cursor() {
+            clearFilters();
+          }
+        };
+
+        using ColumnFunction = void (*)(sqlite3_context*, const Row&);
+        using CompareFunction = FieldOrder (*)(const Row&, sqlite3_value*, bool);
+
+        static constexpr bool STABLE = std::is_lvalue_reference_v<std::ranges::range_reference_t<const View&>>;
+
+        template<std::size_t I>
+        using FieldType = std::remove_cvref_t<std::tuple_element_t<I, std::remove_cvref_t<decltype(sqliteRowFields(std::declval<const Row&>()))>>>;
+
+        template<std::size_t I>
+        static void columnAt(sqlite3_context* context, const Row& row) {
+          setFieldResult<STABLE>(context, std::get<I>(sqliteRowFields(row)));
+        }
+
+        template<std::size_t I>
+        static FieldOrder compareAt(const Row& row, sqlite3_value* value, bool binaryText) {
+          return compareField(std::get<I>(sqliteRowFields(row)), value, binaryText);
+        }
+
+        template<std::size_t... I>
+        static constexpr auto makeColumnFunctions(std::index_sequence<I...>) {
+          return std::array<ColumnFunction, COLUMN_COUNT> { &columnAt<I>... };
+        }
+
+        template<std::size_t... I>
+        static constexpr auto makeCompareFunctions(std::index_sequence<I...>) {
+          return std::array<CompareFunction, COLUMN_COUNT> { &compareAt<I>... };
+        }
+
+        template<std::size_t... I>
+        static constexpr auto makeDeclaredTypes(std::index_sequence<I...>) {
+          return std::array<const char*, COLUMN_COUNT> { fieldDeclaredType<FieldType<I>>()... };
+        }
+
+        // Binary search needs a total order, so nullable and dynamic fields are excluded
+        template<std::size_t... I>
+        static constexpr auto makeKeyable(std::index_sequence<I...>) {
+          return std::array<bool, COLUMN_COUNT> {
+            (std::is_arithmetic_v<FieldType<I>> || isTextField<FieldType<I>> || isBlobField<FieldType<I>>)...
+          };
+        }
+
+        static ColumnFunction columnFunction(std::size_t column) {
+          static constexpr auto functions = makeColumnFunctions(std::make_index_sequence<COLUMN_COUNT> { });
+          return functions[column];
+        }
+
+        static CompareFunction compareFunction(std::size_t column) {
+          static constexpr auto functions = makeCompareFunctions(std::make_index_sequence<COLUMN_COUNT> { });
+          return functions[column];
+        }
+
+        View mView;
+        std::vector<std::string> mColumns;
+        std::optional<std::size_t> mSortedBy;
+
+        std::size_t size() const {
+          return static_cast<std::size_t>(std::ranges::size(mView));
+        }
+
+        decltype(auto) rowAt(std::size_t index) const {
+          return std::ranges::begin(mView)[static_cast<std::ranges::range_difference_t<const View&>>(index)];
+        }
+
+        static bool isPushed(int op) {
+          return op == SQLITE_INDEX_CONSTRAINT_EQ || op == SQLITE_INDEX_CONSTRAINT_GT || op == SQLITE_INDEX_CONSTRAINT_LE
+              || op == SQLITE_INDEX_CONSTRAINT_LT || op == SQLITE_INDEX_CONSTRAINT_GE;
+        }
+
+        static bool holds(FieldOrder order, int op) {
+          switch (order) {
+            case FieldOrder::UNKNOWN:
+              return true;
+            case FieldOrder::NO_MATCH:
+              return false;
+            default:
+              break;
+          }
+          switch (op) {
+            case SQLITE_INDEX_CONSTRAINT_EQ:
+              return order == FieldOrder::EQUAL;
+            case SQLITE_INDEX_CONSTRAINT_GT:
+              return order == FieldOrder::GREATER;
+            case SQLITE_INDEX_CONSTRAINT_GE:
+              return order != FieldOrder::LESS;
+            case SQLITE_INDEX_CONSTRAINT_LT:
+              return order == FieldOrder::LESS;
+            case SQLITE_INDEX_CONSTRAINT_LE:
+              return order != FieldOrder::GREATER;
+            default:
+              return true;
+          }
+        }
+
+        bool matches(const Cursor& cursor, std::size_t index) const {
+          decltype(auto) row = rowAt(index);
+          for (const auto& filter : cursor.filters) {
+            if (!holds(compareFunction(static_cast<std::size_t>(filter.column))(row, filter.value, filter.binaryText), filter.op)) {
+              return false;
+            }
+          }
+          return true;
+        }
+
+        void skipRejected(Cursor& cursor) const {
+          while (cursor.current < cursor.end && !matches(cursor, cursor.current)) {
+            ++cursor.current;
+          }
+        }
+
+        /**
+         * @brief Narrow [@p begin, @p end) with a rowid constraint.
+         */
+        static void narrowRowid(int op, sqlite3_value* value, std::size_t& begin, std::size_t& end) {
+          std::int64_t rowid = sqlite3_value_int64(value);
+          auto clamp = [end](std::int64_t position) {
+            return position < 0 ? std::size_t { 0 } : std::min(static_cast<std::size_t>(position), end);
+          };
+          switch (op) {
+            case SQLITE_INDEX_CONSTRAINT_EQ:
+              begin = std::max(begin, clamp(rowid));
+              end = std::min(end, rowid == INT64_MAX ? end : clamp(rowid + 1));
+              break;
+            case SQLITE_INDEX_CONSTRAINT_GT:
+              begin = std::max(begin, rowid == INT64_MAX ? end : clamp(rowid + 1));
+              break;
+            case SQLITE_INDEX_CONSTRAINT_GE:
+              begin = std::max(begin, clamp(rowid));
+              break;
+            case SQLITE_INDEX_CONSTRAINT_LT:
+              end = std::min(end, clamp(rowid));
+              break;
+            case SQLITE_INDEX_CONSTRAINT_LE:
+              end = std::min(end, rowid == INT64_MAX ? end : clamp(rowid + 1));
+              break;
+          }
+          begin = std::min(begin, end);
+        }
+
+        /**
+         * @brief Narrow [@p begin, @p end) by binary search on the sorted key column.
+         */
+        void narrowKey(int op, sqlite3_value* value, bool binaryText, std::size_t& begin, std::size_t& end) const {
+          CompareFunction compare = compareFunction(*mSortedBy);
+          auto firstWhere = [&](auto predicate) {
+            auto indices = std::views::iota(begin, end);
+            return *std::ranges::partition_point(indices, [&](std::size_t index) {
+              return !predicate(compare(rowAt(index), value, binaryText));
+            });
+          };
+          auto notLess = [](FieldOrder order) {
+            return order != FieldOrder::LESS;
+          };
+          auto greater = [](FieldOrder order) {
+            return order == FieldOrder::GREATER;
+          };
+
+          switch (op) {
+            case SQLITE_INDEX_CONSTRAINT_EQ: {
+              std::size_t first = firstWhere(notLess);
+              end = firstWhere(greater);
+              begin = first;
+              break;
+            }
+            case SQLITE_INDEX_CONSTRAINT_GT:
+              begin = firstWhere(greater);
+              break;
+            case SQLITE_INDEX_CONSTRAINT_GE:
+              begin = firstWhere(notLess);
+              break;
+            case SQLITE_INDEX_CONSTRAINT_LT:
+              end = firstWhere(notLess);
+              break;
+            case SQLITE_INDEX_CONSTRAINT_LE:
+              end = firstWhere(greater);
+              break;
+          }
+          begin = std::min(begin, end);
+        }
+
+        /**
+         * @brief Whether @p value orders against every key without SQLite's type rules.
+         */
+        bool isComparableKey(sqlite3_value* value, bool binaryText) const {
+          if (size() == 0) {
+            return false;
+          }
+          FieldOrder order = compareFunction(*mSortedBy)(rowAt(0), value, binaryText);
+          return order != FieldOrder::UNKNOWN && order != FieldOrder::NO_MATCH;
+        }
+
+        static int connect(sqlite3* db, void* data, int, const char* const*, sqlite3_vtab** vtab, char** error) {
+          auto* module = static_cast<SqliteRangeModule*>(data);
+          try {
+            int result = sqlite3_declare_vtab(db, module->getSchema().c_str());
+            if (result != SQLITE_OK) {
+              return result;
+            }
+            auto* table = new Table { };
+            table->module = module;
+            *vtab = table;
+            return SQLITE_OK;
+          } catch (const std::bad_alloc&) {
+            return SQLITE_NOMEM;
+          } catch (const std::exception& e) {
+            *error = sqlite3_mprintf("%s", e.what());
+            return SQLITE_ERROR;
+          }
+        }
+
+        static int disconnect(sqlite3_vtab* vtab) {
+          delete static_cast<Table*>(vtab);
+          return SQLITE_OK;
+        }
+
+        static int bestIndex(sqlite3_vtab* vtab, sqlite3_index_info* info) {
+          auto* module = static_cast<Table*>(vtab)->module;
+          try {
+            const double rows = static_cast<double>(module->size());
+            std::string plan;
+            int argc = 0;
+            bool rowidEq = false;
+            bool keyEq = false;
+            bool narrowed = false;
+            bool filtered = false;
+
+            for (int i = 0; i < info->nConstraint; ++i) {
+              const auto& constraint = info->aConstraint[i];
+              int column = constraint.iColumn;
+              if (!constraint.usable || !isPushed(constraint.op) || column >= static_cast<int>(COLUMN_COUNT)) {
+                continue;
+              }
+
+              const char* collation = sqlite3_vtab_collation(info, i);
+              bool binaryText = !collation || sqlite3_stricmp(collation, "BINARY") == 0;
+              bool isKey = sortedColumn(module) == column;
+
+              // SQLite still checks every constraint, so pushdown only has to be conservative
+              info->aConstraintUsage[i].argvIndex = ++argc;
+              info->aConstraintUsage[i].omit = 0;
+              plan += std::to_string(column) + ',' + std::to_string(constraint.op) + ',' + (binaryText ? '1' : '0') + ';';
+
+              bool eq = constraint.op == SQLITE_INDEX_CONSTRAINT_EQ;
+              if (column < 0) {
+                rowidEq = rowidEq || eq;
+                narrowed = true;
+              } else if (isKey) {
+                keyEq = keyEq || eq;
+                narrowed = true;
+              } else {
+                filtered = true;
+              }
+            }
+
+            double lookup = std::log2(rows + 1.0) + 1.0;
+            if (rowidEq) {
+              info->estimatedRows = 1;
+              info->estimatedCost = 1.0;
+              info->idxFlags |= SQLITE_INDEX_SCAN_UNIQUE;
+            } else if (keyEq) {
+              info->estimatedRows = 10;
+              info->estimatedCost = lookup + 10.0;
+            } else if (narrowed) {
+              info->estimatedRows = static_cast<sqlite3_int64>(rows / 4.0) + 1;
+              info->estimatedCost = lookup + rows / 4.0;
+            } else {
+              info->estimatedRows = static_cast<sqlite3_int64>(filtered ? rows / 10.0 : rows) + 1;
+              info->estimatedCost = filtered ? rows * 0.75 : rows;
+            }
+
+            if (info->nOrderBy == 1 && !info->aOrderBy[0].desc
+                && (info->aOrderBy[0].iColumn < 0 || info->aOrderBy[0].iColumn == sortedColumn(module))) {
+              info->orderByConsumed = 1;
+            }
+
+            if (!plan.empty()) {
+              info->idxStr = sqlite3_mprintf("%s", plan.c_str());
+              if (!info->idxStr) {
+                return SQLITE_NOMEM;
+              }
+              info->needToFreeIdxStr = 1;
+            }
+            return SQLITE_OK;
+          } catch (const std::bad_alloc&) {
+            return SQLITE_NOMEM;
+          }
+        }
+
+        static int sortedColumn(const SqliteRangeModule* module) {
+          return module->mSortedBy ? static_cast<int>(*module->mSortedBy) : -2;
+        }
+
+        static int open(sqlite3_vtab*, sqlite3_vtab_cursor** cursor) {
+          try {
+            *cursor = new Cursor { };
+            return SQLITE_OK;
+          } catch (const std::bad_alloc&) {
+            return SQLITE_NOMEM;
+          }
+        }
+
+        static int close(sqlite3_vtab_cursor* cursor) {
+          delete static_cast<Cursor*>(cursor);
+          return SQLITE_OK;
+        }
+
+        static int filter(sqlite3_vtab_cursor* base, int, const char* plan, int argc, sqlite3_value** argv) {
+          auto* cursor = static_cast<Cursor*>(base);
+          auto* module = static_cast<Table*>(base->pVtab)->module;
+          try {
+            cursor->clearFilters();
+            std::size_t begin = 0;
+            std::size_t end = module->size();
+
+            const char* p = plan ? plan : "";
+            for (int arg = 0; arg < argc && *p; ++arg) {
+              char* next = nullptr;
+              int column = static_cast<int>(std::strtol(p, &next, 10));
+              int op = static_cast<int>(std::strtol(next + 1, &next, 10));
+              bool binaryText = next[1] == '1';
+              p = next + 3;
+
+              sqlite3_value* value = argv[arg];
+              if (column < 0) {
+                if (sqlite3_value_type(value) == SQLITE_INTEGER) {
+                  narrowRowid(op, value, begin, end);
+                }
+              } else if (sortedColumn(module) == column && module->isComparableKey(value, binaryText)) {
+                module->narrowKey(op, value, binaryText, begin, end);
+              } else {
+                sqlite3_value* copy = sqlite3_value_dup(value);
+                if (!copy) {
+                  return SQLITE_NOMEM;
+                }
+                cursor->filters.push_back(Filter { column, op, binaryText, copy });
+              }
+            }
+
+            cursor->current = begin;
+            cursor->end = end;
+            module->skipRejected(*cursor);
+            return SQLITE_OK;
+          } catch (const std::bad_alloc&) {
+            return SQLITE_NOMEM;
+          }
+        }
+
+        static int next(sqlite3_vtab_cursor* base) {
+          auto* cursor = static_cast<Cursor*>(base);
+          ++cursor->current;
+          static_cast<Table*>(base->pVtab)->module->skipRejected(*cursor);
+          return SQLITE_OK;
+        }
+
+        static int eof(sqlite3_vtab_cursor* base) {
+          auto* cursor = static_cast<Cursor*>(base);
+          return cursor->current >= cursor->end ? 1 : 0;
+        }
+
+        static int column(sqlite3_vtab_cursor* base, sqlite3_context* context, int column) {
+          auto* cursor = static_cast<Cursor*>(base);
+          auto* module = static_cast<Table*>(base->pVtab)->module;
+          try {
+            columnFunction(static_cast<std::size_t>(column))(context, module->rowAt(cursor->current));
+          } catch (const std::bad_alloc&) {
+            return SQLITE_NOMEM;
+          }
+          return SQLITE_OK;
+        }
+
+        static int rowid(sqlite3_vtab_cursor* base, sqlite3_int64* rowid) {
+          *rowid = static_cast<sqlite3_int64>(static_cast<Cursor*>(base)->current);
+          return SQLITE_OK;
+        }
+    };
+
+  } /* namespace detail */
+
+} /* namespace sdb */
+
+#endif /* INCLUDE_SQLITERANGETABLE_HPP_ */
@@ -0,0 +1,200 @@
+#ifndef INCLUDE_SQLITERESULT_HPP_
+#define INCLUDE_SQLITERESULT_HPP_
+
+/**
+ * @file SqliteResult.hpp
+ * @brief Error values for the non-throwing `try*` API.
+ */
+
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace sdb {
+
+  /**
+   * @brief SQLite result code of a failed call, with its message built on demand.
+   *
+   * Creating one copies three integers and a pointer to a string literal;
+   * nothing is allocated or formatted until message() is called.  SQLite's
+   * per-connection text (`sqlite3_errmsg`) is overwritten by the next call,
+   * so read it with `SqliteDb::getErrorMessage()` right away if needed.
+   */
+  class SqliteError {
+    public:
+      SqliteError(int extendedCode, const char* operation, int index = 0) noexcept
+        : mExtendedCode(extendedCode)
+        , mIndex(index)
+        , mOperation(operation) {
+      }
+
+      /**
+       * @brief Primary result code, e.g. SQLITE_BUSY.
+       */
+      int code() const noexcept {
+        return mExtendedCode & 0xff;
+      }
+
+      /**
+       * @brief Extended result code, e.g. SQLITE_BUSY_SNAPSHOT.
+       */
+      int extendedCode() const noexcept {
+        return mExtendedCode;
+      }
+
+      /**
+       * @brief SQLITE_BUSY or SQLITE_LOCKED: retrying later may succeed.
+       */
+      bool isBusy() const noexcept;
+
+      /**
+       * @brief Name of the failed operation ("step", "bind", "prepare"...).
+       */
+      const char* operation() const noexcept {
+        return mOperation;
+      }
+
+      /**
+       * @brief 1-based parameter index for bind errors, 0 otherwise.
+       */
+      int index() const noexcept {
+        return mIndex;
+      }
+
+      /**
+       * @brief "<operation>[ at index N]: <sqlite3_errstr>".
+       */
+      std::string message() const;
+
+      /**
+       * @brief Throw the `SqliteStatementException` the throwing API would have raised.
+       */
+      [[noreturn]] void raise() const;
+
+    private:
+      int mExtendedCode;
+      int mIndex;
+      const char* mOperation;
+  };
+
+  /**
+   * @brief Value of a `try*` call, or the `SqliteError` it failed with.
+   *
+   * A small `std::expected` stand-in for C++20.  value() throws on an
+   * error, so the result can also be unwrapped where failing is exceptional.
+   */
+  template<typename T>
+  class [[nodiscard]] SqliteResult {
+    public:
+      SqliteResult(T value)
+        : mValue(std::in_place_index<0>, std::move(value)) {
+      }
+
+      SqliteResult(SqliteError error) noexcept
+        : mValue(std::in_place_index<1>, error) {
+      }
+
+      bool hasValue() const noexcept {
+        return mValue.index() == 0;
+      }
+
+      explicit operator bool() const noexcept {
+        return hasValue();
+      }
+
+      T& value() & {
+        checkValue();
+        return *std::get_if<0>(&mValue);
+      }
+
+      const T& value() const& {
+        checkValue();
+        return *std::get_if<0>(&mValue);
+      }
+
+      T&& value() && {
+        checkValue();
+        return std::move(*std::get_if<0>(&mValue));
+      }
+
+      /** Unchecked access; only valid when hasValue(). */
+      T& operator*() & noexcept {
+        return *std::get_if<0>(&mValue);
+      }
+
+      const T& operator*() const& noexcept {
+        return *std::get_if<0>(&mValue);
+      }
+
+      T* operator->() noexcept {
+        return std::get_if<0>(&mValue);
+      }
+
+      const T* operator->() const noexcept {
+        return std::get_if<0>(&mValue);
+      }
+
+      /** Only valid when !hasValue(). */
+      const SqliteError& error() const noexcept {
+        return *std::get_if<1>(&mValue);
+      }
+
+      template<typename U>
+      T valueOr(U&& fallback) const& {
+        return hasValue() ? **this : static_cast<T>(std::forward<U>(fallback));
+      }
+
+    private:
+      std::variant<T, SqliteError> mValue;
+
+      void checkValue() const {
+        if (!hasValue()) {
+          error().raise();
+        }
+      }
+  };
+
+  /**
+   * @brief Success, or the `SqliteError` a `try*` call failed with.
+   */
+  template<>
+  class [[nodiscard]] SqliteResult<void> {
+    public:
+      SqliteResult() noexcept
+        : mError(0, nullptr)
+        , mFailed(false) {
+      }
+
+      SqliteResult(SqliteError error) noexcept
+        : mError(error)
+        , mFailed(true) {
+      }
+
+      bool hasValue() const noexcept {
+        return !mFailed;
+      }
+
+      explicit operator bool() const noexcept {
+        return hasValue();
+      }
+
+      void value() const {
+        if (mFailed) {
+          mError.raise();
+        }
+      }
+
+      /** Only valid when !hasValue(). */
+      const SqliteError& error() const noexcept {
+        return mError;
+      }
+
+    private:
+      SqliteError mError;
+      bool mFailed;
+  };
+
+} /* namespace sdb */
+
+#endif /* INCLUDE_SQLITERESULT_HPP_ */
@@ -0,0 +1,233 @@
+#ifndef INCLUDE_SQLITERESULTCACHE_HPP_
+#define INCLUDE_SQLITERESULTCACHE_HPP_
+
+/**
+ * @file SqliteResultCache.hpp
+ * @brief Memory-capped LRU cache of query results with table-level invalidation.
+ */
+
+#include <SqliteChangeListener.hpp>
+#include <SqliteTypes.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace sdb {
+
+  class SqliteDb;
+
+  namespace detail {
+
+    /**
+     * @brief One cell of a cached result: 16 bytes, text and blobs in the arena.
+     */
+    struct SqliteResultCell {
+      union {
+        std::int64_t integer;
+        double real;
+        std::size_t offset;
+      };
+      std::uint32_t size;
+      /** SQLITE_INTEGER, SQLITE_FLOAT, SQLITE_TEXT, SQLITE_BLOB or SQLITE_NULL. */
+      std::uint8_t type;
+    };
+
+    /**
+     * @brief Immutable result set: row-major cells plus one byte arena.
+     */
+    struct SqliteResultData {
+      std::vector<std::string> columnNames;
+      std::size_t rows = 0;
+      std::vector<SqliteResultCell> cells;
+      std::vector<std::byte> arena;
+
+      std::size_t getMemoryUsed() const noexcept;
+    };
+
+  } /* namespace detail */
+
+  /**
+   * @brief Result of `SqliteDb::cachedQuery()`, served from the cache or freshly run.
+   *
+   * Holds a reference on the immutable result, so views returned by the
+   * accessors stay valid for the lifetime of this object even if the entry
+   * is evicted or invalidated.  Integers and reals convert into each other
+   * and NULL reads as 0 or empty; reading text or a blob as a number, or a
+   * number as text, throws `SqliteStatementException`.
+   */
+  class SqliteCachedResult {
+    public:
+      std::size_t getRowCount() const noexcept;
+      int getColumnCount() const noexcept;
+      const std::string& getColumnName(int column) const;
+
+      /**
+       * @brief Whether the result came from the cache without running the query.
+       */
+      bool isHit() const noexcept {
+        return mHit;
+      }
+
+      bool isNull(std::size_t row, int column) const;
+      std::int64_t getInt64(std::size_t row, int column) const;
+      double getDouble(std::size_t row, int column) const;
+      std::string_view getStringView(std::size_t row, int column) const;
+      std::span<const std::byte> getBlobSpan(std::size_t row, int column) const;
+      SqliteValue getValue(std::size_t row, int column) const;
+
+    private:
+      friend class SqliteResultCache;
+
+      SqliteCachedResult(std::shared_ptr<const detail::SqliteResultData> data, bool hit)
+        : mData(std::move(data))
+        , mHit(hit) {
+      }
+
+      const detail::SqliteResultCell& cell(std::size_t row, int column) const;
+
+      std::shared_ptr<const detail::SqliteResultData> mData;
+      bool mHit;
+  };
+
+  /**
+   * @brief Per-connection cache of read-only query results.
+   *
+   * Installed with `SqliteDb::enableResultCache()` and used through
+   * `SqliteDb::cachedQuery()`.  Results are keyed by SQL text and bound
+   * parameters.  A hit is a hash lookup and a few counter compares (plus
+   * the data_version check below): the statement is not stepped.
+   *
+   * The tables a query reads are captured once per SQL text with an
+   * authorizer while it is prepared.  Every table name has a version counter:
+   * the update hook bumps it when a row changes on this connection, and an
+   * entry is stale once any table it read has moved on.  Changes the update
+   * hook misses (WITHOUT ROWID tables, truncating deletes) are caught by
+   * comparing `sqlite3_total_changes64()` with the hooked row count, and then
+   * invalidate every entry.  Commits from other connections are detected
+   * with `PRAGMA data_version` when `detectExternalWrites` is set, per
+   * schema read.  Results are not stored while the current transaction has
+   * uncommitted changes.  DDL run through this connection is not tracked;
+   * call clear() after it.
+   *
+   * Queries must be deterministic: SQL using `random()`, `'now'` or
+   * non-deterministic functions would be served stale.
+   */
+  class SqliteResultCache : public SqliteChangeListener {
+    public:
+      struct Options {
+        /** Upper bound on the memory held by cached results, in bytes. */
+        std::size_t maxBytes = std::size_t(64) << 20;
+        /** Results larger than this are returned but not cached. */
+        std::size_t maxEntryBytes = std::size_t(4) << 20;
+        /** Check `PRAGMA data_version` on every hit to see other connections'
+         *  commits; costs one small statement per schema read. */
+        bool detectExternalWrites = true;
+      };
+
+      struct Stats {
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        /** Misses whose result was stored. */
+        std::uint64_t stores = 0;
+        /** Entries found stale on lookup and dropped. */
+        std::uint64_t invalidations = 0;
+        /** Entries dropped to stay under `maxBytes`. */
+        std::uint64_t evictions = 0;
+        std::size_t entries = 0;
+        std::size_t bytes = 0;
+
+        double hitRatio() const noexcept {
+          std::uint64_t lookups = hits + misses;
+          return lookups == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(lookups);
+        }
+      };
+
+      SqliteResultCache(SqliteDb& db, Options options);
+
+      SqliteResultCache(const SqliteResultCache&) = delete;
+      SqliteResultCache& operator=(const SqliteResultCache&) = delete;
+
+      Stats getStats() const;
+
+      /**
+       * @brief Drop every entry, e.g. after DDL.
+       */
+      void clear();
+
+      /**
+       * @brief Mark @p table as changed, for writes the hooks cannot see.
+       */
+      void invalidate(const std::string& table);
+
+      void onUpdate(ChangeOperation operation, std::string_view schema, std::string_view table,
+                    std::int64_t rowid) override;
+      void onCommit() override;
+      void onRollback() override;
+
+    private:
+      friend class SqliteDb;
+
+      using Counter = std::atomic<std::uint64_t>;
+
+      /** What an SQL text depends on, captured once when it is first planned. */
+      struct Plan {
+        std::vector<Counter*> tables;
+        std::vector<std::string> schemas;
+      };
+
+      /** Dependency versions observed before a result was computed. */
+      struct Snapshot {
+        std::uint64_t epoch = 0;
+        std::vector<std::uint64_t> tables;
+        std::vector<std::int64_t> dataVersions;
+      };
+
+      struct Entry {
+        std::string key;
+        std::shared_ptr<const detail::SqliteResultData> data;
+        std::shared_ptr<const Plan> plan;
+        Snapshot snapshot;
+        std::size_t bytes = 0;
+      };
+
+      SqliteDb& mDb;
+      Options mOptions;
+
+      mutable std::mutex mMutex;
+      std::list<Entry> mEntries;
+      std::unordered_map<std::string_view, std::list<Entry>::iterator> mIndex;
+      std::unordered_map<std::string, std::shared_ptr<const Plan>> mPlans;
+      std::unordered_map<std::string, Counter> mTableVersions;
+      Stats mStats;
+
+      Counter mEpoch { 0 };
+      Counter mHookedChanges { 0 };
+      std::atomic<std::int64_t> mUnhookedChanges { 0 };
+      std::atomic<bool> mDirty { false };
+
+      // Only touched from the update hook, which SQLite serializes
+      std::string mLastTable;
+      Counter* mLastCounter = nullptr;
+
+      SqliteCachedResult query(const std::string& sql, const std::vector<SqliteValue>& parameters);
+      std::shared_ptr<const Plan> planFor(const std::string& sql);
+      Snapshot takeSnapshot(const Plan& plan);
+      void checkUnhookedChanges();
+      Counter& tableCounter(std::string key);
+      void store(Entry entry);
+      void eraseEntry(std::list<Entry>::iterator it);
+
+      static std::string makeKey(const std::string& sql, const std::vector<SqliteValue>& parameters);
+  };
+
+} /* namespace sdb */
+
+#endif /* INCLUDE_SQLITERESULTCACHE_HPP_ */
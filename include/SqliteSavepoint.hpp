@@ -0,0 +1,95 @@
+#ifndef INCLUDE_SQLITESAVEPOINT_HPP_
+#define INCLUDE_SQLITESAVEPOINT_HPP_
+
+/**
+ * @file SqliteSavepoint.hpp
+ * @brief RAII wrapper for nested transactions built on SQLite savepoints.
+ */
+
+#include <cstddef>
+
+namespace sdb {
+
+  class SqliteDb;
+
+  /**
+   * @brief Lightweight RAII wrapper for an SQLite SAVEPOINT.
+   *
+   * A savepoint nests inside an open `SqliteTransaction` or inside another
+   * savepoint; opened outside any transaction it starts a deferred one of
+   * its own.  It is rolled back to and released on destruction unless
+   * `release()` was called.  Savepoints are named after their nesting depth
+   * so that the same few statements are reused from the statement cache,
+   * which requires savepoints of one connection to end in reverse order of
+   * creation.
+   *
+   * Example usage:
+   * @code
+   *   sdb::SqliteTransaction trans(*db);
+   *   db->execute("INSERT INTO orders (id) VALUES (1)");
+   *   {
+   *     sdb::SqliteSavepoint savepoint(*db);
+   *     db->execute("INSERT INTO audit (order_id) VALUES (1)");
+   *     // leaving the scope without release() undoes only the audit row
+   *   }
+   *   trans.commit();
+   * @endcode
+   */
+  class SqliteSavepoint {
+    public:
+      /**
+       * @brief Open a savepoint one level deeper than the innermost active one.
+       * @param sqliteDb Reference to the database object.
+       * @throws sdb::SqliteTransactionException if the savepoint cannot be opened.
+       */
+      explicit SqliteSavepoint(SqliteDb& sqliteDb);
+
+      SqliteSavepoint(const SqliteSavepoint&) = delete;
+      SqliteSavepoint& operator=(const SqliteSavepoint&) = delete;
+
+      /**
+       * @brief Roll back to and release the savepoint if it is still active.
+       *
+       * Errors are suppressed to avoid terminating the program during stack
+       * unwinding.
+       */
+      ~SqliteSavepoint();
+
+      /**
+       * @brief Release the savepoint, merging its changes into the enclosing transaction.
+       * @throws sdb::SqliteTransactionException if the release fails.
+       */
+      void release();
+
+      /**
+       * @brief Undo every change made since the savepoint was opened, then release it.
+       *
+       * The change capture, if any, drops the records of the undone changes.
+       *
+       * @throws sdb::SqliteTransactionException if the rollback fails.
+       */
+      void rollback();
+
+      /**
+       * @brief Checks whether the savepoint has not been released or rolled back yet.
+       */
+      bool isActive() const noexcept;
+
+      /**
+       * @brief Nesting depth of this savepoint, starting at 1.
+       */
+      std::size_t getDepth() const noexcept;
+
+    private:
+      SqliteDb& mSqliteDb;
+      std::size_t mDepth;
+      bool mActive;
+      /** Records the change capture had buffered when the savepoint opened. */
+      std::size_t mChangeMark = 0;
+
+      void finish(bool commit);
+  };
+
+} /* namespace sdb */
+
+#endif /* INCLUDE_SQLITESAVEPOINT_HPP_ */
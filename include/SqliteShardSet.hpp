@@ -0,0 +1,303 @@
+#ifndef INCLUDE_SQLITESHARDSET_HPP_
+#define INCLUDE_SQLITESHARDSET_HPP_
+
+/**
+ * @file SqliteShardSet.hpp
+ * @brief Parallel fan-out of one query over many database files.
+ */
+
+#include <SqliteDb.hpp>
+#include <SqliteTypes.hpp>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace sdb {
+
+  namespace detail {
+    class SqliteShardPool;
+    struct SqliteShardQuery;
+  }
+
+  /**
+   * @brief Total order used to merge shard results.
+   *
+   * Matches SQLite's ORDER BY with the BINARY collation: NULL first, then
+   * integers and reals compared numerically, then text, then blobs.
+   *
+   * @return Negative, zero or positive like `memcmp`.
+   */
+  int compareSqliteValues(const SqliteValue& left, const SqliteValue& right) noexcept;
+
+  /**
+   * @brief Streaming, merged result of a query run on every shard.
+   *
+   * Rows are produced by the shard set's worker threads in chunks and
+   * consumed here as they arrive.  Each shard buffers a bounded number of
+   * chunks ahead of the consumer; stepping pauses until the consumer catches
+   * up.  Destroying the cursor early cancels the remaining work.  A cursor
+   * must not outlive its `SqliteShardSet`.
+   */
+  class SqliteShardCursor {
+    public:
+      using Row = std::span<const SqliteValue>;
+
+      /**
+       * @brief Input iterator over the remaining rows.
+       */
+      class Iterator {
+        public:
+          using iterator_concept = std::input_iterator_tag;
+          using value_type = Row;
+          using difference_type = std::ptrdiff_t;
+
+          Iterator() = default;
+
+          Row operator*() const {
+            return mCursor->getRow();
+          }
+
+          Iterator& operator++() {
+            if (!mCursor->next()) {
+              mCursor = nullptr;
+            }
+            return *this;
+          }
+
+          void operator++(int) {
+            ++*this;
+          }
+
+          friend bool operator==(const Iterator& it, std::default_sentinel_t) noexcept {
+            return it.mCursor == nullptr;
+          }
+
+        private:
+          friend class SqliteShardCursor;
+
+          explicit Iterator(SqliteShardCursor* cursor)
+            : mCursor(cursor) {
+          }
+
+          SqliteShardCursor* mCursor = nullptr;
+      };
+
+      SqliteShardCursor(SqliteShardCursor&&) noexcept;
+      SqliteShardCursor& operator=(SqliteShardCursor&&) noexcept;
+      SqliteShardCursor(const SqliteShardCursor&) = delete;
+      SqliteShardCursor& operator=(const SqliteShardCursor&) = delete;
+
+      /**
+       * @brief Cancel the query; shards stop at their next chunk boundary.
+       */
+      ~SqliteShardCursor();
+
+      /**
+       * @brief Advance to the next merged row, waiting for the shards if needed.
+       * @return false once every shard is exhausted, and on every later call.
+       * @throws sdb::SqliteStatementException (or any error) raised by a shard.
+       */
+      bool next();
+
+      /**
+       * @brief Current row, valid until the next call to `next()`.
+       * @throws sdb::SqliteDbException if the last `next()` did not return true.
+       */
+      Row getRow() const;
+
+      /**
+       * @brief Column of the current row.
+       * @throws sdb::SqliteDbException if the last `next()` did not return true.
+       */
+      const SqliteValue& getValue(int column) const;
+
+      /**
+       * @brief Number of result columns, known after the first `next()`.
+       */
+      int getColumnCount() const noexcept;
+
+      /**
+       * @brief Shard the current row comes from.
+       */
+      std::size_t getShard() const noexcept;
+
+      /**
+       * @brief Advance and return an iterator on the first row.
+       */
+      Iterator begin() {
+        return Iterator(next() ? this : nullptr);
+      }
+
+      std::default_sentinel_t end() const noexcept {
+        return { };
+      }
+
+    private:
+      friend class SqliteShardSet;
+
+      explicit SqliteShardCursor(std::shared_ptr<detail::SqliteShardQuery> query);
+
+      std::shared_ptr<detail::SqliteShardQuery> mQuery;
+
+      void checkRow() const;
+  };
+
+  /**
+   * @brief One connection per shard file and a work-stealing pool to query them.
+   *
+   * The same SQL is prepared on every shard and stepped in parallel.  Each
+   * shard is a resumable task that steps up to `chunkRows` rows and is then
+   * requeued, so a pool smaller than the shard count still interleaves every
+   * shard, and idle workers steal queued shards from busy ones.  Results are
+   * merged through `SqliteShardCursor` in arrival order, or by an ordered
+   * k-way merge when the query is sorted, and `aggregate()` combines
+   * per-shard partial aggregates into one result.
+   *
+   * A shard connection is stepped by at most one worker at a time for a
+   * given query.  Connections are opened in the default serialized mode so
+   * several queries, or direct use through `getShard()`, may overlap.
+   *
+   * Example usage:
+   * @code
+   *   sdb::SqliteShardSet shards(paths);
+   *
+   *   sdb::SqliteShardSet::QueryOptions byTime;
+   *   byTime.orderBy = { { 0 } };
+   *   byTime.parameters = { sdb::sqliteValue(since) };
+   *   auto events = shards.query("SELECT ts, tenant, kind FROM events WHERE ts >= ? ORDER BY ts", byTime);
+   *   for (auto row : events) {
+   *     // rows of all shards, in global ts order
+   *   }
+   *
+   *   using C = sdb::SqliteShardSet::Combine;
+   *   auto perKind = shards.aggregate("SELECT kind, count(*), max(ts) FROM events GROUP BY kind",
+   *                                   { C::GROUP, C::SUM, C::MAX });
+   * @endcode
+   */
+  class SqliteShardSet {
+    public:
+      struct Options {
+        /** How every shard is opened. */
+        SqliteDb::OpenOptions open;
+        /** Setup hook run on every shard connection (PRAGMAs, functions...). */
+        std::function<void(SqliteDb&, std::size_t shard)> onConnect;
+        /** Worker threads; 0 uses one per hardware thread, at most one per shard. */
+        std::size_t threads = 0;
+        /** Rows stepped per task before the shard is requeued. */
+        std::size_t chunkRows = 512;
+        /** Chunks a shard may buffer ahead of the consumer before it pauses. */
+        std::size_t maxBufferedChunks = 4;
+      };
+
+      struct SortKey {
+        /** 0-based result column. */
+        int column;
+        bool descending = false;
+      };
+
+      struct QueryOptions {
+        /** Values bound to the statement's parameters, in order, on every shard. */
+        std::vector<SqliteValue> parameters;
+        /**
+         * Merge order.  Each shard's SQL must already return its rows in that
+         * order (a matching ORDER BY); the shards are then k-way merged.
+         * Empty: rows are returned as shards produce them.
+         */
+        std::vector<SortKey> orderBy;
+      };
+
+      /**
+       * @brief How `aggregate()` combines one result column across shards.
+       */
+      enum class Combine {
+        /** Grouping key: rows with equal keys are combined. */
+        GROUP,
+        /** Sum of the partial values; NULL partials are skipped. */
+        SUM,
+        /** Sum of partial counts; same as SUM, but 0 when every shard returned NULL. */
+        COUNT,
+        /** Smallest partial value, NULL partials skipped. */
+        MIN,
+        /** Largest partial value, NULL partials skipped. */
+        MAX
+      };
+
+      /**
+       * @brief Open one connection per shard and start the worker threads.
+       * @throws sdb::SqliteDbException if a shard cannot be opened.
+       */
+      explicit SqliteShardSet(const std::vector<std::filesystem::path>& shards);
+
+      /**
+       * @brief Open one connection per shard and start the worker threads.
+       * @throws sdb::SqliteDbException if a shard cannot be opened.
+       */
+      SqliteShardSet(const std::vector<std::filesystem::path>& shards, Options options);
+
+      SqliteShardSet(const SqliteShardSet&) = delete;
+      SqliteShardSet& operator=(const SqliteShardSet&) = delete;
+
+      /**
+       * @brief Stop the worker threads and close every shard.  Queries still
+       *        running are abandoned.
+       */
+      ~SqliteShardSet();
+
+      /**
+       * @brief Run @p sql on every shard and merge the results as they arrive.
+       */
+      SqliteShardCursor query(const std::string& sql);
+
+      /**
+       * @brief Run @p sql on every shard, bound and merged as told by @p options.
+       * @throws sdb::SqliteStatementException if a parameter count does not
+       *         match or a sort column is out of range.
+       */
+      SqliteShardCursor query(const std::string& sql, const QueryOptions& options);
+
+      /**
+       * @brief Run a partial aggregate on every shard and combine the partials.
+       *
+       * AVG cannot be combined; select `sum(x), count(x)` and divide.
+       *
+       * @param combine One entry per result column.
+       * @return One row per distinct GROUP key, sorted by key; a single row
+       *         when there is no GROUP column.
+       * @throws sdb::SqliteStatementException if @p combine does not match the
+       *         result columns, or any error raised by a shard.
+       */
+      std::vector<std::vector<SqliteValue>> aggregate(const std::string& sql, const std::vector<Combine>& combine);
+
+      /**
+       * @brief Like aggregate(const std::string&, const std::vector<Combine>&)
+       *        with bound parameters; `orderBy` is ignored.
+       */
+      std::vector<std::vector<SqliteValue>> aggregate(const std::string& sql, const std::vector<Combine>& combine,
+                                                      const QueryOptions& options);
+
+      std::size_t getShardCount() const noexcept;
+
+      /**
+       * @brief Connection of shard @p index, for setup or per-shard writes.
+       */
+      SqliteDb& getShard(std::size_t index);
+
+      /**
+       * @brief Number of worker threads.
+       */
+      std::size_t getThreadCount() const noexcept;
+
+    private:
+      Options mOptions;
+      std::vector<std::unique_ptr<SqliteDb>> mShards;
+      std::unique_ptr<detail::SqliteShardPool> mPool;
+  };
+
+} /* namespace sdb */
+
+#endif /* INCLUDE_SQLITESHARDSET_HPP_ */
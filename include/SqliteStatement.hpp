@@ -8,12 +8,28 @@
  * methods. All methods throw `SqliteException` on SQLite errors.
  */
 
+#include <SqliteColumnar.hpp>
+#include <SqliteException.hpp>
+#include <SqlitePlan.hpp>
+#include <SqliteResult.hpp>
+#include <SqliteTraits.hpp>
 #include <SqliteTypes.hpp>
+#include <functional>
+#include <iterator>
 #include <optional>
+#include <ranges>
+#include <span>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace sdb {
 
+template<SqliteReadable... Ts>
+class SqliteRowRange;
+
 /**
  * @brief Represents a compiled SQLite statement.
  */
@@ -67,12 +83,39 @@ public:
      */
     void bind(int index, const std::vector<std::byte>& blob);
 
+    /**
+     *  @brief Bind a string view.
+     *  @param index 1‑based index.
+     *  @param value Text, not necessarily null‑terminated.
+     *  @param lifetime `BindLifetime::STATIC` skips SQLite's copy of the text.
+     */
+    void bind(int index, std::string_view value, BindLifetime lifetime = BindLifetime::TRANSIENT);
+
+    /**
+     *  @brief Bind a binary blob from a span.
+     *  @param index 1‑based index.
+     *  @param blob Bytes to bind.
+     *  @param lifetime `BindLifetime::STATIC` skips SQLite's copy of the bytes.
+     */
+    void bind(int index, std::span<const std::byte> blob, BindLifetime lifetime = BindLifetime::TRANSIENT);
+
     /**
      *  @brief Bind a NULL value.
      *  @param index 1‑based index.
      */
     void bindNull(int index);
 
+    /**
+     *  @brief Bind a blob of @p size zero bytes without allocating it.
+     *
+     *  Used to reserve space for a large value that is then filled in
+     *  chunks through `SqliteBlobStream`.
+     *
+     *  @param index 1‑based index.
+     *  @param size Blob size in bytes.
+     */
+    void bindZeroBlob(int index, std::uint64_t size);
+
     /**
      *  @brief Bind a variadic list of arguments.
      *  @tparam Args Argument types.
@@ -81,6 +124,35 @@ public:
     template<typename... Args>
     void bindAll(Args&&... args);
 
+    /**
+     *  @brief Non-throwing bind(); one overload per `bind` overload.
+     *
+     *  Nothing is formatted or allocated on failure.
+     *
+     *  @return Success, or the SQLite error (SQLITE_RANGE for a bad index).
+     */
+    SqliteResult<void> tryBind(int index, int value) noexcept;
+    SqliteResult<void> tryBind(int index, std::int64_t value) noexcept;
+    SqliteResult<void> tryBind(int index, double value) noexcept;
+    SqliteResult<void> tryBind(int index, const std::string& value) noexcept;
+    SqliteResult<void> tryBind(int index, const char* value) noexcept;
+    SqliteResult<void> tryBind(int index, const std::vector<std::byte>& blob) noexcept;
+    SqliteResult<void> tryBind(int index, std::string_view value, BindLifetime lifetime = BindLifetime::TRANSIENT) noexcept;
+    SqliteResult<void> tryBind(int index, std::span<const std::byte> blob, BindLifetime lifetime = BindLifetime::TRANSIENT) noexcept;
+
+    /**
+     *  @brief Non-throwing bindNull().
+     */
+    SqliteResult<void> tryBindNull(int index) noexcept;
+
+    /**
+     *  @brief Non-throwing bindAll() for the types accepted by tryBind().
+     *  @return Success, or the error of the first parameter that failed;
+     *          later parameters are left unbound.
+     */
+    template<typename... Args>
+    SqliteResult<void> tryBindAll(Args&&... args) noexcept;
+
     /**
      *  @brief Retrieve an integer column by index.
      *  @param column 0‑based column index.
@@ -117,6 +189,31 @@ public:
      */
     std::vector<std::byte> getBlob(int column) const;
 
+    /**
+     *  @brief Retrieve a string column by index without copying it.
+     *  @param column 0‑based index.
+     *  @return View into SQLite's column buffer, valid until the next
+     *          `step()` or `reset()`.  Debug builds throw when there is no
+     *          current row; reading the view after that point is not caught.
+     */
+    std::string_view getStringView(int column) const;
+
+    /**
+     *  @brief Retrieve a binary blob column by index without copying it.
+     *  @param column 0‑based index.
+     *  @return Span over SQLite's column buffer, valid until the next
+     *          `step()` or `reset()`.  Debug builds throw when there is no
+     *          current row; reading the span after that point is not caught.
+     */
+    std::span<const std::byte> getBlobSpan(int column) const;
+
+    /**
+     *  @brief Retrieve a column by index as its storage class.
+     *  @param column 0‑based index.
+     *  @return NULL, integer, real, text or blob, copied out of SQLite.
+     */
+    SqliteValue getValue(int column) const;
+
     /**
      *  @brief Check if a column is NULL by index.
      *  @param column 0‑based index.
@@ -159,6 +256,20 @@ public:
      */
     std::vector<std::byte> getBlob(const std::string& columnName) const;
 
+    /**
+     *  @brief Retrieve a string by column name without copying it.
+     *  @param columnName Column name.
+     *  @return View valid until the next `step()` or `reset()`.
+     */
+    std::string_view getStringView(const std::string& columnName) const;
+
+    /**
+     *  @brief Retrieve a blob by column name without copying it.
+     *  @param columnName Column name.
+     *  @return Span valid until the next `step()` or `reset()`.
+     */
+    std::span<const std::byte> getBlobSpan(const std::string& columnName) const;
+
     /**
      *  @brief Check if a column is NULL by name.
      *  @param columnName Column name.
@@ -172,6 +283,47 @@ public:
      */
     std::string getSql() const;
 
+    /**
+     *  @brief Run `EXPLAIN QUERY PLAN` on this statement.
+     *
+     *  The statement is reset and temporarily switched to explain mode with
+     *  `sqlite3_stmt_explain`, so its SQL is not parsed again and its
+     *  bindings are kept.
+     *
+     *  @return The plan as a tree.
+     *  @throws sdb::SqliteStatementException if the plan cannot be produced.
+     */
+    SqlitePlan explainPlan();
+
+    /**
+     *  @brief Step up to @p batchRows rows and return them column by column.
+     *
+     *  Values are copied straight from SQLite into contiguous typed
+     *  buffers, without building a `std::string` or `std::vector` per cell.
+     *  Each column's type comes from its declared type affinity, or from
+     *  the first value of the batch for expressions and untyped columns;
+     *  values of another storage class are converted by SQLite.  Call
+     *  repeatedly until a batch with 0 rows is returned; reset() the
+     *  statement to run it again.
+     *
+     *  @param batchRows Maximum rows in the batch.
+     *  @return The batch, with `rows < batchRows` once the result is exhausted.
+     *  @throws sdb::SqliteStatementException if stepping fails or a text/blob
+     *    column exceeds 2 GiB in one batch.
+     */
+    SqliteColumnarBatch fetchColumnar(std::size_t batchRows);
+
+    /**
+     *  @brief Like fetchColumnar(std::size_t) with explicit column types.
+     *
+     *  Use it to keep types identical across batches when a column may
+     *  start with NULLs.  Empty batches carry these types too; without
+     *  them, every column of an empty batch is INT64.
+     *
+     *  @param types One type per result column.
+     */
+    SqliteColumnarBatch fetchColumnar(std::size_t batchRows, const std::vector<SqliteColumnType>& types);
+
     /**
      *  @brief Number of parameters in the statement.
      *  @return Parameter count.
@@ -191,6 +343,20 @@ public:
      */
     std::string getColumnName(int column) const;
 
+    /**
+     *  @brief Resolve a column name to its index.
+     *
+     *  The name→index map is built once per statement on the first lookup.
+     *  Resolve names before a row loop and use the index overloads inside it
+     *  to skip the lookup entirely.  If several columns share a name the
+     *  first one wins.
+     *
+     *  @param name Column name.
+     *  @return 0‑based column index.
+     *  @throw SqliteStatementException if no column has that name.
+     */
+    int getColumnIndex(std::string_view name) const;
+
     /**
      *  @brief Retrieve an optional integer (may be null).
      *  @param column 0‑based index.
@@ -225,6 +391,36 @@ public:
      */
     bool step();
 
+    /**
+     *  @brief Non-throwing step().
+     *
+     *  Meant for hot paths where SQLITE_BUSY is routine: check
+     *  `error().isBusy()`, reset() and retry without unwinding.
+     *
+     *  @return true if a row is available, false if done, or the error.
+     */
+    SqliteResult<bool> tryStep() noexcept;
+
+    /**
+     *  @brief Iterate over the result rows as typed tuples.
+     *
+     *  The column count is checked once when iteration starts; each row is
+     *  then decoded straight from SQLite without per-cell bounds checks.
+     *  `std::string_view` and `std::span` elements are only valid until the
+     *  iterator is advanced.
+     *
+     *  @code
+     *    for (auto [id, name, score] : stmt.rows<std::int64_t, std::string_view, std::optional<double>>()) {
+     *      // ...
+     *    }
+     *  @endcode
+     *
+     *  @tparam Ts Column types, one per result column.
+     *  @return Single-pass input range of `std::tuple<Ts...>`.
+     */
+    template<SqliteReadable... Ts>
+    SqliteRowRange<Ts...> rows();
+
     /**
      *  @brief Reset the statement to the initial state.
      */
@@ -236,13 +432,35 @@ public:
     void clearBindings();
 
 private:
+    template<SqliteReadable... Ts>
+    friend class SqliteRowRange;
+    friend class SqliteDb;
+    friend class SqliteResultCache;
+
+    struct ColumnNameHash {
+        using is_transparent = void;
+
+        std::size_t operator()(std::string_view name) const noexcept {
+            return std::hash<std::string_view> { }(name);
+        }
+    };
+
     SqliteStatementPtr mStatement;
+    bool mHasRow = false;
+    bool mDone = false;
+    mutable std::unordered_map<std::string, int, ColumnNameHash, std::equal_to<>> mColumnIndices;
+    /** SQLITE_STMTSTATUS_REPREPARE when mColumnIndices was built; a schema
+     *  change re-prepares the statement and may rename its columns. */
+    mutable int mColumnIndicesPrepare = -1;
 
     template<typename T>
     void bindParameter(int index, T&& value);
+    template<SqliteFieldRow Row>
+    void bindFields(int firstIndex, const Row& row);
     void checkColumnIndex(int column) const;
+    SqliteColumnType inferColumnType(int column) const;
+    void checkCurrentRow() const;
     void checkParameterIndex(int index) const;
-    int getColumnIndex(const std::string& name) const;
 };
 
 template<typename... Args>
@@ -251,27 +469,158 @@ void SqliteStatement::bindAll(Args&&... args) {
     (bindParameter(index++, std::forward<Args>(args)), ...);
 }
 
+template<typename... Args>
+SqliteResult<void> SqliteStatement::tryBindAll(Args&&... args) noexcept {
+    int index = 1;
+    SqliteResult<void> result;
+    (((result = tryBind(index++, std::forward<Args>(args))).hasValue()) && ...);
+    return result;
+}
+
 template<typename T>
 void SqliteStatement::bindParameter(int index, T&& value) {
-    if constexpr (std::is_same_v<std::decay_t<T>, int>) {
+    using Type = std::decay_t<T>;
+    if constexpr (std::is_same_v<Type, int>) {
         bind(index, value);
-    } else if constexpr (std::is_same_v<std::decay_t<T>, long long>) {
+    } else if constexpr (std::is_same_v<Type, std::int64_t>) {
         bind(index, value);
-    } else if constexpr (std::is_same_v<std::decay_t<T>, double>) {
+    } else if constexpr (std::is_same_v<Type, long long>) {
+        bind(index, static_cast<std::int64_t>(value));
+    } else if constexpr (std::is_same_v<Type, double>) {
         bind(index, value);
-    } else if constexpr (std::is_same_v<std::decay_t<T>, std::string>) {
+    } else if constexpr (std::is_same_v<Type, std::string>) {
         bind(index, value);
-    } else if constexpr (std::is_same_v<std::decay_t<T>, const char*>) {
+    } else if constexpr (std::is_same_v<Type, const char*> || std::is_same_v<Type, char*>) {
+        bind(index, static_cast<const char*>(value));
+    } else if constexpr (std::is_same_v<Type, std::string_view>) {
         bind(index, value);
-    } else if constexpr (std::is_same_v<std::decay_t<T>, const std::vector<std::byte>&>) {
+    } else if constexpr (std::is_same_v<Type, std::vector<std::byte>>) {
         bind(index, value);
-    } else if constexpr (std::is_same_v<std::decay_t<T>, std::nullptr_t>) {
+    } else if constexpr (std::is_same_v<Type, std::span<const std::byte>> || std::is_same_v<Type, std::span<std::byte>>) {
+        bind(index, std::span<const std::byte>(value));
+    } else if constexpr (std::is_same_v<Type, SqliteStaticText>) {
+        bind(index, value.value, BindLifetime::STATIC);
+    } else if constexpr (std::is_same_v<Type, SqliteStaticBlob>) {
+        bind(index, value.value, BindLifetime::STATIC);
+    } else if constexpr (std::is_same_v<Type, std::nullptr_t>) {
         bindNull(index);
     } else {
         static_assert(sizeof(T) == 0, "Unsupported type for binding");
     }
 }
 
+/**
+ * @brief Bind every field of @p row starting at @p firstIndex.
+ *
+ * Binding is dispatched at compile time through `SqliteParameterTraits`;
+ * the caller is responsible for checking the parameter range beforehand.
+ */
+template<SqliteFieldRow Row>
+void SqliteStatement::bindFields(int firstIndex, const Row& row) {
+    sqlite3_stmt* stmt = mStatement.get();
+    auto bindField = [stmt](int index, const auto& value) {
+        using Type = std::decay_t<decltype(value)>;
+        static_assert(SqliteBindable<Type>, "Unsupported field type for binding");
+        if (SqliteParameterTraits<Type>::bind(stmt, index, value) != SQLITE_OK) {
+            throw SqliteStatementException("Failed to bind parameter at index " + std::to_string(index));
+        }
+    };
+    std::apply([&](const auto&... fields) {
+        int index = firstIndex;
+        (bindField(index++, fields), ...);
+    }, sqliteRowFields(row));
+}
+
+/**
+ * @brief Single-pass range over the rows of a statement, see `SqliteStatement::rows()`.
+ */
+template<SqliteReadable... Ts>
+class SqliteRowRange {
+public:
+    using value_type = std::tuple<Ts...>;
+
+    class iterator {
+    public:
+        using value_type = std::tuple<Ts...>;
+        using difference_type = std::ptrdiff_t;
+        using iterator_concept = std::input_iterator_tag;
+
+        iterator() = default;
+
+        value_type& operator*() const {
+            return mRange->mRow;
+        }
+
+        iterator& operator++() {
+            mRange->advance();
+            return *this;
+        }
+
+        void operator++(int) {
+            ++*this;
+        }
+
+        friend bool operator==(const iterator& it, std::default_sentinel_t) {
+            return it.atEnd();
+        }
+
+    private:
+        friend class SqliteRowRange;
+
+        explicit iterator(SqliteRowRange* range)
+            : mRange(range) {
+        }
+
+        bool atEnd() const {
+            return !mRange || mRange->mDone;
+        }
+
+        SqliteRowRange* mRange = nullptr;
+    };
+
+    explicit SqliteRowRange(SqliteStatement& stmt)
+        : mStmt(&stmt) {
+    }
+
+    iterator begin() {
+        int columnCount = sqlite3_column_count(mStmt->mStatement.get());
+        if (columnCount != static_cast<int>(sizeof...(Ts))) {
+            throw SqliteStatementException(
+                "rows() expects " + std::to_string(sizeof...(Ts)) + " columns, statement has "
+                    + std::to_string(columnCount));
+        }
+        advance();
+        return iterator(this);
+    }
+
+    std::default_sentinel_t end() const noexcept {
+        return std::default_sentinel;
+    }
+
+private:
+    SqliteStatement* mStmt;
+    value_type mRow { };
+    bool mDone = false;
+
+    void advance() {
+        mDone = !mStmt->step();
+        if (!mDone) {
+            mRow = decode(std::index_sequence_for<Ts...> { });
+        }
+    }
+
+    template<std::size_t... Is>
+    value_type decode(std::index_sequence<Is...>) const {
+        sqlite3_stmt* stmt = mStmt->mStatement.get();
+        return value_type { SqliteColumnTraits<Ts>::read(stmt, static_cast<int>(Is))... };
+    }
+};
+
+template<SqliteReadable... Ts>
+SqliteRowRange<Ts...> SqliteStatement::rows() {
+    return SqliteRowRange<Ts...>(*this);
+}
+
 } // namespace sdb
 
 #endif /* INCLUDE_SQLITESTATEMENT_HPP_ */
@@ -0,0 +1,139 @@
+#ifndef INCLUDE_SQLITESTATEMENTCACHE_HPP_
+#define INCLUDE_SQLITESTATEMENTCACHE_HPP_
+
+/**
+ * @file SqliteStatementCache.hpp
+ * @brief LRU cache of prepared statements keyed by their SQL text.
+ */
+
+#include <SqliteStatement.hpp>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace sdb {
+
+  /**
+   * @brief Least-recently-used pool of idle prepared statements.
+   *
+   * A statement taken out of the cache is owned exclusively by the caller
+   * until it is put back, so two concurrent users of the same SQL text get
+   * two distinct statements.  Idle statements beyond the capacity are
+   * finalized, oldest first.
+   */
+  class SqliteStatementCache {
+    public:
+      struct Stats {
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        std::uint64_t evictions = 0;
+        std::size_t size = 0;
+        std::size_t capacity = 0;
+      };
+
+      /**
+       * @brief Create a cache.
+       * @param capacity Maximum number of idle statements kept.  0 disables caching.
+       */
+      explicit SqliteStatementCache(std::size_t capacity);
+
+      SqliteStatementCache(const SqliteStatementCache&) = delete;
+      SqliteStatementCache& operator=(const SqliteStatementCache&) = delete;
+
+      /**
+       * @brief Take an idle statement for @p sql out of the cache.
+       * @return The statement, or an empty optional on a miss.
+       */
+      std::optional<SqliteStatement> take(const std::string& sql);
+
+      /**
+       * @brief Return a statement to the cache.
+       *
+       * The statement is reset and its bindings are cleared before it becomes
+       * available again.  If the cache is full the least recently used idle
+       * statement is finalized.
+       */
+      void put(const std::string& sql, SqliteStatement stmt);
+
+      /**
+       * @brief Change the capacity, evicting idle statements if necessary.
+       */
+      void setCapacity(std::size_t capacity);
+
+      /**
+       * @brief Finalize every idle statement.
+       */
+      void clear();
+
+      /**
+       * @brief Snapshot of the hit/miss counters.
+       */
+      Stats getStats() const;
+
+      /**
+       * @brief Skip the cache mutex; only for caches used by one thread at a time.
+       */
+      void setThreadConfined(bool confined) noexcept;
+
+    private:
+      using Entry = std::pair<std::string, SqliteStatement>;
+
+      mutable std::mutex mMutex;
+      std::size_t mCapacity;
+      std::list<Entry> mEntries;
+      std::unordered_multimap<std::string, std::list<Entry>::iterator> mIndex;
+      std::uint64_t mHits = 0;
+      std::uint64_t mMisses = 0;
+      std::uint64_t mEvictions = 0;
+      bool mThreadConfined = false;
+
+      std::unique_lock<std::mutex> lock() const;
+      void evict(std::size_t capacity);
+  };
+
+  /**
+   * @brief Lease on a statement borrowed from a `SqliteStatementCache`.
+   *
+   * When the lease is destroyed or `release()` is called, the statement is
+   * reset, its bindings are cleared and it goes back to the cache instead of
+   * being finalized.  A lease must not outlive the `SqliteDb` it came from.
+   */
+  class SqliteCachedStatement {
+    public:
+      SqliteCachedStatement(SqliteStatementCache& cache, std::string sql, SqliteStatement stmt);
+      ~SqliteCachedStatement();
+
+      SqliteCachedStatement(SqliteCachedStatement&& other) noexcept;
+      SqliteCachedStatement& operator=(SqliteCachedStatement&& other) noexcept;
+      SqliteCachedStatement(const SqliteCachedStatement&) = delete;
+      SqliteCachedStatement& operator=(const SqliteCachedStatement&) = delete;
+
+      SqliteStatement& operator*() {
+        return *mStatement;
+      }
+
+      SqliteStatement* operator->() {
+        return &*mStatement;
+      }
+
+      SqliteStatement& get() {
+        return *mStatement;
+      }
+
+      /**
+       * @brief Return the statement to the cache now.  The lease becomes empty.
+       */
+      void release();
+
+    private:
+      SqliteStatementCache* mCache;
+      std::string mSql;
+      std::optional<SqliteStatement> mStatement;
+  };
+
+} /* namespace sdb */
+
+#endif /* INCLUDE_SQLITESTATEMENTCACHE_HPP_ */
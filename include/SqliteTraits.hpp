@@ -0,0 +1,366 @@
+#ifndef INCLUDE_SQLITETRAITS_HPP_
+#define INCLUDE_SQLITETRAITS_HPP_
+
+/**
+ * @file SqliteTraits.hpp
+ * @brief Compile-time mapping between C++ types and SQLite values.
+ *
+ * `SqliteColumnTraits` decodes result columns, `SqliteParameterTraits`
+ * binds parameters.  The traits perform no bounds or type checks; callers
+ * validate the index range once and then access cells directly.
+ */
+
+#include "../sqlite/sqlite3.h"
+#include <SqliteTypes.hpp>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace sdb {
+
+  template<typename T>
+  struct SqliteColumnTraits;
+
+  template<>
+  struct SqliteColumnTraits<int> {
+    static int read(sqlite3_stmt* stmt, int column) {
+      return sqlite3_column_int(stmt, column);
+    }
+  };
+
+  template<>
+  struct SqliteColumnTraits<std::int64_t> {
+    static std::int64_t read(sqlite3_stmt* stmt, int column) {
+      return sqlite3_column_int64(stmt, column);
+    }
+  };
+
+  template<>
+  struct SqliteColumnTraits<double> {
+    static double read(sqlite3_stmt* stmt, int column) {
+      return sqlite3_column_double(stmt, column);
+    }
+  };
+
+  template<>
+  struct SqliteColumnTraits<bool> {
+    static bool read(sqlite3_stmt* stmt, int column) {
+      return sqlite3_column_int64(stmt, column) != 0;
+    }
+  };
+
+  /**
+   * @brief Text view into SQLite's column buffer, valid until the next step.
+   */
+  template<>
+  struct SqliteColumnTraits<std::string_view> {
+    static std::string_view read(sqlite3_stmt* stmt, int column) {
+      const unsigned char* text = sqlite3_column_text(stmt, column);
+      if (!text) {
+        return { };
+      }
+      return std::string_view(reinterpret_cast<const char*>(text),
+                              static_cast<std::size_t>(sqlite3_column_bytes(stmt, column)));
+    }
+  };
+
+  template<>
+  struct SqliteColumnTraits<std::string> {
+    static std::string read(sqlite3_stmt* stmt, int column) {
+      return std::string(SqliteColumnTraits<std::string_view>::read(stmt, column));
+    }
+  };
+
+  /**
+   * @brief Blob span over SQLite's column buffer, valid until the next step.
+   */
+  template<>
+  struct SqliteColumnTraits<std::span<const std::byte>> {
+    static std::span<const std::byte> read(sqlite3_stmt* stmt, int column) {
+      const std::byte* data = reinterpret_cast<const std::byte*>(sqlite3_column_blob(stmt, column));
+      if (!data) {
+        return { };
+      }
+      return std::span<const std::byte>(data, static_cast<std::size_t>(sqlite3_column_bytes(stmt, column)));
+    }
+  };
+
+  template<>
+  struct SqliteColumnTraits<std::vector<std::byte>> {
+    static std::vector<std::byte> read(sqlite3_stmt* stmt, int column) {
+      auto blob = SqliteColumnTraits<std::span<const std::byte>>::read(stmt, column);
+      return std::vector<std::byte>(blob.begin(), blob.end());
+    }
+  };
+
+  /**
+   * @brief NULL maps to an empty optional, anything else to the wrapped type.
+   */
+  template<typename T>
+  struct SqliteColumnTraits<std::optional<T>> {
+    static std::optional<T> read(sqlite3_stmt* stmt, int column) {
+      if (sqlite3_column_type(stmt, column) == SQLITE_NULL) {
+        return std::nullopt;
+      }
+      return SqliteColumnTraits<T>::read(stmt, column);
+    }
+  };
+
+  /**
+   * @brief Types that can be decoded from a result column.
+   */
+  template<typename T>
+  concept SqliteReadable = requires(sqlite3_stmt* stmt, int column) {
+    { SqliteColumnTraits<T>::read(stmt, column) } -> std::same_as<T>;
+  };
+
+  template<typename T>
+  struct SqliteParameterTraits;
+
+  template<>
+  struct SqliteParameterTraits<int> {
+    static int bind(sqlite3_stmt* stmt, int index, int value) {
+      return sqlite3_bind_int(stmt, index, value);
+    }
+  };
+
+  template<>
+  struct SqliteParameterTraits<std::int64_t> {
+    static int bind(sqlite3_stmt* stmt, int index, std::int64_t value) {
+      return sqlite3_bind_int64(stmt, index, value);
+    }
+  };
+
+  template<>
+  struct SqliteParameterTraits<double> {
+    static int bind(sqlite3_stmt* stmt, int index, double value) {
+      return sqlite3_bind_double(stmt, index, value);
+    }
+  };
+
+  template<>
+  struct SqliteParameterTraits<bool> {
+    static int bind(sqlite3_stmt* stmt, int index, bool value) {
+      return sqlite3_bind_int(stmt, index, value ? 1 : 0);
+    }
+  };
+
+  template<>
+  struct SqliteParameterTraits<std::string_view> {
+    static int bind(sqlite3_stmt* stmt, int index, std::string_view value) {
+      const char* text = value.data() ? value.data() : "";
+      return sqlite3_bind_text64(stmt, index, text, value.size(), SQLITE_TRANSIENT, SQLITE_UTF8);
+    }
+  };
+
+  template<>
+  struct SqliteParameterTraits<std::string> {
+    static int bind(sqlite3_stmt* stmt, int index, const std::string& value) {
+      return SqliteParameterTraits<std::string_view>::bind(stmt, index, value);
+    }
+  };
+
+  template<>
+  struct SqliteParameterTraits<const char*> {
+    static int bind(sqlite3_stmt* stmt, int index, const char* value) {
+      return sqlite3_bind_text(stmt, index, value, -1, SQLITE_TRANSIENT);
+    }
+  };
+
+  template<>
+  struct SqliteParameterTraits<std::span<const std::byte>> {
+    static int bind(sqlite3_stmt* stmt, int index, std::span<const std::byte> value) {
+      return sqlite3_bind_blob64(stmt, index, value.data(), value.size(), SQLITE_TRANSIENT);
+    }
+  };
+
+  template<>
+  struct SqliteParameterTraits<std::vector<std::byte>> {
+    static int bind(sqlite3_stmt* stmt, int index, const std::vector<std::byte>& value) {
+      return SqliteParameterTraits<std::span<const std::byte>>::bind(stmt, index, value);
+    }
+  };
+
+  template<>
+  struct SqliteParameterTraits<SqliteStaticText> {
+    static int bind(sqlite3_stmt* stmt, int index, const SqliteStaticText& value) {
+      const char* text = value.value.data() ? value.value.data() : "";
+      return sqlite3_bind_text64(stmt, index, text, value.value.size(), SQLITE_STATIC, SQLITE_UTF8);
+    }
+  };
+
+  template<>
+  struct SqliteParameterTraits<SqliteStaticBlob> {
+    static int bind(sqlite3_stmt* stmt, int index, const SqliteStaticBlob& value) {
+      return sqlite3_bind_blob64(stmt, index, value.value.data(), value.value.size(), SQLITE_STATIC);
+    }
+  };
+
+  template<>
+  struct SqliteParameterTraits<std::nullptr_t> {
+    static int bind(sqlite3_stmt* stmt, int index, std::nullptr_t) {
+      return sqlite3_bind_null(stmt, index);
+    }
+  };
+
+  template<>
+  struct SqliteParameterTraits<std::monostate> {
+    static int bind(sqlite3_stmt* stmt, int index, std::monostate) {
+      return sqlite3_bind_null(stmt, index);
+    }
+  };
+
+  /**
+   * @brief An empty optional binds NULL.
+   */
+  template<typename T>
+  struct SqliteParameterTraits<std::optional<T>> {
+    static int bind(sqlite3_stmt* stmt, int index, const std::optional<T>& value) {
+      return value ? SqliteParameterTraits<T>::bind(stmt, index, *value) : sqlite3_bind_null(stmt, index);
+    }
+  };
+
+  /**
+   * @brief Variants, `SqliteValue` among them, bind their active alternative.
+   */
+  template<typename... Ts>
+  struct SqliteParameterTraits<std::variant<Ts...>> {
+    static int bind(sqlite3_stmt* stmt, int index, const std::variant<Ts...>& value) {
+      return std::visit([stmt, index](const auto& v) {
+        return SqliteParameterTraits<std::decay_t<decltype(v)>>::bind(stmt, index, v);
+      }, value);
+    }
+  };
+
+  /**
+   * @brief Types that can be bound to a statement parameter.
+   */
+  template<typename T>
+  concept SqliteBindable = requires(sqlite3_stmt* stmt, const T& value) {
+    { SqliteParameterTraits<std::decay_t<T>>::bind(stmt, 1, value) } -> std::same_as<int>;
+  };
+
+  namespace detail {
+
+    struct AnyField {
+      template<typename T>
+      operator T() const;
+    };
+
+    template<typename T, std::size_t... Is>
+    constexpr bool isBraceConstructible(std::index_sequence<Is...>) {
+      return requires { T { (static_cast<void>(Is), AnyField { })... }; };
+    }
+
+    template<typename T, std::size_t N = 0>
+    constexpr std::size_t countAggregateFields() {
+      if constexpr (N < 16 && isBraceConstructible<T>(std::make_index_sequence<N + 1> { })) {
+        return countAggregateFields<T, N + 1>();
+      } else {
+        return N;
+      }
+    }
+
+    template<typename T>
+    concept TupleLike = requires { std::tuple_size<T>::value; };
+
+    template<typename T>
+    concept AggregateRow = std::is_aggregate_v<T> && !std::ranges::range<T> && !TupleLike<T>
+        && countAggregateFields<T>() > 0;
+
+  } /* namespace detail */
+
+  /**
+   * @brief Rows whose fields are known at compile time: tuple-like types
+   * (`std::tuple`, `std::pair`, `std::array`) and aggregate structs of up to
+   * 16 fields without base classes.
+   */
+  template<typename T>
+  concept SqliteFieldRow = detail::TupleLike<T> || detail::AggregateRow<T>;
+
+  /**
+   * @brief Number of fields of a `SqliteFieldRow`.
+   */
+  template<SqliteFieldRow T>
+  constexpr std::size_t sqliteRowFieldCount() {
+    if constexpr (detail::TupleLike<T>) {
+      return std::tuple_size_v<T>;
+    } else {
+      return detail::countAggregateFields<T>();
+    }
+  }
+
+  /**
+   * @brief Tuple-like view of the fields of a `SqliteFieldRow`.
+   */
+  template<SqliteFieldRow T>
+  decltype(auto) sqliteRowFields(const T& row) {
+    if constexpr (detail::TupleLike<T>) {
+      return (row);
+    } else {
+      constexpr std::size_t count = detail::countAggregateFields<T>();
+      if constexpr (count == 1) {
+        const auto& [f0] = row;
+        return std::tie(f0);
+      } else if constexpr (count == 2) {
+        const auto& [f0, f1] = row;
+        return std::tie(f0, f1);
+      } else if constexpr (count == 3) {
+        const auto& [f0, f1, f2] = row;
+        return std::tie(f0, f1, f2);
+      } else if constexpr (count == 4) {
+        const auto& [f0, f1, f2, f3] = row;
+        return std::tie(f0, f1, f2, f3);
+      } else if constexpr (count == 5) {
+        const auto& [f0, f1, f2, f3, f4] = row;
+        return std::tie(f0, f1, f2, f3, f4);
+      } else if constexpr (count == 6) {
+        const auto& [f0, f1, f2, f3, f4, f5] = row;
+        return std::tie(f0, f1, f2, f3, f4, f5);
+      } else if constexpr (count == 7) {
+        const auto& [f0, f1, f2, f3, f4, f5, f6] = row;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6);
+      } else if constexpr (count == 8) {
+        const auto& [f0, f1, f2, f3, f4, f5, f6, f7] = row;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7);
+      } else if constexpr (count == 9) {
+        const auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8] = row;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8);
+      } else if constexpr (count == 10) {
+        const auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9] = row;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9);
+      } else if constexpr (count == 11) {
+        const auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10] = row;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10);
+      } else if constexpr (count == 12) {
+        const auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11] = row;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11);
+      } else if constexpr (count == 13) {
+        const auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12] = row;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12);
+      } else if constexpr (count == 14) {
+        const auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13] = row;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13);
+      } else if constexpr (count == 15) {
+        const auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14] = row;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14);
+      } else if constexpr (count == 16) {
+        const auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15] = row;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15);
+      }
+    }
+  }
+
+} /* namespace sdb */
+
+#endif /* INCLUDE_SQLITETRAITS_HPP_ */
@@ -1,10 +1,12 @@
 #ifndef INCLUDE_TRANSACTION_HPP_
 #define INCLUDE_TRANSACTION_HPP_
 
-#include "SqliteDb.hpp"
+#include <string>
 
 namespace sdb {
 
+class SqliteDb;
+
 /**
  * @brief Lightweight RAII wrapper for SQLite transactions.
  *
@@ -2,7 +2,9 @@
 #define INCLUDE_SQLITETYPES_HPP_
 
 #include "../sqlite/sqlite3.h"
+#include <span>
 #include <string>
+#include <string_view>
 #include <memory>
 #include <vector>
 #include <variant>
@@ -13,6 +15,17 @@ namespace sdb {
     READ_WRITE, READ_ONLY
   };
 
+  /**
+   * @brief Mutexing of a connection, see `SqliteDb::OpenOptions`.
+   *
+   * MULTI_THREAD (`SQLITE_OPEN_NOMUTEX`) drops the connection mutex, so a
+   * connection must not be used by two threads at once; SERIALIZED
+   * (`SQLITE_OPEN_FULLMUTEX`) keeps it.  DEFAULT follows the build.
+   */
+  enum class ThreadingMode {
+    DEFAULT, MULTI_THREAD, SERIALIZED
+  };
+
   enum class JournalMode {
     DELETE, TRUNCATE, PERSIST, MEMORY, WAL, OFF
   };
@@ -29,6 +42,32 @@ namespace sdb {
     OFF, ON, FAST
   };
 
+  enum class AutoVacuum {
+    NONE, FULL, INCREMENTAL
+  };
+
+  enum class CheckpointMode {
+    PASSIVE, FULL, RESTART, TRUNCATE
+  };
+
+  /**
+   * @brief Kind of row change reported to a `SqliteChangeListener`.
+   */
+  enum class ChangeOperation {
+    INSERT, UPDATE, DELETE
+  };
+
+  /**
+   * @brief Lifetime of a text/blob buffer handed to a bind call.
+   *
+   * TRANSIENT makes SQLite copy the buffer.  STATIC skips the copy; the
+   * caller guarantees the buffer outlives every `step()` until the
+   * parameter is rebound, the bindings are cleared or the statement dies.
+   */
+  enum class BindLifetime {
+    TRANSIENT, STATIC
+  };
+
   struct SqliteConnectionDeleter {
     void operator()(sqlite3* db) const {
       if (db) {
@@ -45,8 +84,17 @@ namespace sdb {
     }
   };
 
+  struct SqliteBlobDeleter {
+    void operator()(sqlite3_blob* blob) const {
+      if (blob) {
+        sqlite3_blob_close(blob);
+      }
+    }
+  };
+
   using SqliteConnectionPtr = std::unique_ptr<sqlite3, SqliteConnectionDeleter>;
   using SqliteStatementPtr = std::unique_ptr<sqlite3_stmt, SqliteStatementDeleter>;
+  using SqliteBlobPtr = std::unique_ptr<sqlite3_blob, SqliteBlobDeleter>;
 
   using SqliteValue = std::variant<
     std::monostate,
@@ -56,10 +104,32 @@ namespace sdb {
     std::vector<std::byte>
   >;
 
+  /**
+   * @brief Text parameter bound with `BindLifetime::STATIC` by `bindAll`.
+   */
+  struct SqliteStaticText {
+    std::string_view value;
+  };
+
+  /**
+   * @brief Blob parameter bound with `BindLifetime::STATIC` by `bindAll`.
+   */
+  struct SqliteStaticBlob {
+    std::span<const std::byte> value;
+  };
+
   inline SqliteValue sqliteNull() {
     return std::monostate { };
   }
 
+  inline SqliteStaticText sqliteStatic(std::string_view text) {
+    return SqliteStaticText { text };
+  }
+
+  inline SqliteStaticBlob sqliteStatic(std::span<const std::byte> blob) {
+    return SqliteStaticBlob { blob };
+  }
+
   template<typename T>
     SqliteValue sqliteValue(T&& val) {
       return SqliteValue { std::forward<T>(val) };
@@ -0,0 +1,107 @@
+#include <SqliteAsyncDb.hpp>
+#include <SqliteException.hpp>
+
+namespace sdb {
+
+  SqliteAsyncDb::SqliteAsyncDb(std::unique_ptr<SqliteDb> db)
+    : SqliteAsyncDb(std::move(db), Options { }) {
+  }
+
+  SqliteAsyncDb::SqliteAsyncDb(std::unique_ptr<SqliteDb> db, Options options)
+    : mDb(std::move(db))
+    , mOptions(options) {
+    if (!mDb || !mDb->isOpen()) {
+      throw SqliteDbException("Database not open");
+    }
+    if (mOptions.maxWriteBatch == 0) {
+      mOptions.maxWriteBatch = 1;
+    }
+
+    mWorker = std::thread([this] {
+      workerLoop();
+    });
+  }
+
+  SqliteAsyncDb::~SqliteAsyncDb() {
+    mQueue.close();
+    mWorker.join();
+  }
+
+  void SqliteAsyncDb::push(SqliteJobPtr job) {
+    if (!mQueue.push(std::move(job))) {
+      throw SqliteDbException("Async database is shutting down");
+    }
+  }
+
+  void SqliteAsyncDb::workerLoop() {
+    SqliteJobPtr carried;
+
+    while (true) {
+      SqliteJobPtr job;
+      if (carried) {
+        job = std::move(carried);
+      } else {
+        job = mQueue.pop();
+      }
+
+      if (!job) {
+        return;
+      }
+
+      if (!job->isWrite()) {
+        try {
+          job->run(*mDb);
+          job->complete();
+        } catch (...) {
+          job->fail(std::current_exception());
+        }
+        continue;
+      }
+
+      std::vector<SqliteJobPtr> batch;
+      batch.push_back(std::move(job));
+      while (batch.size() < mOptions.maxWriteBatch) {
+        std::optional<SqliteJobPtr> queued = mQueue.tryPop();
+        if (!queued) {
+          break;
+        }
+        SqliteJobPtr next = std::move(*queued);
+        if (!next || !next->isWrite()) {
+          // Order is preserved: the non-write job runs right after this batch
+          carried = std::move(next);
+          if (!carried) {
+            runWriteBatch(batch);
+            return;
+          }
+          break;
+        }
+        batch.push_back(std::move(next));
+      }
+
+      runWriteBatch(batch);
+    }
+  }
+
+  void SqliteAsyncDb::runWriteBatch(std::vector<SqliteJobPtr>& batch) {
+    std::size_t next = 0;
+
+    while (next < batch.size()) {
+      std::optional<SqliteJobBatch> transaction;
+      try {
+        transaction.emplace(*mDb, mOptions.writeMode);
+      } catch (...) {
+        auto error = std::current_exception();
+        for (; next < batch.size(); ++next) {
+          batch[next]->fail(error);
+        }
+        return;
+      }
+
+      // A broken transaction fails what it ran; the rest gets a fresh one
+      while (next < batch.size() && transaction->run(std::move(batch[next++]))) {
+      }
+      transaction->commit();
+    }
+  }
+
+} /* namespace sdb */
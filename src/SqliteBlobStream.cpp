@@ -0,0 +1,133 @@
+#include "../sqlite/sqlite3.h"
+#include <SqliteBlobStream.hpp>
+#include <SqliteException.hpp>
+#include <algorithm>
+#include <climits>
+#include <string>
+
+namespace sdb {
+
+  SqliteBlobStream::SqliteBlobStream(SqliteBlobPtr blob, sqlite3* connection, bool writable)
+    : mBlob(std::move(blob))
+    , mConnection(connection)
+    , mSize(static_cast<std::size_t>(sqlite3_blob_bytes(mBlob.get())))
+    , mPosition(0)
+    , mWritable(writable) {
+  }
+
+  SqliteBlobStream::SqliteBlobStream(SqliteBlobStream&& other) noexcept
+    : mBlob(std::move(other.mBlob))
+    , mConnection(other.mConnection)
+    , mSize(other.mSize)
+    , mPosition(other.mPosition)
+    , mWritable(other.mWritable) {
+    other.mSize = 0;
+    other.mPosition = 0;
+  }
+
+  SqliteBlobStream& SqliteBlobStream::operator=(SqliteBlobStream&& other) noexcept {
+    if (this != &other) {
+      mBlob = std::move(other.mBlob);
+      mConnection = other.mConnection;
+      mSize = other.mSize;
+      mPosition = other.mPosition;
+      mWritable = other.mWritable;
+      other.mSize = 0;
+      other.mPosition = 0;
+    }
+    return *this;
+  }
+
+  std::size_t SqliteBlobStream::size() const noexcept {
+    return mSize;
+  }
+
+  std::size_t SqliteBlobStream::tell() const noexcept {
+    return mPosition;
+  }
+
+  void SqliteBlobStream::seek(std::size_t offset) {
+    if (offset > mSize) {
+      throw SqliteBlobException("Seek past the end of the blob: " + std::to_string(offset) + " > " + std::to_string(mSize));
+    }
+    mPosition = offset;
+  }
+
+  bool SqliteBlobStream::isWritable() const noexcept {
+    return mWritable;
+  }
+
+  std::size_t SqliteBlobStream::read(std::span<std::byte> buffer) {
+    std::size_t count = std::min(buffer.size(), mSize - mPosition);
+    if (count == 0) {
+      return 0;
+    }
+    readAt(mPosition, buffer.first(count));
+    mPosition += count;
+    return count;
+  }
+
+  void SqliteBlobStream::readAt(std::size_t offset, std::span<std::byte> buffer) const {
+    checkRange(offset, buffer.size());
+
+    int rc = sqlite3_blob_read(mBlob.get(), buffer.data(), static_cast<int>(buffer.size()), static_cast<int>(offset));
+    if (rc != SQLITE_OK) {
+      fail("Blob read failed", rc);
+    }
+  }
+
+  void SqliteBlobStream::write(std::span<const std::byte> data) {
+    writeAt(mPosition, data);
+    mPosition += data.size();
+  }
+
+  void SqliteBlobStream::writeAt(std::size_t offset, std::span<const std::byte> data) {
+    if (!mWritable) {
+      throw SqliteBlobException("Blob stream was opened read-only");
+    }
+    checkRange(offset, data.size());
+
+    int rc = sqlite3_blob_write(mBlob.get(), data.data(), static_cast<int>(data.size()), static_cast<int>(offset));
+    if (rc != SQLITE_OK) {
+      fail("Blob write failed", rc);
+    }
+  }
+
+  void SqliteBlobStream::reopen(std::int64_t rowid) {
+    if (!mBlob) {
+      throw SqliteBlobException("Blob stream is closed");
+    }
+
+    int rc = sqlite3_blob_reopen(mBlob.get(), static_cast<sqlite3_int64>(rowid));
+    if (rc != SQLITE_OK) {
+      // SQLite leaves the handle aborted; every further access fails with SQLITE_ABORT
+      mSize = 0;
+      mPosition = 0;
+      fail(("Failed to reopen blob on row " + std::to_string(rowid)).c_str(), rc);
+    }
+    mSize = static_cast<std::size_t>(sqlite3_blob_bytes(mBlob.get()));
+    mPosition = 0;
+  }
+
+  void SqliteBlobStream::checkRange(std::size_t offset, std::size_t length) const {
+    if (!mBlob) {
+      throw SqliteBlobException("Blob stream is closed");
+    }
+    if (offset > mSize || length > mSize - offset) {
+      throw SqliteBlobException("Blob range [" + std::to_string(offset) + ", " + std::to_string(offset + length)
+          + ") is outside a blob of " + std::to_string(mSize) + " bytes");
+    }
+    // Offsets and lengths are ints in the C API
+    if (offset + length > static_cast<std::size_t>(INT_MAX)) {
+      throw SqliteBlobException("Blob offsets beyond 2 GiB are not supported by SQLite");
+    }
+  }
+
+  void SqliteBlobStream::fail(const char* what, int rc) const {
+    std::string message = what;
+    message += ": ";
+    message += mConnection ? sqlite3_errmsg(mConnection) : sqlite3_errstr(rc);
+    throw SqliteBlobException(message, rc);
+  }
+
+} /* namespace sdb */
@@ -0,0 +1,372 @@
+#include <SqliteChangeCapture.hpp>
+#include <SqliteDb.hpp>
+#include <SqliteException.hpp>
+#include <SqliteFunction.hpp>
+#include <stdexcept>
+#include <utility>
+
+namespace sdb {
+
+  namespace {
+
+    // Hooks run holding the connection mutex; code outside them takes it too
+    class ConnectionMutexLock {
+      public:
+        explicit ConnectionMutexLock(sqlite3* connection) noexcept
+          : mMutex(sqlite3_db_mutex(connection)) {
+          sqlite3_mutex_enter(mMutex);
+        }
+
+        ~ConnectionMutexLock() {
+          sqlite3_mutex_leave(mMutex);
+        }
+
+        ConnectionMutexLock(const ConnectionMutexLock&) = delete;
+        ConnectionMutexLock& operator=(const ConnectionMutexLock&) = delete;
+
+      private:
+        sqlite3_mutex* mMutex;
+    };
+
+#ifdef SQLITE_ENABLE_PREUPDATE_HOOK
+    SqliteValue readPreUpdateValue(sqlite3* db, int column, bool old) {
+      sqlite3_value* value = nullptr;
+      int result = old ? sqlite3_preupdate_old(db, column, &value) : sqlite3_preupdate_new(db, column, &value);
+      if (result != SQLITE_OK) {
+        throw SqliteDbException(std::string(old ? "Failed to read old value: " : "Failed to read new value: ")
+                                + sqlite3_errstr(result), result);
+      }
+      return SqliteArgumentTraits<SqliteValue>::read(value);
+    }
+#endif
+
+  } /* namespace */
+
+#ifdef SQLITE_ENABLE_PREUPDATE_HOOK
+  int SqlitePreUpdate::getColumnCount() const noexcept {
+    return sqlite3_preupdate_count(mDb);
+  }
+
+  int SqlitePreUpdate::getDepth() const noexcept {
+    return sqlite3_preupdate_depth(mDb);
+  }
+
+  SqliteValue SqlitePreUpdate::getOldValue(int column) const {
+    return readPreUpdateValue(mDb, column, true);
+  }
+
+  SqliteValue SqlitePreUpdate::getNewValue(int column) const {
+    return readPreUpdateValue(mDb, column, false);
+  }
+#else
+  // Never constructed without the hook; these only keep the class linkable
+  int SqlitePreUpdate::getColumnCount() const noexcept {
+    return 0;
+  }
+
+  int SqlitePreUpdate::getDepth() const noexcept {
+    return 0;
+  }
+
+  SqliteValue SqlitePreUpdate::getOldValue(int) const {
+    throw SqliteDbException("Preupdate hook is not compiled in");
+  }
+
+  SqliteValue SqlitePreUpdate::getNewValue(int) const {
+    throw SqliteDbException("Preupdate hook is not compiled in");
+  }
+#endif
+
+  SqliteChangeCapture::SqliteChangeCapture(Consumer consumer)
+    : SqliteChangeCapture(std::move(consumer), Options { }) {
+  }
+
+  SqliteChangeCapture::SqliteChangeCapture(Consumer consumer, Options options)
+    : mConsumer(std::move(consumer))
+    , mPreUpdate(SqliteDb::hasPreUpdateHook())
+    , mCaptureValues(options.captureValues && mPreUpdate)
+    , mRing(options.capacity) {
+    if (!mConsumer) {
+      throw std::invalid_argument("Change capture needs a consumer");
+    }
+    mThread = std::thread([this] { run(); });
+  }
+
+  SqliteChangeCapture::~SqliteChangeCapture() {
+    if (isConsumerThread()) {
+      // A thread cannot join itself: the consumer call under way owns its
+      // target from now on, and the thread ends once it returns
+      mOrphan->consumer = std::move(mConsumer);
+      mOrphan->orphaned = true;
+      mThread.detach();
+      return;
+    }
+
+    mStopping.store(true, std::memory_order_release);
+    wakeConsumer();
+    mThread.join();
+  }
+
+  void SqliteChangeCapture::flush() {
+    if (isConsumerThread()) {
+      throw SqliteDbException("Change capture cannot be flushed from its consumer");
+    }
+
+    std::uint64_t published = mPublished.load(std::memory_order_acquire);
+    std::uint64_t delivered = mDelivered.load(std::memory_order_acquire);
+    while (delivered < published) {
+      mDelivered.wait(delivered, std::memory_order_acquire);
+      delivered = mDelivered.load(std::memory_order_acquire);
+    }
+
+    std::exception_ptr error;
+    {
+      std::lock_guard lock(mErrorMutex);
+      error = std::exchange(mError, nullptr);
+    }
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+  SqliteChangeCapture::Stats SqliteChangeCapture::getStats() const noexcept {
+    Stats stats;
+    stats.transactions = mPublished.load(std::memory_order_relaxed);
+    stats.records = mRecords.load(std::memory_order_relaxed);
+    stats.delivered = mDelivered.load(std::memory_order_relaxed);
+    stats.discarded = mDiscarded.load(std::memory_order_relaxed);
+    stats.stalls = mStalls.load(std::memory_order_relaxed);
+    stats.lost = mLost.load(std::memory_order_relaxed);
+    return stats;
+  }
+
+  void SqliteChangeCapture::onUpdate(ChangeOperation operation, std::string_view schema, std::string_view table,
+                                     std::int64_t rowid) {
+    // With the preupdate hook every change has already been recorded there
+    if (mPreUpdate || mPoisoned) {
+      return;
+    }
+
+    try {
+      SqliteChangeRecord record;
+      record.operation = operation;
+      record.schema = intern(schema, mLastSchema);
+      record.table = intern(table, mLastTable);
+      record.rowid = rowid;
+      record.oldRowid = rowid;
+      mPending.push_back(std::move(record));
+    } catch (...) {
+      poison();
+    }
+  }
+
+  void SqliteChangeCapture::onPreUpdate(const SqlitePreUpdate& change) {
+    if (mPoisoned) {
+      return;
+    }
+
+    try {
+      SqliteChangeRecord record;
+      record.operation = change.getOperation();
+      record.schema = intern(change.getSchema(), mLastSchema);
+      record.table = intern(change.getTable(), mLastTable);
+      record.rowid = record.operation == ChangeOperation::DELETE ? change.getOldRowid() : change.getNewRowid();
+      record.oldRowid = record.operation == ChangeOperation::INSERT ? record.rowid : change.getOldRowid();
+
+      if (mCaptureValues) {
+        int columns = change.getColumnCount();
+        if (record.operation != ChangeOperation::INSERT) {
+          record.oldValues.reserve(columns);
+          for (int column = 0; column < columns; ++column) {
+            record.oldValues.push_back(change.getOldValue(column));
+          }
+        }
+        if (record.operation != ChangeOperation::DELETE) {
+          record.newValues.reserve(columns);
+          for (int column = 0; column < columns; ++column) {
+            record.newValues.push_back(change.getNewValue(column));
+          }
+        }
+      }
+      mPending.push_back(std::move(record));
+    } catch (...) {
+      poison();
+    }
+  }
+
+  void SqliteChangeCapture::onCommit() {
+    mStatements.clear();
+    // Delivering part of a transaction would be worse than delivering none of it
+    if (std::exchange(mPoisoned, false)) {
+      mLost.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    if (mPending.empty()) {
+      return;
+    }
+
+    std::uint64_t transaction = ++mTransaction;
+    std::size_t count = mPending.size();
+    bool stalled = false;
+    Slot slot;
+    for (std::size_t i = 0; i < count; ++i) {
+      slot.record = std::move(mPending[i]);
+      slot.record.transaction = transaction;
+      slot.last = i + 1 == count;
+      while (!mRing.tryPush(slot)) {
+        if (!stalled) {
+          stalled = true;
+          mStalls.fetch_add(1, std::memory_order_relaxed);
+        }
+        // The consumer may be asleep waiting for the end of this transaction
+        wakeConsumer();
+        mRing.waitForSpace();
+      }
+    }
+    mPending.clear();
+
+    mRecords.fetch_add(count, std::memory_order_relaxed);
+    mPublished.fetch_add(1, std::memory_order_release);
+    wakeConsumer();
+  }
+
+  void SqliteChangeCapture::onRollback() {
+    mStatements.clear();
+    mPoisoned = false;
+    mDiscarded.fetch_add(mPending.size(), std::memory_order_relaxed);
+    mPending.clear();
+  }
+
+  void SqliteChangeCapture::beginStatement(sqlite3_stmt* statement) noexcept {
+    // Outside a transaction a failing statement rolls back, and onRollback() drops everything
+    if (sqlite3_get_autocommit(sqlite3_db_handle(statement))) {
+      mStatements.clear();
+      return;
+    }
+
+    std::erase_if(mStatements, [statement](const auto& started) {
+      return started.first == statement;
+    });
+    try {
+      mStatements.emplace_back(statement, mPending.size());
+    } catch (...) {
+      poison();
+    }
+  }
+
+  std::size_t SqliteChangeCapture::getMark(sqlite3* connection) const noexcept {
+    ConnectionMutexLock lock(connection);
+    return mPending.size();
+  }
+
+  void SqliteChangeCapture::discardSince(sqlite3* connection, std::size_t mark) noexcept {
+    ConnectionMutexLock lock(connection);
+    truncate(mark);
+  }
+
+  void SqliteChangeCapture::truncate(std::size_t mark) noexcept {
+    if (mark < mPending.size()) {
+      mDiscarded.fetch_add(mPending.size() - mark, std::memory_order_relaxed);
+      mPending.erase(mPending.begin() + static_cast<std::ptrdiff_t>(mark), mPending.end());
+    }
+    // Statements that started later lost their records too
+    std::erase_if(mStatements, [mark](const auto& started) {
+      return started.second > mark;
+    });
+  }
+
+  void SqliteChangeCapture::discardFailedStatement(sqlite3_stmt* statement) noexcept {
+    sqlite3* connection = sqlite3_db_handle(statement);
+    auto* capture = static_cast<SqliteChangeCapture*>(sqlite3_get_clientdata(connection, CLIENT_DATA));
+    if (!capture) {
+      return;
+    }
+
+    ConnectionMutexLock lock(connection);
+    const auto& statements = capture->mStatements;
+    auto started = std::find_if(statements.begin(), statements.end(), [statement](const auto& entry) {
+      return entry.first == statement;
+    });
+    // Without an entry the statement began outside the transaction, or never began
+    if (started == statements.end() || sqlite3_get_autocommit(connection)) {
+      return;
+    }
+    // ON CONFLICT FAIL keeps the rows changed before the failing one, and reports them
+    if (sqlite3_changes64(connection) == 0) {
+      capture->truncate(started->second);
+    }
+  }
+
+  void SqliteChangeCapture::poison() noexcept {
+    recordError(std::current_exception());
+    mPoisoned = true;
+    mDiscarded.fetch_add(mPending.size(), std::memory_order_relaxed);
+    mPending.clear();
+  }
+
+  void SqliteChangeCapture::recordError(std::exception_ptr error) noexcept {
+    try {
+      std::lock_guard lock(mErrorMutex);
+      if (!mError) {
+        mError = std::move(error);
+      }
+    } catch (...) {
+      // The failure is still counted
+    }
+  }
+
+  std::string_view SqliteChangeCapture::intern(std::string_view name, std::string_view& last) {
+    // Nodes of an unordered_set never move, so views into them stay valid
+    if (name != last) {
+      last = *mNames.emplace(name).first;
+    }
+    return last;
+  }
+
+  void SqliteChangeCapture::wakeConsumer() {
+    mSignal.fetch_add(1, std::memory_order_release);
+    mSignal.notify_one();
+  }
+
+  void SqliteChangeCapture::run() {
+    std::vector<SqliteChangeRecord> transaction;
+    Slot slot;
+    Orphan orphan;
+    mOrphan = &orphan;
+
+    for (;;) {
+      std::uint32_t signal = mSignal.load(std::memory_order_acquire);
+      bool stopping = mStopping.load(std::memory_order_acquire);
+
+      while (mRing.tryPop(slot)) {
+        transaction.push_back(std::move(slot.record));
+        if (!slot.last) {
+          continue;
+        }
+
+        mRing.notifySpace();
+        try {
+          mConsumer(transaction);
+        } catch (...) {
+          if (!orphan.orphaned) {
+            recordError(std::current_exception());
+          }
+        }
+        if (orphan.orphaned) {
+          // The consumer destroyed the capture; none of its members are left
+          return;
+        }
+        transaction.clear();
+        mDelivered.fetch_add(1, std::memory_order_release);
+        mDelivered.notify_all();
+      }
+
+      mRing.notifySpace();
+      if (stopping) {
+        break;
+      }
+      mSignal.wait(signal, std::memory_order_acquire);
+    }
+  }
+
+} /* namespace sdb */
@@ -0,0 +1,194 @@
+#include <SqliteCheckpointer.hpp>
+#include <SqliteException.hpp>
+#include <algorithm>
+#include <cstring>
+#include <system_error>
+
+namespace sdb {
+
+  SqliteCheckpointer::SqliteCheckpointer(const std::filesystem::path& filename)
+    : SqliteCheckpointer(filename, Options { }) {
+  }
+
+  SqliteCheckpointer::SqliteCheckpointer(const std::filesystem::path& filename, Options options)
+    : mDb(SqliteDb::open(filename, OpenMode::READ_WRITE))
+    , mWalPath(filename.string() + "-wal")
+    , mOptions(options)
+    , mStopping(false)
+    , mRequested(false) {
+    // Reading the journal mode also makes this connection open the WAL index
+    {
+      auto stmt = mDb->prepare("PRAGMA journal_mode");
+      if (!stmt.step() || stmt.getString(0) != "wal") {
+        throw SqliteDbException("Checkpointer needs a database in WAL mode: '" + filename.string() + "'");
+      }
+    }
+
+    mDb->setBusyTimeout(mOptions.busyTimeout);
+    // This connection never writes, but must not checkpoint on its own either
+    mDb->execute("PRAGMA wal_autocheckpoint = 0");
+
+    mThread = std::thread([this] {
+      run();
+    });
+  }
+
+  SqliteCheckpointer::~SqliteCheckpointer() {
+    {
+      std::lock_guard lock(mMutex);
+      mStopping = true;
+    }
+    mWake.notify_one();
+    mThread.join();
+  }
+
+  void SqliteCheckpointer::watch(SqliteDb& writer) {
+    writer.checkConnection();
+    sqlite3_wal_hook(writer.mConnection.get(), &SqliteCheckpointer::onWalCommit, this);
+  }
+
+  void SqliteCheckpointer::unwatch(SqliteDb& writer) {
+    if (writer.isOpen()) {
+      sqlite3_wal_hook(writer.mConnection.get(), nullptr, nullptr);
+    }
+  }
+
+  int SqliteCheckpointer::onWalCommit(void* context, sqlite3*, const char* schema, int frames) {
+    auto* checkpointer = static_cast<SqliteCheckpointer*>(context);
+    if (std::strcmp(schema, "main") == 0) {
+      // The count drops when a writer restarts the log; every frame then is new
+      int previous = checkpointer->mWalFrames.exchange(frames, std::memory_order_relaxed);
+      int added = frames >= previous ? frames - previous : frames;
+      checkpointer->mNewFrames.fetch_add(added, std::memory_order_relaxed);
+    }
+    return SQLITE_OK;
+  }
+
+  void SqliteCheckpointer::requestCheckpoint() {
+    {
+      std::lock_guard lock(mMutex);
+      mRequested = true;
+    }
+    mWake.notify_one();
+  }
+
+  SqliteCheckpointer::Stats SqliteCheckpointer::getStats() const {
+    std::lock_guard lock(mMutex);
+    return mStats;
+  }
+
+  void SqliteCheckpointer::run() {
+    std::uintmax_t lastSize = 0;
+    std::filesystem::file_time_type lastWrite { };
+    auto lastActivity = std::chrono::steady_clock::now();
+    bool pending = false;
+
+    while (true) {
+      bool requested = false;
+      {
+        std::unique_lock lock(mMutex);
+        mWake.wait_for(lock, mOptions.pollInterval, [this] {
+          return mStopping || mRequested;
+        });
+        if (mStopping) {
+          return;
+        }
+        requested = mRequested;
+        mRequested = false;
+      }
+
+      // A missing WAL file simply means nothing to checkpoint yet
+      std::error_code error;
+      std::uintmax_t size = std::filesystem::file_size(mWalPath, error);
+      if (error) {
+        size = 0;
+      }
+      auto writeTime = std::filesystem::last_write_time(mWalPath, error);
+
+      const auto now = std::chrono::steady_clock::now();
+      if (size != lastSize || (!error && writeTime != lastWrite)) {
+        // WAL writers restart from the beginning of the file, so the size
+        // alone does not reveal new frames
+        lastSize = size;
+        lastWrite = writeTime;
+        lastActivity = now;
+        pending = size > 0;
+      }
+
+      {
+        std::lock_guard lock(mMutex);
+        mStats.walBytes = size;
+      }
+
+      // The file never shrinks short of TRUNCATE, so the frames the writers
+      // report are what tells new frames apart from old ones
+      int newFrames = mNewFrames.load(std::memory_order_relaxed);
+
+      bool due = requested
+          || (pending && now - lastActivity >= mOptions.idleTime)
+          || (mOptions.walFrameThreshold > 0 && newFrames >= mOptions.walFrameThreshold);
+      if (!due) {
+        continue;
+      }
+
+      runCheckpoint(size);
+      pending = false;
+      // A backlog left by busy readers waits for new frames or idleness;
+      // frames committed while the checkpoint ran still count
+      mNewFrames.fetch_sub(newFrames, std::memory_order_relaxed);
+      // The checkpoint itself touches the WAL file; do not count it as a write
+      lastSize = std::filesystem::file_size(mWalPath, error);
+      if (error) {
+        lastSize = 0;
+      }
+      lastWrite = std::filesystem::last_write_time(mWalPath, error);
+    }
+  }
+
+  void SqliteCheckpointer::runCheckpoint(std::uintmax_t walBytes) {
+    auto attempt = [this](CheckpointMode mode) {
+      const auto start = std::chrono::steady_clock::now();
+      auto result = mDb->checkpoint(mode);
+      auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+      bool incomplete = result.busy || result.checkpointedFrames < result.logFrames;
+
+      std::lock_guard lock(mMutex);
+      ++mStats.checkpoints;
+      switch (mode) {
+        case CheckpointMode::RESTART:
+          ++mStats.restartCheckpoints;
+          break;
+        case CheckpointMode::TRUNCATE:
+          ++mStats.truncateCheckpoints;
+          break;
+        default:
+          ++mStats.passiveCheckpoints;
+          break;
+      }
+      if (incomplete) {
+        ++mStats.incompleteCheckpoints;
+      }
+      mStats.lastDuration = duration;
+      mStats.maxDuration = std::max(mStats.maxDuration, duration);
+      mStats.totalDuration += duration;
+      mStats.walFrames = std::max(result.logFrames, 0);
+      mStats.backlogFrames = std::max(result.logFrames - result.checkpointedFrames, 0);
+      return !incomplete;
+    };
+
+    try {
+      bool complete = attempt(CheckpointMode::PASSIVE);
+
+      if (walBytes >= mOptions.truncateThreshold) {
+        attempt(CheckpointMode::TRUNCATE);
+      } else if (!complete && walBytes >= mOptions.restartThreshold) {
+        attempt(CheckpointMode::RESTART);
+      }
+    } catch (const SqliteException&) {
+      std::lock_guard lock(mMutex);
+      ++mStats.errors;
+    }
+  }
+
+} /* namespace sdb */
@@ -0,0 +1,165 @@
+#include <SqliteColumnar.hpp>
+#include <memory>
+
+namespace sdb {
+
+  namespace {
+
+    // Shared by the parent and child arrays so a consumer may release them in any order
+    struct ArrayHolder {
+      SqliteColumnarBatch batch;
+      std::vector<ArrowArray> children;
+      std::vector<ArrowArray*> childPointers;
+      std::vector<std::vector<const void*>> childBuffers;
+      std::vector<const void*> parentBuffers { nullptr };
+    };
+
+    struct SchemaHolder {
+      std::vector<std::string> names;
+      std::vector<ArrowSchema> children;
+      std::vector<ArrowSchema*> childPointers;
+    };
+
+    // Some consumers reject null value buffers, even for empty arrays
+    alignas(8) const std::byte EMPTY_BUFFER[8] { };
+
+    const void* bufferOrEmpty(const void* data) {
+      return data ? data : EMPTY_BUFFER;
+    }
+
+    using ArrayHandle = std::shared_ptr<ArrayHolder>;
+    using SchemaHandle = std::shared_ptr<SchemaHolder>;
+
+    void releaseChildArray(ArrowArray* array) {
+      delete static_cast<ArrayHandle*>(array->private_data);
+      array->release = nullptr;
+    }
+
+    void releaseArray(ArrowArray* array) {
+      for (int64_t i = 0; i < array->n_children; ++i) {
+        ArrowArray* child = array->children[i];
+        if (child->release) {
+          child->release(child);
+        }
+      }
+      delete static_cast<ArrayHandle*>(array->private_data);
+      array->release = nullptr;
+    }
+
+    void releaseChildSchema(ArrowSchema* schema) {
+      delete static_cast<SchemaHandle*>(schema->private_data);
+      schema->release = nullptr;
+    }
+
+    void releaseSchema(ArrowSchema* schema) {
+      for (int64_t i = 0; i < schema->n_children; ++i) {
+        ArrowSchema* child = schema->children[i];
+        if (child->release) {
+          child->release(child);
+        }
+      }
+      delete static_cast<SchemaHandle*>(schema->private_data);
+      schema->release = nullptr;
+    }
+
+    const char* arrowFormat(SqliteColumnType type) {
+      switch (type) {
+        case SqliteColumnType::DOUBLE:
+          return "g";
+        case SqliteColumnType::TEXT:
+          return "u";
+        case SqliteColumnType::BLOB:
+          return "z";
+        default:
+          return "l";
+      }
+    }
+
+  }
+
+  void SqliteColumnarBatch::exportToArrow(ArrowArray* array, ArrowSchema* schema) {
+    auto arrays = std::make_shared<ArrayHolder>();
+    arrays->batch = std::move(*this);
+    rows = 0;
+    columns.clear();
+
+    auto schemas = std::make_shared<SchemaHolder>();
+
+    const SqliteColumnarBatch& batch = arrays->batch;
+    const std::size_t columnCount = batch.columns.size();
+    arrays->children.resize(columnCount);
+    arrays->childPointers.resize(columnCount);
+    arrays->childBuffers.resize(columnCount);
+    schemas->names.reserve(columnCount);
+    schemas->children.resize(columnCount);
+    schemas->childPointers.resize(columnCount);
+
+    for (std::size_t i = 0; i < columnCount; ++i) {
+      const SqliteColumnBuffer& column = batch.columns[i];
+
+      auto& buffers = arrays->childBuffers[i];
+      buffers.push_back(column.nullCount > 0 ? column.validity.data() : nullptr);
+      switch (column.type) {
+        case SqliteColumnType::DOUBLE:
+          buffers.push_back(bufferOrEmpty(column.doubles.data()));
+          break;
+        case SqliteColumnType::TEXT:
+        case SqliteColumnType::BLOB:
+          buffers.push_back(bufferOrEmpty(column.offsets.data()));
+          buffers.push_back(bufferOrEmpty(column.data.data()));
+          break;
+        default:
+          buffers.push_back(bufferOrEmpty(column.int64s.data()));
+          break;
+      }
+
+      ArrowArray& child = arrays->children[i];
+      child.length = static_cast<int64_t>(batch.rows);
+      child.null_count = static_cast<int64_t>(column.nullCount);
+      child.offset = 0;
+      child.n_buffers = static_cast<int64_t>(buffers.size());
+      child.n_children = 0;
+      child.buffers = buffers.data();
+      child.children = nullptr;
+      child.dictionary = nullptr;
+      child.release = releaseChildArray;
+      child.private_data = new ArrayHandle(arrays);
+      arrays->childPointers[i] = &child;
+
+      schemas->names.push_back(column.name);
+      ArrowSchema& childSchema = schemas->children[i];
+      childSchema.format = arrowFormat(column.type);
+      childSchema.name = schemas->names.back().c_str();
+      childSchema.metadata = nullptr;
+      childSchema.flags = ARROW_FLAG_NULLABLE;
+      childSchema.n_children = 0;
+      childSchema.children = nullptr;
+      childSchema.dictionary = nullptr;
+      childSchema.release = releaseChildSchema;
+      childSchema.private_data = new SchemaHandle(schemas);
+      schemas->childPointers[i] = &childSchema;
+    }
+
+    array->length = static_cast<int64_t>(batch.rows);
+    array->null_count = 0;
+    array->offset = 0;
+    array->n_buffers = 1;
+    array->n_children = static_cast<int64_t>(columnCount);
+    array->buffers = arrays->parentBuffers.data();
+    array->children = arrays->childPointers.data();
+    array->dictionary = nullptr;
+    array->release = releaseArray;
+    array->private_data = new ArrayHandle(arrays);
+
+    schema->format = "+s";
+    schema->name = "";
+    schema->metadata = nullptr;
+    schema->flags = 0;
+    schema->n_children = static_cast<int64_t>(columnCount);
+    schema->children = schemas->childPointers.data();
+    schema->dictionary = nullptr;
+    schema->release = releaseSchema;
+    schema->private_data = new SchemaHandle(schemas);
+  }
+
+} /* namespace sdb */
@@ -0,0 +1,166 @@
+#include <SqliteConnectionPool.hpp>
+#include <SqliteException.hpp>
+
+namespace sdb {
+
+  SqliteConnectionPool::Connection::Connection(SqliteConnectionPool* pool, std::unique_ptr<SqliteDb> reader)
+    : mPool(pool)
+    , mReader(std::move(reader))
+    , mDb(mReader.get()) {
+  }
+
+  SqliteConnectionPool::Connection::Connection(SqliteConnectionPool* pool, SqliteDb* writer)
+    : mPool(pool)
+    , mReader()
+    , mDb(writer) {
+  }
+
+  SqliteConnectionPool::Connection::Connection(Connection&& other) noexcept
+    : mPool(other.mPool)
+    , mReader(std::move(other.mReader))
+    , mDb(other.mDb) {
+    other.mDb = nullptr;
+  }
+
+  SqliteConnectionPool::Connection& SqliteConnectionPool::Connection::operator=(Connection&& other) noexcept {
+    if (this != &other) {
+      release();
+      mPool = other.mPool;
+      mReader = std::move(other.mReader);
+      mDb = other.mDb;
+      other.mDb = nullptr;
+    }
+    return *this;
+  }
+
+  SqliteConnectionPool::Connection::~Connection() {
+    release();
+  }
+
+  void SqliteConnectionPool::Connection::release() {
+    if (!mDb) {
+      return;
+    }
+
+    if (mReader) {
+      mPool->releaseReader(std::move(mReader));
+    } else {
+      mPool->releaseWriter();
+    }
+    mDb = nullptr;
+  }
+
+  SqliteConnectionPool::SqliteConnectionPool(const std::filesystem::path& filename)
+    : SqliteConnectionPool(filename, Options { }) {
+  }
+
+  SqliteConnectionPool::SqliteConnectionPool(const std::filesystem::path& filename, Options options)
+    : mFilename(filename)
+    , mOptions(std::move(options))
+    , mReaderCount(0) {
+    if (mOptions.maxReaders == 0) {
+      throw SqliteDbException("Connection pool needs at least one reader");
+    }
+
+    mWriter = openConnection(OpenMode::READ_WRITE);
+
+    if (mOptions.backgroundCheckpoint) {
+      mWriter->execute("PRAGMA wal_autocheckpoint = 0");
+      mCheckpointer = std::make_unique<SqliteCheckpointer>(mFilename, mOptions.checkpointer);
+      mCheckpointer->watch(*mWriter);
+    }
+  }
+
+  SqliteConnectionPool::~SqliteConnectionPool() {
+    if (mCheckpointer) {
+      mCheckpointer->unwatch(*mWriter);
+    }
+  }
+
+  SqliteConnectionPool::Connection SqliteConnectionPool::acquireReader() {
+    const auto deadline = std::chrono::steady_clock::now() + mOptions.acquireTimeout;
+    std::unique_lock lock(mMutex);
+
+    while (true) {
+      if (!mIdleReaders.empty()) {
+        auto db = std::move(mIdleReaders.back());
+        mIdleReaders.pop_back();
+        return Connection(this, std::move(db));
+      }
+
+      if (mReaderCount < mOptions.maxReaders) {
+        ++mReaderCount;
+        lock.unlock();
+        try {
+          return Connection(this, openConnection(OpenMode::READ_ONLY));
+        } catch (...) {
+          lock.lock();
+          --mReaderCount;
+          mReaderAvailable.notify_one();
+          throw;
+        }
+      }
+
+      if (mReaderAvailable.wait_until(lock, deadline) == std::cv_status::timeout
+          && mIdleReaders.empty() && mReaderCount >= mOptions.maxReaders) {
+        throw SqliteDbException("Timed out waiting for a reader connection", SQLITE_BUSY);
+      }
+    }
+  }
+
+  SqliteConnectionPool::Connection SqliteConnectionPool::acquireWriter() {
+    if (!mWriterMutex.try_lock_for(mOptions.acquireTimeout)) {
+      throw SqliteDbException("Timed out waiting for the writer connection", SQLITE_BUSY);
+    }
+
+    return Connection(this, mWriter.get());
+  }
+
+  std::size_t SqliteConnectionPool::getReaderCount() const {
+    std::lock_guard lock(mMutex);
+    return mReaderCount;
+  }
+
+  std::size_t SqliteConnectionPool::getIdleReaderCount() const {
+    std::lock_guard lock(mMutex);
+    return mIdleReaders.size();
+  }
+
+  SqliteCheckpointer* SqliteConnectionPool::getCheckpointer() noexcept {
+    return mCheckpointer.get();
+  }
+
+  std::unique_ptr<SqliteDb> SqliteConnectionPool::openConnection(OpenMode mode) {
+    auto db = SqliteDb::open(mFilename, mode);
+
+    if (mode == OpenMode::READ_WRITE) {
+      db->setJournalMode(JournalMode::WAL);
+
+      auto stmt = db->prepare("PRAGMA journal_mode");
+      if (!stmt.step() || stmt.getString(0) != "wal") {
+        throw SqliteDbException("Failed to enable WAL journal mode on '" + mFilename.string() + "'");
+      }
+    }
+
+    db->setSynchronous(mOptions.synchronous);
+
+    if (mOptions.onConnect) {
+      mOptions.onConnect(*db);
+    }
+
+    return db;
+  }
+
+  void SqliteConnectionPool::releaseReader(std::unique_ptr<SqliteDb> db) {
+    {
+      std::lock_guard lock(mMutex);
+      mIdleReaders.push_back(std::move(db));
+    }
+    mReaderAvailable.notify_one();
+  }
+
+  void SqliteConnectionPool::releaseWriter() {
+    mWriterMutex.unlock();
+  }
+
+} /* namespace sdb */
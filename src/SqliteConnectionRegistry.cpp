@@ -0,0 +1,125 @@
+#include <SqliteConnectionRegistry.hpp>
+#include <SqliteException.hpp>
+#include <algorithm>
+#include <atomic>
+
+namespace sdb {
+
+  namespace {
+
+    std::atomic<std::uint64_t> nextRegistryId { 1 };
+
+  } /* namespace */
+
+  /**
+   * @brief Connections of the current thread, one per live registry.
+   *
+   * The last registry used is cached in front so that `get()` is a compare
+   * and a load.  On thread exit each connection is handed back to its
+   * registry, if the registry still exists, to be closed.
+   */
+  struct SqliteThreadSlots {
+    struct Slot {
+      std::uint64_t id;
+      std::weak_ptr<SqliteConnectionRegistry::State> state;
+      SqliteDb* db;
+    };
+
+    std::uint64_t lastId = 0;
+    SqliteDb* lastDb = nullptr;
+    std::vector<Slot> slots;
+
+    ~SqliteThreadSlots() {
+      for (auto& slot : slots) {
+        if (auto state = slot.state.lock()) {
+          state->release(slot.db);
+        }
+      }
+    }
+  };
+
+  namespace {
+
+    thread_local SqliteThreadSlots threadSlots;
+
+  } /* namespace */
+
+  SqliteConnectionRegistry::SqliteConnectionRegistry(const std::filesystem::path& filename)
+    : SqliteConnectionRegistry(filename, Options { }) {
+  }
+
+  SqliteConnectionRegistry::SqliteConnectionRegistry(const std::filesystem::path& filename, Options options)
+    : mId(nextRegistryId.fetch_add(1, std::memory_order_relaxed))
+    , mState(std::make_shared<State>()) {
+    mState->filename = filename;
+    mState->options = std::move(options);
+    mState->options.open.threadConfined = true;
+  }
+
+  SqliteConnectionRegistry::~SqliteConnectionRegistry() {
+    // Slots of other threads become stale; registry ids are never reused
+    if (threadSlots.lastId == mId) {
+      threadSlots.lastId = 0;
+      threadSlots.lastDb = nullptr;
+    }
+    std::erase_if(threadSlots.slots, [this](const SqliteThreadSlots::Slot& slot) {
+      return slot.id == mId;
+    });
+  }
+
+  SqliteDb& SqliteConnectionRegistry::get() {
+    if (threadSlots.lastId == mId) {
+      return *threadSlots.lastDb;
+    }
+    return connect();
+  }
+
+  std::size_t SqliteConnectionRegistry::getConnectionCount() const {
+    std::lock_guard lock(mState->mutex);
+    return mState->connections.size();
+  }
+
+  SqliteDb& SqliteConnectionRegistry::connect() {
+    SqliteDb* db = nullptr;
+
+    auto found = std::find_if(threadSlots.slots.begin(), threadSlots.slots.end(), [this](const SqliteThreadSlots::Slot& slot) {
+      return slot.id == mId;
+    });
+    if (found != threadSlots.slots.end()) {
+      db = found->db;
+    } else {
+      auto connection = SqliteDb::open(mState->filename, mState->options.open);
+      if (mState->options.onConnect) {
+        mState->options.onConnect(*connection);
+      }
+      db = connection.get();
+
+      {
+        std::lock_guard lock(mState->mutex);
+        mState->connections.push_back(std::move(connection));
+      }
+      threadSlots.slots.push_back(SqliteThreadSlots::Slot { mId, mState, db });
+    }
+
+    threadSlots.lastId = mId;
+    threadSlots.lastDb = db;
+    return *db;
+  }
+
+  void SqliteConnectionRegistry::State::release(SqliteDb* db) {
+    std::unique_ptr<SqliteDb> closing;
+    {
+      std::lock_guard lock(mutex);
+      auto found = std::find_if(connections.begin(), connections.end(), [db](const std::unique_ptr<SqliteDb>& connection) {
+        return connection.get() == db;
+      });
+      if (found == connections.end()) {
+        return;
+      }
+      closing = std::move(*found);
+      connections.erase(found);
+    }
+    // Closed outside the lock
+  }
+
+} /* namespace sdb */
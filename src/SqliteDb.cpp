@@ -1,44 +1,207 @@
 #include "../sqlite/sqlite3.h"
 #include <SqliteDb.hpp>
 #include <SqliteStatement.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
 #include <format>
+#include <thread>
 
 namespace sdb {
 
+  namespace {
+
+    ChangeOperation toChangeOperation(int type) {
+      return type == SQLITE_INSERT
+        ? ChangeOperation::INSERT
+        : (type == SQLITE_DELETE ? ChangeOperation::DELETE : ChangeOperation::UPDATE);
+    }
+
+    /**
+     * @brief Call @p notify on every listener; hooks run inside SQLite, so
+     *        nothing may escape.
+     */
+    template<typename Notify>
+    void notifyListeners(const std::vector<SqliteChangeListener*>& listeners, Notify&& notify) noexcept {
+      for (auto* listener : listeners) {
+        try {
+          notify(*listener);
+        } catch (...) {
+          // Dropped; the remaining listeners still hear about the change
+        }
+      }
+    }
+
+  } /* namespace */
+
   SqliteDb::SqliteDb(SqliteConnectionPtr connection)
-      : mConnection(std::move(connection)) {
+      : mConnection(std::move(connection))
+      , mStatementCache(DEFAULT_STATEMENT_CACHE_CAPACITY) {
+  }
+
+  SqliteDb::~SqliteDb() {
+    stopMaintenanceThread();
+
+    if (mConnection && mMaintenance.optimizeOnClose) {
+      try {
+        runMaintenance(mMaintenance);
+      } catch (...) {
+        // Never let maintenance keep the connection from closing
+      }
+    }
+
+    // Closing may roll back an open transaction; no listener must see it.
+    // Nothing here locks: the last owner may be released by the change
+    // capture's consumer, where lockConnection() throws
+    detachChangeCapture();
+    mChangeListeners.clear();
+    updateChangeHooks();
   }
 
   bool SqliteDb::isOpen() const noexcept {
     return mConnection != nullptr;
   }
 
+  bool SqliteDb::isThreadConfined() const noexcept {
+    return mThreadConfined;
+  }
+
+  bool SqliteDb::isInTransaction() const noexcept {
+    return mConnection && !sqlite3_get_autocommit(mConnection.get());
+  }
+
   std::unique_ptr<SqliteDb> SqliteDb::open(const std::filesystem::path& filename, OpenMode mode) {
-    sqlite3* rawDb = nullptr;
+    OpenOptions options;
+    options.mode = mode;
+    return open(filename, options);
+  }
+
+  std::unique_ptr<SqliteDb> SqliteDb::open(const std::filesystem::path& filename, const OpenOptions& options) {
     int flags = 0;
+    if (options.mode == OpenMode::READ_ONLY || options.immutable) {
+      flags = SQLITE_OPEN_READONLY;
+    } else {
+      flags = SQLITE_OPEN_READWRITE | (options.create ? SQLITE_OPEN_CREATE : 0);
+    }
 
-    switch (mode) {
-      case OpenMode::READ_ONLY:
-        flags = SQLITE_OPEN_READONLY;
+    ThreadingMode threading = options.threading;
+    if (options.threadConfined && threading == ThreadingMode::DEFAULT) {
+      threading = ThreadingMode::MULTI_THREAD;
+    }
+
+    switch (threading) {
+      case ThreadingMode::MULTI_THREAD:
+        flags |= SQLITE_OPEN_NOMUTEX;
         break;
-      case OpenMode::READ_WRITE:
-      default:
-        flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
+      case ThreadingMode::SERIALIZED:
+        flags |= SQLITE_OPEN_FULLMUTEX;
+        break;
+      case ThreadingMode::DEFAULT:
         break;
     }
 
-    int result = sqlite3_open_v2(filename.string().c_str(), &rawDb, flags, nullptr);
+    if (options.sharedCache) {
+      flags |= SQLITE_OPEN_SHAREDCACHE;
+    }
 
-    if (result != SQLITE_OK) {
-      throw SqliteDbException("Failed to open database: " + std::string(sqlite3_errmsg(rawDb)));
+    std::string name = filename.string();
+    if (options.immutable || options.noLock) {
+      // URI filenames percent-encode the characters that delimit the query
+      std::string uri = "file:";
+      for (char c : name) {
+        if (c == '?' || c == '#' || c == '%') {
+          static constexpr char HEX[] = "0123456789ABCDEF";
+          uri += '%';
+          uri += HEX[static_cast<unsigned char>(c) >> 4];
+          uri += HEX[static_cast<unsigned char>(c) & 0x0F];
+        } else {
+          uri += c;
+        }
+      }
+      uri += options.immutable ? "?immutable=1" : "?nolock=1";
+      if (options.immutable && options.noLock) {
+        uri += "&nolock=1";
+      }
+      name = std::move(uri);
+      flags |= SQLITE_OPEN_URI;
     }
 
+    sqlite3* rawDb = nullptr;
+    int result = sqlite3_open_v2(name.c_str(), &rawDb, flags, options.vfs.empty() ? nullptr : options.vfs.c_str());
+    // The handle is allocated even when the open fails and must be closed
     SqliteConnectionPtr connection(rawDb);
+
+    if (result != SQLITE_OK) {
+      std::string message = rawDb ? sqlite3_errmsg(rawDb) : sqlite3_errstr(result);
+      throw SqliteDbException("Failed to open database: " + message);
+    }
+
     auto db = std::unique_ptr<SqliteDb>(new SqliteDb(std::move(connection)));
+    db->mThreadConfined = options.threadConfined;
+    db->mStatementCache.setThreadConfined(options.threadConfined);
+    return db;
+  }
+
+  std::unique_ptr<SqliteDb> SqliteDb::open(const std::filesystem::path& filename, const OpenOptions& options,
+                                           const Tuning& tuning) {
+    auto db = open(filename, options);
+    db->applyTuning(tuning);
+    return db;
+  }
 
+  std::unique_ptr<SqliteDb> SqliteDb::open(const std::filesystem::path& filename, OpenMode mode, const Tuning& tuning) {
+    auto db = open(filename, mode);
+    // On failure the unique_ptr closes the connection while the exception propagates
+    db->applyTuning(tuning);
     return db;
   }
 
+  void SqliteDb::configure(const GlobalConfig& config) {
+    auto check = [](int rc, const char* option) {
+      if (rc != SQLITE_OK) {
+        throw SqliteDbException(std::string("sqlite3_config(") + option + ") failed: " + sqlite3_errstr(rc), rc);
+      }
+    };
+
+    if (config.defaultMmapSize || config.maxMmapSize) {
+      sqlite3_int64 defaultSize = config.defaultMmapSize.value_or(0);
+      sqlite3_int64 maxSize = config.maxMmapSize.value_or(defaultSize);
+      check(sqlite3_config(SQLITE_CONFIG_MMAP_SIZE, defaultSize, maxSize), "SQLITE_CONFIG_MMAP_SIZE");
+    }
+
+    if (config.pageCacheSlotSize || config.pageCacheSlots) {
+      if (!config.pageCacheSlotSize || !config.pageCacheSlots) {
+        throw std::invalid_argument("pageCacheSlotSize and pageCacheSlots must be set together");
+      }
+      check(sqlite3_config(SQLITE_CONFIG_PAGECACHE, nullptr, *config.pageCacheSlotSize, *config.pageCacheSlots),
+            "SQLITE_CONFIG_PAGECACHE");
+    }
+
+    if (config.lookaside) {
+      check(sqlite3_config(SQLITE_CONFIG_LOOKASIDE, config.lookaside->slotSize, config.lookaside->slotCount),
+            "SQLITE_CONFIG_LOOKASIDE");
+    }
+  }
+
+  SqliteDb::Tuning SqliteDb::Tuning::readHeavyAnalytics() {
+    Tuning tuning;
+    tuning.mmapSize = std::int64_t(64) << 30;
+    tuning.cacheSizeKb = 256 * 1024;
+    tuning.tempStore = TempStore::MEMORY;
+    return tuning;
+  }
+
+  SqliteDb::Tuning SqliteDb::Tuning::writeHeavyIngest() {
+    Tuning tuning;
+    tuning.journalMode = JournalMode::WAL;
+    tuning.synchronous = Synchronous::NORMAL;
+    tuning.cacheSizeKb = 128 * 1024;
+    tuning.cacheSpill = false;
+    tuning.walAutoCheckpoint = 10000;
+    tuning.tempStore = TempStore::MEMORY;
+    return tuning;
+  }
+
   std::unique_ptr<SqliteDb> SqliteDb::createInMemory() {
     return open(":memory:", OpenMode::READ_WRITE);
   }
@@ -97,8 +260,11 @@ namespace sdb {
   SqliteStatement SqliteDb::prepare(const std::string& sql) {
     checkConnection();
 
-    std::lock_guard lock(mMutex);
+    auto lock = lockConnection();
+    return prepareUnlocked(sql);
+  }
 
+  SqliteStatement SqliteDb::prepareUnlocked(const std::string& sql) {
     sqlite3_stmt* rawStmt = nullptr;
     int result = sqlite3_prepare_v2(mConnection.get(), sql.c_str(), -1, &rawStmt, nullptr);
 
@@ -109,28 +275,353 @@ namespace sdb {
     return SqliteStatement(SqliteStatementPtr(rawStmt));
   }
 
-  void SqliteDb::execute(const std::string& sql) {
+  SqliteCachedStatement SqliteDb::cachedPrepare(const std::string& sql) {
     checkConnection();
 
-    std::lock_guard lock(mMutex);
+    if (auto stmt = mStatementCache.take(sql)) {
+      return SqliteCachedStatement(mStatementCache, sql, std::move(*stmt));
+    }
+
+    return SqliteCachedStatement(mStatementCache, sql, prepare(sql));
+  }
+
+  SqliteResult<SqliteStatement> SqliteDb::tryPrepare(const std::string& sql) {
+    if (!mConnection) {
+      return SqliteError(SQLITE_MISUSE, "prepare");
+    }
+
+    auto lock = lockConnection();
+
+    sqlite3_stmt* rawStmt = nullptr;
+    int result = sqlite3_prepare_v2(mConnection.get(), sql.c_str(), -1, &rawStmt, nullptr);
 
-    char* errMsg(nullptr);
-    int rc = sqlite3_exec(mConnection.get(), sql.c_str(), nullptr, nullptr, &errMsg);
+    if (result != SQLITE_OK) {
+      return SqliteError(sqlite3_extended_errcode(mConnection.get()), "prepare");
+    }
+
+    return SqliteStatement(SqliteStatementPtr(rawStmt));
+  }
 
+  SqliteResult<SqliteCachedStatement> SqliteDb::tryCachedPrepare(const std::string& sql) {
+    if (!mConnection) {
+      return SqliteError(SQLITE_MISUSE, "prepare");
+    }
+
+    if (auto stmt = mStatementCache.take(sql)) {
+      return SqliteCachedStatement(mStatementCache, sql, std::move(*stmt));
+    }
+
+    auto stmt = tryPrepare(sql);
+    if (!stmt) {
+      return stmt.error();
+    }
+    return SqliteCachedStatement(mStatementCache, sql, std::move(*stmt));
+  }
+
+  SqliteBlobStream SqliteDb::openBlob(const std::string& table, const std::string& column, std::int64_t rowid,
+                                      bool writable, const std::string& schema) {
+    checkConnection();
+
+    auto lock = lockConnection();
+
+    sqlite3_blob* rawBlob = nullptr;
+    int rc = sqlite3_blob_open(mConnection.get(), schema.c_str(), table.c_str(), column.c_str(),
+                               static_cast<sqlite3_int64>(rowid), writable ? 1 : 0, &rawBlob);
+    // Even a failed open may hand back a handle that must be closed
+    SqliteBlobPtr blob(rawBlob);
     if (rc != SQLITE_OK) {
-      std::string error;
-      if (errMsg) {
-        error = errMsg;
-        sqlite3_free(errMsg);
-      } else {
-        error = getErrorMessage();
+      throw SqliteBlobException("Failed to open blob " + table + "." + column + " at row " + std::to_string(rowid)
+          + ": " + getErrorMessage(), rc);
+    }
+
+    return SqliteBlobStream(std::move(blob), mConnection.get(), writable);
+  }
+
+  void SqliteDb::setStatementCacheCapacity(std::size_t capacity) {
+    mStatementCache.setCapacity(capacity);
+  }
+
+  SqliteStatementCache::Stats SqliteDb::getStatementCacheStats() const {
+    return mStatementCache.getStats();
+  }
+
+  void SqliteDb::executeCached(const std::string& sql) {
+    auto stmt = cachedPrepare(sql);
+
+    auto lock = lockConnection();
+
+    int rc = sqlite3_step(stmt->mStatement.get());
+    if (rc != SQLITE_DONE && rc != SQLITE_ROW) {
+      SqliteChangeCapture::discardFailedStatement(stmt->mStatement.get());
+      throw SqliteDbException("SQL execution error: " + getErrorMessage(), rc);
+    }
+  }
+
+  void SqliteDb::execute(const std::string& sql) {
+    checkConnection();
+
+    auto lock = lockConnection();
+    executeUnlocked(sql);
+  }
+
+  void SqliteDb::executeUnlocked(const std::string& sql) {
+    // What sqlite3_exec() does, but the statement that failed is known
+    const char* tail = sql.c_str();
+    while (*tail) {
+      sqlite3_stmt* raw = nullptr;
+      int rc = sqlite3_prepare_v2(mConnection.get(), tail, -1, &raw, &tail);
+      if (rc != SQLITE_OK) {
+        throw SqliteDbException("SQL execution error: " + getErrorMessage(), rc);
+      }
+      if (!raw) {
+        // Only whitespace or a comment was left
+        continue;
       }
-      throw SqliteDbException("SQL execution error: " + error);
+
+      SqliteStatementPtr stmt(raw);
+      while ((rc = sqlite3_step(raw)) == SQLITE_ROW) {
+      }
+      if (rc != SQLITE_DONE) {
+        SqliteChangeCapture::discardFailedStatement(raw);
+        throw SqliteDbException("SQL execution error: " + getErrorMessage(), rc);
+      }
+    }
+  }
+
+  SqliteDb::OptimizeReport SqliteDb::optimize(int analysisLimit) {
+    checkConnection();
+
+    auto lock = lockConnection();
+    return optimizeUnlocked(analysisLimit);
+  }
+
+  SqliteDb::OptimizeReport SqliteDb::optimizeUnlocked(int analysisLimit) {
+    const auto start = std::chrono::steady_clock::now();
+
+    int previousLimit = 0;
+    {
+      auto current = prepareUnlocked("PRAGMA analysis_limit");
+      if (current.step()) {
+        previousLimit = current.getInt(0);
+      }
+    }
+
+    executeUnlocked(std::format("PRAGMA analysis_limit = {}", std::max(analysisLimit, 0)));
+    try {
+      OptimizeReport report = optimizeWithLimit();
+      executeUnlocked(std::format("PRAGMA analysis_limit = {}", previousLimit));
+      report.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+      return report;
+    } catch (...) {
+      try {
+        executeUnlocked(std::format("PRAGMA analysis_limit = {}", previousLimit));
+      } catch (...) {
+        // The original error matters more
+      }
+      throw;
+    }
+  }
+
+  SqliteDb::OptimizeReport SqliteDb::optimizeWithLimit() {
+    // Mask bit 0x01 lists the ANALYZE statements the default mask would run
+    OptimizeReport report;
+    {
+      auto dryRun = prepareUnlocked("PRAGMA optimize(0xffff)");
+      while (dryRun.step()) {
+        std::string line = dryRun.getString(0);
+        if (!line.starts_with("ANALYZE ")) {
+          continue;
+        }
+        std::string table;
+        for (char c : line.substr(8)) {
+          if (c != '"' && c != ';') {
+            table += c;
+          }
+        }
+        report.analyzedTables.push_back(std::move(table));
+      }
+    }
+
+    executeUnlocked("PRAGMA optimize");
+    return report;
+  }
+
+  void SqliteDb::analyze(const std::string& table) {
+    if (table.empty()) {
+      execute("ANALYZE");
+      return;
+    }
+
+    std::string quoted = "\"";
+    for (char c : table) {
+      quoted += c;
+      if (c == '"') {
+        quoted += '"';
+      }
+    }
+    quoted += '"';
+    execute("ANALYZE " + quoted);
+  }
+
+  void SqliteDb::vacuum() {
+    execute("VACUUM");
+  }
+
+  void SqliteDb::setMaintenance(MaintenanceOptions options) {
+    checkConnection();
+    stopMaintenanceThread();
+
+    if (mThreadConfined && options.interval.count() > 0) {
+      throw SqliteDbException("Scheduled maintenance would use a thread-confined connection from another thread");
+    }
+
+    mMaintenance = std::move(options);
+    if (mMaintenance.interval.count() <= 0) {
+      return;
+    }
+
+    mMaintenanceStopping = false;
+    mMaintenanceThread = std::thread([this] {
+      std::unique_lock lock(mMaintenanceMutex);
+      while (!mMaintenanceWake.wait_for(lock, mMaintenance.interval, [this] {
+        return mMaintenanceStopping;
+      })) {
+        std::optional<OptimizeReport> report;
+        try {
+          // Checked under the connection lock so no other thread can BEGIN
+          // between the check and the ANALYZE
+          auto connection = lockConnection();
+          if (sqlite3_get_autocommit(mConnection.get())) {
+            report = optimizeUnlocked(mMaintenance.analysisLimit);
+          }
+        } catch (...) {
+          // Retried on the next tick
+        }
+        if (report && mMaintenance.onReport) {
+          try {
+            mMaintenance.onReport(*report);
+          } catch (...) {
+            // A failing callback must not end the schedule
+          }
+        }
+      }
+    });
+  }
+
+  void SqliteDb::stopMaintenanceThread() {
+    if (!mMaintenanceThread.joinable()) {
+      return;
+    }
+    {
+      std::lock_guard lock(mMaintenanceMutex);
+      mMaintenanceStopping = true;
+    }
+    mMaintenanceWake.notify_one();
+    mMaintenanceThread.join();
+  }
+
+  void SqliteDb::runMaintenance(const MaintenanceOptions& options) {
+    auto report = optimize(options.analysisLimit);
+    if (options.onReport) {
+      options.onReport(report);
+    }
+  }
+
+  void SqliteDb::backupTo(SqliteDb& target) {
+    backupTo(target, BackupOptions { });
+  }
+
+  void SqliteDb::backupTo(const std::filesystem::path& target, const BackupOptions& options) {
+    auto targetDb = open(target, OpenMode::READ_WRITE);
+    backupTo(*targetDb, options);
+  }
+
+  void SqliteDb::backupTo(SqliteDb& target, const BackupOptions& options) {
+    checkConnection();
+    target.checkConnection();
+    if (&target == this) {
+      throw SqliteDbException("Cannot back up a database into itself");
+    }
+
+    sqlite3_backup* backup = sqlite3_backup_init(target.mConnection.get(), "main", mConnection.get(),
+                                                 options.sourceSchema.c_str());
+    if (!backup) {
+      throw SqliteDbException("Failed to start backup: " + target.getErrorMessage(), target.getErrorCode());
+    }
+
+    int rc = SQLITE_OK;
+    bool cancelled = false;
+    while (true) {
+      {
+        auto lock = lockConnection();
+        rc = sqlite3_backup_step(backup, options.pagesPerStep);
+      }
+      if (rc == SQLITE_DONE) {
+        break;
+      }
+      if (rc != SQLITE_OK && rc != SQLITE_BUSY && rc != SQLITE_LOCKED) {
+        break;
+      }
+
+      if (options.onProgress && !options.onProgress(sqlite3_backup_remaining(backup), sqlite3_backup_pagecount(backup))) {
+        cancelled = true;
+        break;
+      }
+      if (options.sleepBetween.count() > 0) {
+        std::this_thread::sleep_for(options.sleepBetween);
+      }
+    }
+
+    if (rc == SQLITE_DONE && options.onProgress) {
+      options.onProgress(0, sqlite3_backup_pagecount(backup));
+    }
+
+    sqlite3_backup_finish(backup);
+
+    if (cancelled) {
+      throw SqliteDbException("Backup cancelled");
+    }
+    if (rc != SQLITE_DONE) {
+      throw SqliteDbException("Backup failed: " + std::string(sqlite3_errstr(rc)), rc);
     }
   }
 
-  void SqliteDb::optimize() {
-    execute("VACUUM;");
+  void SqliteDb::vacuumInto(const std::filesystem::path& target) {
+    auto stmt = prepare("VACUUM INTO ?");
+    stmt.bind(1, target.string());
+    try {
+      stmt.step();
+    } catch (const SqliteStatementException&) {
+      throw SqliteDbException("VACUUM INTO '" + target.string() + "' failed: " + getErrorMessage(), getErrorCode());
+    }
+  }
+
+  void SqliteDb::setAutoVacuum(AutoVacuum mode) {
+    static auto toString = [](AutoVacuum m) {
+      switch (m) {
+        case AutoVacuum::FULL:
+          return "FULL";
+        case AutoVacuum::INCREMENTAL:
+          return "INCREMENTAL";
+        default:
+          return "NONE";
+      }
+    };
+
+    execute(std::format("PRAGMA auto_vacuum = {}", toString(mode)));
+  }
+
+  std::int64_t SqliteDb::incrementalVacuum(int pages) {
+    if (pages < 0) {
+      throw std::invalid_argument("Page count must be >= 0, got " + std::to_string(pages));
+    }
+    execute(std::format("PRAGMA incremental_vacuum({})", pages));
+    return getFreelistCount();
+  }
+
+  std::int64_t SqliteDb::getFreelistCount() {
+    auto stmt = prepare("PRAGMA freelist_count");
+    return stmt.step() ? stmt.getInt64(0) : 0;
   }
 
   void SqliteDb::setForeignKeyOn(bool value) {
@@ -209,6 +700,619 @@ namespace sdb {
     execute(std::format("PRAGMA cache_size = {}", static_cast<std::int64_t>(sizeKb)));
   }
 
+  void SqliteDb::applyTuning(const Tuning& tuning) {
+    checkConnection();
+
+    // Validate everything first so that a bad value leaves the connection untouched
+    if (tuning.pageSize) {
+      int size = *tuning.pageSize;
+      if (size < 512 || size > 65536 || (size & (size - 1)) != 0) {
+        throw std::invalid_argument("Page size must be a power of two in [512, 65536], got " + std::to_string(size));
+      }
+    }
+    if (tuning.mmapSize && *tuning.mmapSize < 0) {
+      throw std::invalid_argument("mmap size must be >= 0");
+    }
+    if (tuning.cacheSizeKb && *tuning.cacheSizeKb < 0) {
+      throw std::invalid_argument("Cache size must be >= 0");
+    }
+
+    if (tuning.lookaside) {
+      // A null buffer lets SQLite allocate the slab itself
+      int rc = sqlite3_db_config(mConnection.get(), SQLITE_DBCONFIG_LOOKASIDE, nullptr,
+                                 tuning.lookaside->slotSize, tuning.lookaside->slotCount);
+      if (rc != SQLITE_OK) {
+        throw SqliteDbException("Failed to configure lookaside: " + std::string(sqlite3_errstr(rc)), rc);
+      }
+    }
+    if (tuning.pageSize) {
+      execute(std::format("PRAGMA page_size = {}", *tuning.pageSize));
+    }
+    if (tuning.journalMode) {
+      setJournalMode(*tuning.journalMode);
+    }
+    if (tuning.synchronous) {
+      setSynchronous(*tuning.synchronous);
+    }
+    if (tuning.mmapSize) {
+      execute(std::format("PRAGMA mmap_size = {}", *tuning.mmapSize));
+    }
+    if (tuning.cacheSizeKb) {
+      execute(std::format("PRAGMA cache_size = {}", -*tuning.cacheSizeKb));
+    }
+    if (tuning.walAutoCheckpoint) {
+      execute(std::format("PRAGMA wal_autocheckpoint = {}", *tuning.walAutoCheckpoint));
+    }
+    if (tuning.cacheSpill) {
+      execute(std::format("PRAGMA cache_spill = {}", (*tuning.cacheSpill ? "ON" : "OFF")));
+    }
+    if (tuning.tempStore) {
+      setTempStore(*tuning.tempStore);
+    }
+  }
+
+  void SqliteDb::createModule(const std::string& name, const sqlite3_module* module, void* data, void (*destroy)(void*)) {
+    // SQLite owns @p data from here on and destroys it even on failure
+    int result = sqlite3_create_module_v2(mConnection.get(), name.c_str(), module, data, destroy);
+    if (result != SQLITE_OK) {
+      throw SqliteDbException("Failed to register virtual table " + name + ": " + getErrorMessage());
+    }
+  }
+
+  void SqliteDb::createFunction(const std::string& name, int arity, const FunctionOptions& options, void* function,
+                                void (*call)(sqlite3_context*, int, sqlite3_value**),
+                                void (*step)(sqlite3_context*, int, sqlite3_value**),
+                                void (*final)(sqlite3_context*),
+                                void (*value)(sqlite3_context*),
+                                void (*inverse)(sqlite3_context*, int, sqlite3_value**),
+                                void (*destroy)(void*)) {
+    int flags = SQLITE_UTF8;
+    if (options.deterministic) {
+      flags |= SQLITE_DETERMINISTIC;
+    }
+    if (options.directOnly) {
+      flags |= SQLITE_DIRECTONLY;
+    }
+    if (options.innocuous) {
+      flags |= SQLITE_INNOCUOUS;
+    }
+
+    // SQLite owns @p function from here on and destroys it even on failure
+    int result = value
+        ? sqlite3_create_window_function(mConnection.get(), name.c_str(), arity, flags, function,
+                                         step, final, value, inverse, destroy)
+        : sqlite3_create_function_v2(mConnection.get(), name.c_str(), arity, flags, function,
+                                     call, step, final, destroy);
+    if (result != SQLITE_OK) {
+      throw SqliteDbException("Failed to register SQL function " + name + ": " + getErrorMessage());
+    }
+  }
+
+  void SqliteDb::removeFunction(const std::string& name, int arity) {
+    checkConnection();
+    int result = sqlite3_create_function_v2(mConnection.get(), name.c_str(), arity, SQLITE_UTF8, nullptr,
+                                            nullptr, nullptr, nullptr, nullptr);
+    if (result != SQLITE_OK) {
+      throw SqliteDbException("Failed to remove SQL function " + name + ": " + getErrorMessage());
+    }
+  }
+
+  void SqliteDb::setBusyTimeout(std::chrono::milliseconds timeout) {
+    checkConnection();
+    sqlite3_busy_timeout(mConnection.get(), static_cast<int>(timeout.count()));
+    mBusyRetry.reset();
+  }
+
+  void SqliteDb::setBusyRetry(const BusyRetry& retry) {
+    checkConnection();
+
+    if (retry.initialDelay.count() < 0 || retry.maxDelay.count() < 0 || retry.timeout.count() < 0) {
+      throw std::invalid_argument("Busy retry delays must not be negative");
+    }
+    if (!(retry.multiplier >= 1.0)) {
+      throw std::invalid_argument("Busy retry multiplier must be at least 1");
+    }
+
+    auto state = std::make_unique<BusyRetryState>();
+    state->retry = retry;
+    state->seed = reinterpret_cast<std::uintptr_t>(state.get()) | 1;
+
+    // Install the new handler before the state the old one points to goes away
+    sqlite3_busy_handler(mConnection.get(), &SqliteDb::dispatchBusy, state.get());
+    mBusyRetry = std::move(state);
+  }
+
+  int SqliteDb::dispatchBusy(void* context, int count) {
+    auto* state = static_cast<BusyRetryState*>(context);
+    const BusyRetry& retry = state->retry;
+    auto now = std::chrono::steady_clock::now();
+
+    // SQLite restarts the count at 0 for every new wait
+    if (count == 0) {
+      state->since = now;
+    } else if (now - state->since >= retry.timeout) {
+      return 0;
+    }
+
+    double delay = static_cast<double>(retry.initialDelay.count()) * std::pow(retry.multiplier, count);
+    delay = std::min(delay, static_cast<double>(retry.maxDelay.count()));
+
+    if (retry.jitter) {
+      // xorshift64: cheap and good enough to spread retries apart
+      state->seed ^= state->seed << 13;
+      state->seed ^= state->seed >> 7;
+      state->seed ^= state->seed << 17;
+      double unit = static_cast<double>(state->seed >> 11) * 0x1.0p-53;
+      delay *= 0.5 + 0.5 * unit;
+    }
+
+    auto sleep = std::chrono::microseconds(static_cast<std::int64_t>(delay));
+    auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(retry.timeout - (now - state->since));
+    std::this_thread::sleep_for(std::min(sleep, remaining));
+    return 1;
+  }
+
+  SqliteDb::CheckpointResult SqliteDb::checkpoint(CheckpointMode mode) {
+    checkConnection();
+
+    int sqliteMode = SQLITE_CHECKPOINT_PASSIVE;
+    switch (mode) {
+      case CheckpointMode::FULL:
+        sqliteMode = SQLITE_CHECKPOINT_FULL;
+        break;
+      case CheckpointMode::RESTART:
+        sqliteMode = SQLITE_CHECKPOINT_RESTART;
+        break;
+      case CheckpointMode::TRUNCATE:
+        sqliteMode = SQLITE_CHECKPOINT_TRUNCATE;
+        break;
+      default:
+        break;
+    }
+
+    auto lock = lockConnection();
+
+    CheckpointResult result;
+    int rc = sqlite3_wal_checkpoint_v2(mConnection.get(), nullptr, sqliteMode, &result.logFrames,
+                                       &result.checkpointedFrames);
+    if (rc == SQLITE_BUSY || rc == SQLITE_LOCKED) {
+      result.busy = true;
+    } else if (rc != SQLITE_OK) {
+      throw SqliteDbException("WAL checkpoint failed: " + getErrorMessage(), rc);
+    }
+    return result;
+  }
+
+  void SqliteDb::enableProfiling() {
+    enableProfiling(SqliteProfiler::Options { });
+  }
+
+  void SqliteDb::enableProfiling(SqliteProfiler::Options options) {
+    checkConnection();
+    mProfiler = std::make_unique<SqliteProfiler>(std::move(options));
+    updateTraceHook();
+  }
+
+  void SqliteDb::disableProfiling() {
+    mProfiler.reset();
+    updateTraceHook();
+  }
+
+  SqliteProfiler* SqliteDb::getProfiler() noexcept {
+    return mProfiler.get();
+  }
+
+  void SqliteDb::updateTraceHook() {
+    if (!mConnection) {
+      return;
+    }
+
+    unsigned mask = 0;
+    if (mProfiler) {
+      mask |= SQLITE_TRACE_STMT | SQLITE_TRACE_PROFILE;
+    }
+    if (mScanDetector) {
+      mask |= SQLITE_TRACE_PROFILE;
+    }
+    if (mChangeCapture) {
+      mask |= SQLITE_TRACE_STMT;
+    }
+
+    // Without consumers no callback is registered, so statements run untraced
+    sqlite3_trace_v2(mConnection.get(), mask, mask ? &SqliteDb::dispatchTrace : nullptr, this);
+  }
+
+  int SqliteDb::dispatchTrace(unsigned type, void* context, void* p, void* x) {
+    auto* db = static_cast<SqliteDb*>(context);
+    auto* stmt = static_cast<sqlite3_stmt*>(p);
+
+    // Plans produced by explainPlan() are not executions of the statement
+    if (sqlite3_stmt_isexplain(stmt) != 0) {
+      return 0;
+    }
+
+    if (type == SQLITE_TRACE_STMT) {
+      // Trigger sub-programs report "-- " comments; only track the statement itself
+      const char* text = static_cast<const char*>(x);
+      if (text && text[0] == '-' && text[1] == '-') {
+        return 0;
+      }
+      if (db->mChangeCapture) {
+        db->mChangeCapture->beginStatement(stmt);
+      }
+      if (db->mProfiler) {
+        try {
+          db->mProfiler->begin(stmt);
+        } catch (...) {
+          db->mProfiler->recordFailure();
+        }
+      }
+      return 0;
+    }
+
+    if (type != SQLITE_TRACE_PROFILE) {
+      return 0;
+    }
+
+    // Counters are reset so the next execution of a cached statement starts from zero
+    auto takeStatus = [stmt](int op) {
+      return static_cast<std::uint64_t>(sqlite3_stmt_status(stmt, op, 1));
+    };
+    SqliteProfiler::Counters counters;
+    counters.fullscanSteps = takeStatus(SQLITE_STMTSTATUS_FULLSCAN_STEP);
+    counters.sorts = takeStatus(SQLITE_STMTSTATUS_SORT);
+    counters.autoindexes = takeStatus(SQLITE_STMTSTATUS_AUTOINDEX);
+    counters.vmSteps = takeStatus(SQLITE_STMTSTATUS_VM_STEP);
+    counters.memoryUsed = static_cast<std::uint64_t>(sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_MEMUSED, 0));
+
+    // Exceptions must not unwind through SQLite, which is mid-step here
+    if (db->mProfiler) {
+      auto nanoseconds = *static_cast<sqlite3_int64*>(x);
+      try {
+        db->mProfiler->record(stmt, std::chrono::nanoseconds(nanoseconds), counters);
+      } catch (...) {
+        db->mProfiler->recordFailure();
+      }
+    }
+
+    if (db->mScanDetector) {
+      try {
+        db->reportScan(stmt, counters);
+      } catch (...) {
+        // A failing onScan or allocation only loses this report
+      }
+    }
+    return 0;
+  }
+
+  void SqliteDb::enableScanDetection() {
+    enableScanDetection(ScanDetection { });
+  }
+
+  void SqliteDb::enableScanDetection(ScanDetection options) {
+    checkConnection();
+    auto detector = std::make_unique<ScanDetector>();
+    detector->options = std::move(options);
+    mScanDetector = std::move(detector);
+    updateTraceHook();
+  }
+
+  void SqliteDb::disableScanDetection() {
+    mScanDetector.reset();
+    updateTraceHook();
+  }
+
+  std::vector<SqliteDb::ScanReport> SqliteDb::getScanReports() const {
+    if (!mScanDetector) {
+      return { };
+    }
+    std::lock_guard lock(mScanDetector->mutex);
+    return mScanDetector->reports;
+  }
+
+  void SqliteDb::addChangeListener(SqliteChangeListener& listener) {
+    checkConnection();
+    auto lock = lockConnection();
+    mChangeListeners.push_back(&listener);
+    updateChangeHooks();
+  }
+
+  void SqliteDb::removeChangeListener(SqliteChangeListener& listener) {
+    auto lock = lockConnection();
+    std::erase(mChangeListeners, &listener);
+    updateChangeHooks();
+  }
+
+  void SqliteDb::updateChangeHooks() {
+    if (!mConnection) {
+      return;
+    }
+
+    // As with tracing, no listener means no hooks and no per-row callback
+    bool hooked = !mChangeListeners.empty();
+    sqlite3_update_hook(mConnection.get(), hooked ? &SqliteDb::dispatchUpdate : nullptr, hooked ? this : nullptr);
+    sqlite3_commit_hook(mConnection.get(), hooked ? &SqliteDb::dispatchCommit : nullptr, hooked ? this : nullptr);
+    sqlite3_rollback_hook(mConnection.get(), hooked ? &SqliteDb::dispatchRollback : nullptr, hooked ? this : nullptr);
+#ifdef SQLITE_ENABLE_PREUPDATE_HOOK
+    sqlite3_preupdate_hook(mConnection.get(), hooked ? &SqliteDb::dispatchPreUpdate : nullptr, hooked ? this : nullptr);
+#endif
+  }
+
+  void SqliteDb::dispatchUpdate(void* context, int type, const char* schema, const char* table, sqlite3_int64 rowid) {
+    auto* db = static_cast<SqliteDb*>(context);
+    ChangeOperation operation = toChangeOperation(type);
+    notifyListeners(db->mChangeListeners, [&](SqliteChangeListener& listener) {
+      listener.onUpdate(operation, schema, table, rowid);
+    });
+  }
+
+  void SqliteDb::dispatchPreUpdate(void* context, sqlite3* connection, int type, const char* schema,
+                                   const char* table, sqlite3_int64 oldRowid, sqlite3_int64 newRowid) {
+    auto* db = static_cast<SqliteDb*>(context);
+    SqlitePreUpdate change(connection, toChangeOperation(type), schema, table, oldRowid, newRowid);
+    notifyListeners(db->mChangeListeners, [&change](SqliteChangeListener& listener) {
+      listener.onPreUpdate(change);
+    });
+  }
+
+  int SqliteDb::dispatchCommit(void* context) {
+    auto* db = static_cast<SqliteDb*>(context);
+    notifyListeners(db->mChangeListeners, [](SqliteChangeListener& listener) {
+      listener.onCommit();
+    });
+    return 0;
+  }
+
+  void SqliteDb::dispatchRollback(void* context) {
+    auto* db = static_cast<SqliteDb*>(context);
+    notifyListeners(db->mChangeListeners, [](SqliteChangeListener& listener) {
+      listener.onRollback();
+    });
+  }
+
+  void SqliteDb::setAuthorizer(Authorizer authorizer) {
+    checkConnection();
+    auto lock = lockConnection();
+    mAuthorizer = std::move(authorizer);
+    updateAuthorizer();
+  }
+
+  void SqliteDb::updateAuthorizer() {
+    sqlite3_set_authorizer(mConnection.get(), mAuthorizer ? &SqliteDb::dispatchAuthorizer : nullptr,
+                           mAuthorizer ? this : nullptr);
+  }
+
+  int SqliteDb::dispatchAuthorizer(void* context, int action, const char* first, const char* second,
+                                   const char* schema, const char* trigger) {
+    auto* db = static_cast<SqliteDb*>(context);
+    if (!db->mAuthorizer) {
+      return SQLITE_OK;
+    }
+    try {
+      return db->mAuthorizer(action, first, second, schema, trigger);
+    } catch (...) {
+      return SQLITE_DENY;
+    }
+  }
+
+  bool SqliteDb::hasPreUpdateHook() noexcept {
+#ifdef SQLITE_ENABLE_PREUPDATE_HOOK
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  void SqliteDb::enableChangeCapture(SqliteChangeCapture::Consumer consumer) {
+    enableChangeCapture(std::move(consumer), SqliteChangeCapture::Options { });
+  }
+
+  void SqliteDb::enableChangeCapture(SqliteChangeCapture::Consumer consumer, SqliteChangeCapture::Options options) {
+    checkConnection();
+    auto capture = std::make_unique<SqliteChangeCapture>(std::move(consumer), options);
+    disableChangeCapture();
+    mChangeCapture = std::move(capture);
+    addChangeListener(*mChangeCapture);
+    // Statement failures are reported from SqliteStatement, which only has the handle
+    sqlite3_set_clientdata(mConnection.get(), SqliteChangeCapture::CLIENT_DATA, mChangeCapture.get(), nullptr);
+    updateTraceHook();
+  }
+
+  void SqliteDb::disableChangeCapture() {
+    if (mChangeCapture) {
+      std::unique_ptr<SqliteChangeCapture> capture;
+      {
+        auto lock = lockConnection();
+        capture = detachChangeCapture();
+      }
+      // Delivers what was published, so the connection is not held meanwhile
+      capture.reset();
+    }
+  }
+
+  std::unique_ptr<SqliteChangeCapture> SqliteDb::detachChangeCapture() {
+    std::unique_ptr<SqliteChangeCapture> capture = std::move(mChangeCapture);
+    if (capture) {
+      std::erase(mChangeListeners, capture.get());
+      updateChangeHooks();
+      if (mConnection) {
+        sqlite3_set_clientdata(mConnection.get(), SqliteChangeCapture::CLIENT_DATA, nullptr, nullptr);
+      }
+      updateTraceHook();
+    }
+    return capture;
+  }
+
+  SqliteChangeCapture* SqliteDb::getChangeCapture() noexcept {
+    return mChangeCapture.get();
+  }
+
+  void SqliteDb::enableResultCache() {
+    enableResultCache(SqliteResultCache::Options { });
+  }
+
+  void SqliteDb::enableResultCache(SqliteResultCache::Options options) {
+    checkConnection();
+    disableResultCache();
+    mResultCache = std::make_unique<SqliteResultCache>(*this, options);
+    addChangeListener(*mResultCache);
+  }
+
+  void SqliteDb::disableResultCache() {
+    if (mResultCache) {
+      removeChangeListener(*mResultCache);
+      mResultCache.reset();
+    }
+  }
+
+  SqliteResultCache* SqliteDb::getResultCache() noexcept {
+    return mResultCache.get();
+  }
+
+  SqliteCachedResult SqliteDb::cachedQuery(const std::string& sql) {
+    return cachedQuery(sql, { });
+  }
+
+  SqliteCachedResult SqliteDb::cachedQuery(const std::string& sql, const std::vector<SqliteValue>& parameters) {
+    checkConnection();
+    if (!mResultCache) {
+      throw SqliteDbException("Result cache is not enabled");
+    }
+    return mResultCache->query(sql, parameters);
+  }
+
+  void SqliteDb::reportScan(sqlite3_stmt* stmt, const SqliteProfiler::Counters& counters) {
+    const ScanDetection& options = mScanDetector->options;
+
+    bool fullScan = options.minFullScanSteps > 0 && counters.fullscanSteps >= options.minFullScanSteps;
+    bool autoIndex = options.reportAutoIndex && counters.autoindexes > 0;
+    if (!fullScan && !autoIndex) {
+      return;
+    }
+
+    const char* text = sqlite3_sql(stmt);
+    ScanReport report { text ? text : "", counters.fullscanSteps, counters.autoindexes };
+    {
+      std::lock_guard lock(mScanDetector->mutex);
+      if (options.reportOnce && !mScanDetector->reported.insert(report.sql).second) {
+        return;
+      }
+      mScanDetector->reports.push_back(report);
+    }
+
+    if (options.onScan) {
+      options.onScan(report);
+    }
+  }
+
+  std::string SqliteDb::MultiRowInsert::build(std::size_t rows) const {
+    std::string sql;
+    sql.reserve(prefix.size() + rows * (tuple.size() + 1));
+    sql += prefix;
+    for (std::size_t i = 0; i < rows; ++i) {
+      if (i > 0) {
+        sql += ',';
+      }
+      sql += tuple;
+    }
+    return sql;
+  }
+
+  std::optional<SqliteDb::MultiRowInsert> SqliteDb::parseMultiRowInsert(const std::string& sql, int parameterCount) {
+    auto isIdentifier = [](char c) {
+      return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$';
+    };
+    auto matchesKeyword = [&](std::size_t pos, std::string_view keyword) {
+      if (pos + keyword.size() > sql.size()) {
+        return false;
+      }
+      for (std::size_t i = 0; i < keyword.size(); ++i) {
+        if (std::toupper(static_cast<unsigned char>(sql[pos + i])) != keyword[i]) {
+          return false;
+        }
+      }
+      bool startsWord = pos == 0 || !isIdentifier(sql[pos - 1]);
+      bool endsWord = pos + keyword.size() == sql.size() || !isIdentifier(sql[pos + keyword.size()]);
+      return startsWord && endsWord;
+    };
+
+    std::size_t start = sql.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos || !(matchesKeyword(start, "INSERT") || matchesKeyword(start, "REPLACE"))) {
+      return std::nullopt;
+    }
+
+    // Locate the VALUES keyword outside of quoted identifiers and literals
+    std::size_t values = std::string::npos;
+    char quote = 0;
+    for (std::size_t i = start; i < sql.size(); ++i) {
+      char c = sql[i];
+      if (quote) {
+        if (c == quote) {
+          quote = 0;
+        }
+      } else if (c == '\'' || c == '"' || c == '`') {
+        quote = c;
+      } else if (c == '[') {
+        quote = ']';
+      } else if (matchesKeyword(i, "VALUES")) {
+        values = i;
+        break;
+      }
+    }
+
+    if (values == std::string::npos) {
+      return std::nullopt;
+    }
+
+    std::size_t open = sql.find_first_not_of(" \t\r\n", values + 6);
+    if (open == std::string::npos || sql[open] != '(') {
+      return std::nullopt;
+    }
+
+    std::size_t close = sql.find(')', open);
+    if (close == std::string::npos) {
+      return std::nullopt;
+    }
+
+    // Only a plain tuple of anonymous placeholders can be repeated safely
+    std::string_view tuple(sql.data() + open + 1, close - open - 1);
+    if (tuple.find_first_not_of("?, \t\r\n") != std::string_view::npos
+        || std::ranges::count(tuple, '?') != parameterCount) {
+      return std::nullopt;
+    }
+
+    if (sql.find_first_not_of("; \t\r\n", close + 1) != std::string::npos) {
+      return std::nullopt;
+    }
+
+    return MultiRowInsert { sql.substr(0, open), sql.substr(open, close - open + 1) };
+  }
+
+  std::size_t SqliteDb::getBatchChunkRows(int parameterCount, const BatchOptions& options) const {
+    int variableLimit = sqlite3_limit(mConnection.get(), SQLITE_LIMIT_VARIABLE_NUMBER, -1);
+    std::size_t rows = static_cast<std::size_t>(variableLimit / parameterCount);
+
+    if (options.maxRowsPerStatement > 0) {
+      rows = std::min(rows, options.maxRowsPerStatement);
+    }
+    if (options.useTransaction && options.commitEvery > 0) {
+      rows = std::min(rows, options.commitEvery);
+    }
+
+    return rows;
+  }
+
+  std::unique_lock<std::mutex> SqliteDb::lockConnection() {
+    // A commit waiting for ring space holds the connection until the consumer drains it
+    if (mChangeCapture && mChangeCapture->isConsumerThread()) {
+      throw SqliteDbException("The change capture consumer must not use the captured connection");
+    }
+    if (mThreadConfined) {
+      return std::unique_lock<std::mutex>(mMutex, std::defer_lock);
+    }
+    return std::unique_lock<std::mutex>(mMutex);
+  }
+
   void SqliteDb::checkConnection() const {
     if (!mConnection) {
       throw SqliteDbException("Database not open");
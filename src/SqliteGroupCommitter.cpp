@@ -0,0 +1,96 @@
+#include <SqliteGroupCommitter.hpp>
+#include <SqliteException.hpp>
+#include <algorithm>
+#include <optional>
+
+namespace sdb {
+
+  SqliteGroupCommitter::SqliteGroupCommitter(std::unique_ptr<SqliteDb> db)
+    : SqliteGroupCommitter(std::move(db), Options { }) {
+  }
+
+  SqliteGroupCommitter::SqliteGroupCommitter(std::unique_ptr<SqliteDb> db, Options options)
+    : mDb(std::move(db))
+    , mOptions(options) {
+    if (!mDb || !mDb->isOpen()) {
+      throw SqliteDbException("Database not open");
+    }
+    if (mOptions.maxBatchJobs == 0) {
+      mOptions.maxBatchJobs = 1;
+    }
+
+    mWriter = std::thread([this] {
+      writerLoop();
+    });
+  }
+
+  SqliteGroupCommitter::~SqliteGroupCommitter() {
+    mQueue.close();
+    mWriter.join();
+  }
+
+  SqliteGroupCommitter::Stats SqliteGroupCommitter::getStats() const {
+    std::lock_guard lock(mStatsMutex);
+    return mStats;
+  }
+
+  void SqliteGroupCommitter::push(SqliteJobPtr job) {
+    if (!mQueue.push(std::move(job))) {
+      throw SqliteDbException("Group committer is shutting down");
+    }
+  }
+
+  void SqliteGroupCommitter::writerLoop() {
+    bool stopping = false;
+
+    while (!stopping) {
+      SqliteJobPtr job = mQueue.pop();
+      if (!job) {
+        return;
+      }
+
+      std::optional<SqliteJobBatch> batch;
+      try {
+        batch.emplace(*mDb, SqliteTransaction::Mode::Immediate);
+      } catch (...) {
+        job->fail(std::current_exception());
+        std::lock_guard lock(mStatsMutex);
+        ++mStats.jobs;
+        ++mStats.failedJobs;
+        continue;
+      }
+
+      const auto deadline = std::chrono::steady_clock::now() + mOptions.maxLatency;
+      bool usable = batch->run(std::move(job));
+
+      while (usable && batch->size() < mOptions.maxBatchJobs) {
+        std::optional<SqliteJobPtr> queued = mQueue.tryPopUntil(deadline);
+        if (!queued) {
+          break;
+        }
+        SqliteJobPtr next = std::move(*queued);
+        if (!next) {
+          stopping = true;
+          break;
+        }
+        usable = batch->run(std::move(next));
+      }
+
+      const auto commitStart = std::chrono::steady_clock::now();
+      bool committed = batch->commit();
+      auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - commitStart);
+
+      std::lock_guard lock(mStatsMutex);
+      mStats.jobs += batch->size();
+      mStats.failedJobs += batch->failedCount();
+      if (committed) {
+        ++mStats.commits;
+        mStats.lastCommitDuration = duration;
+        mStats.maxCommitDuration = std::max(mStats.maxCommitDuration, duration);
+      } else {
+        ++mStats.failedCommits;
+      }
+    }
+  }
+
+} /* namespace sdb */
@@ -0,0 +1,828 @@
+#include <SqliteDb.hpp>
+#include <SqliteException.hpp>
+#include <algorithm>
+#include <charconv>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <variant>
+
+#ifdef _WIN32
+#include <fstream>
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace sdb {
+
+  namespace {
+
+    /**
+     * @brief Field of a parsed record; text points into the mapped input.
+     */
+    using ImportCell = std::variant<std::monostate, std::int64_t, double, SqliteStaticText>;
+
+    /**
+     * @brief Private writable mapping of the input file.
+     *
+     * Pages are copy-on-write, so parsers can unescape fields in place and
+     * the untouched pages stay shared with the page cache.
+     */
+    class MappedInput {
+      public:
+        explicit MappedInput(const std::filesystem::path& path) {
+#ifdef _WIN32
+          std::ifstream in(path, std::ios::binary);
+          if (!in) {
+            throw SqliteDbException("Cannot open import file: " + path.string());
+          }
+          mBuffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+          mData = mBuffer.data();
+          mSize = mBuffer.size();
+#else
+          int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+          if (fd < 0) {
+            throw SqliteDbException("Cannot open import file: " + path.string());
+          }
+          struct stat info;
+          if (::fstat(fd, &info) != 0) {
+            ::close(fd);
+            throw SqliteDbException("Cannot stat import file: " + path.string());
+          }
+          mSize = static_cast<std::size_t>(info.st_size);
+          if (mSize > 0) {
+            int flags = MAP_PRIVATE;
+#ifdef MAP_NORESERVE
+            flags |= MAP_NORESERVE;
+#endif
+            void* data = ::mmap(nullptr, mSize, PROT_READ | PROT_WRITE, flags, fd, 0);
+            ::close(fd);
+            if (data == MAP_FAILED) {
+              throw SqliteDbException("Cannot map import file: " + path.string());
+            }
+            ::madvise(data, mSize, MADV_SEQUENTIAL);
+            mData = static_cast<char*>(data);
+          } else {
+            ::close(fd);
+          }
+#endif
+        }
+
+        MappedInput(const MappedInput&) = delete;
+        MappedInput& operator=(const MappedInput&) = delete;
+
+        ~MappedInput() {
+#ifndef _WIN32
+          if (mData) {
+            ::munmap(mData, mSize);
+          }
+#endif
+        }
+
+        char* begin() const noexcept {
+          return mData;
+        }
+
+        char* end() const noexcept {
+          return mData + mSize;
+        }
+
+        std::size_t size() const noexcept {
+          return mSize;
+        }
+
+      private:
+        char* mData = nullptr;
+        std::size_t mSize = 0;
+#ifdef _WIN32
+        std::string mBuffer;
+#endif
+    };
+
+    /**
+     * @brief Rows of fields laid out contiguously, reused from batch to batch.
+     */
+    struct ImportBatch {
+      std::vector<ImportCell> cells;
+      std::size_t columns = 0;
+      std::size_t rows = 0;
+
+      auto rowViews() const {
+        return std::views::iota(std::size_t { 0 }, rows) | std::views::transform([this](std::size_t row) {
+          return std::span<const ImportCell>(cells.data() + row * columns, columns);
+        });
+      }
+    };
+
+    using ImportBatchPtr = std::unique_ptr<ImportBatch>;
+
+    /**
+     * @brief Blocking FIFO of bounded capacity between the parser and the writer.
+     */
+    template<typename T>
+    class BoundedQueue {
+      public:
+        explicit BoundedQueue(std::size_t capacity)
+          : mCapacity(std::max<std::size_t>(capacity, 1)) {
+        }
+
+        /**
+         * @brief Wait for room and enqueue; false once the queue is closed.
+         */
+        bool push(T item, std::size_t& waits) {
+          std::unique_lock lock(mMutex);
+          if (mItems.size() >= mCapacity && !mClosed) {
+            ++waits;
+            mNotFull.wait(lock, [this] {
+              return mItems.size() < mCapacity || mClosed;
+            });
+          }
+          if (mClosed) {
+            return false;
+          }
+          mItems.push_back(std::move(item));
+          mNotEmpty.notify_one();
+          return true;
+        }
+
+        /**
+         * @brief Wait for an item; empty once the queue is closed and drained.
+         */
+        std::optional<T> pop(std::size_t& waits) {
+          std::unique_lock lock(mMutex);
+          if (mItems.empty() && !mClosed) {
+            ++waits;
+            mNotEmpty.wait(lock, [this] {
+              return !mItems.empty() || mClosed;
+            });
+          }
+          return take();
+        }
+
+        std::optional<T> tryPop() {
+          std::lock_guard lock(mMutex);
+          return take();
+        }
+
+        void close() {
+          std::lock_guard lock(mMutex);
+          mClosed = true;
+          mNotFull.notify_all();
+          mNotEmpty.notify_all();
+        }
+
+      private:
+        std::size_t mCapacity;
+        std::mutex mMutex;
+        std::condition_variable mNotFull;
+        std::condition_variable mNotEmpty;
+        std::deque<T> mItems;
+        bool mClosed = false;
+
+        std::optional<T> take() {
+          if (mItems.empty()) {
+            return std::nullopt;
+          }
+          T item = std::move(mItems.front());
+          mItems.pop_front();
+          mNotFull.notify_one();
+          return item;
+        }
+    };
+
+    /**
+     * @brief Record reader over the mapped input.
+     *
+     * Delimiters are located with memchr, which the C library vectorizes.
+     */
+    class ImportParser {
+      public:
+        ImportParser(char* begin, char* end)
+          : mPos(begin)
+          , mEnd(end) {
+        }
+
+        virtual ~ImportParser() = default;
+
+        /**
+         * @brief Parse the next record into @p record.
+         * @return false at the end of the input.
+         */
+        virtual bool next(std::vector<ImportCell>& record) = 0;
+
+        std::size_t recordNumber() const noexcept {
+          return mRecord;
+        }
+
+      protected:
+        char* mPos;
+        char* mEnd;
+        std::size_t mRecord = 0;
+
+        char* findLineEnd(char* from) const {
+          void* newline = std::memchr(from, '\n', static_cast<std::size_t>(mEnd - from));
+          return newline ? static_cast<char*>(newline) : mEnd;
+        }
+
+        [[noreturn]] void fail(const char* format, const std::string& message) const {
+          throw SqliteDbException(std::string(format) + " record " + std::to_string(mRecord) + ": " + message);
+        }
+    };
+
+    class CsvParser : public ImportParser {
+      public:
+        CsvParser(char* begin, char* end, const SqliteDb::ImportOptions& options)
+          : ImportParser(begin, end)
+          , mDelimiter(options.delimiter)
+          , mQuote(options.quote)
+          , mEmptyAsNull(options.emptyAsNull) {
+        }
+
+        bool next(std::vector<ImportCell>& record) override {
+          record.clear();
+
+          // Blank lines carry no record
+          while (mPos < mEnd && (*mPos == '\n' || (*mPos == '\r' && mPos + 1 < mEnd && mPos[1] == '\n'))) {
+            mPos += *mPos == '\n' ? 1 : 2;
+          }
+          if (mPos >= mEnd) {
+            return false;
+          }
+          ++mRecord;
+
+          char* lineEnd = findLineEnd(mPos);
+          while (true) {
+            char* p = mPos;
+
+            if (p < lineEnd && *p == mQuote) {
+              p = parseQuoted(p, record);
+              if (p > lineEnd) {
+                // The quoted field spanned newlines
+                lineEnd = findLineEnd(p);
+              }
+              if (p == lineEnd || (p + 1 == lineEnd && *p == '\r')) {
+                mPos = lineEnd < mEnd ? lineEnd + 1 : mEnd;
+                return true;
+              }
+              if (*p != mDelimiter) {
+                fail("CSV", "unexpected character after closing quote");
+              }
+              mPos = p + 1;
+              continue;
+            }
+
+            void* found = std::memchr(p, mDelimiter, static_cast<std::size_t>(lineEnd - p));
+            char* delimiter = static_cast<char*>(found);
+            std::string_view text(p, static_cast<std::size_t>((delimiter ? delimiter : lineEnd) - p));
+            if (!delimiter && !text.empty() && text.back() == '\r') {
+              text.remove_suffix(1);
+            }
+
+            if (text.empty() && mEmptyAsNull) {
+              record.emplace_back(std::monostate { });
+            } else {
+              record.emplace_back(SqliteStaticText { text });
+            }
+
+            if (!delimiter) {
+              mPos = lineEnd < mEnd ? lineEnd + 1 : mEnd;
+              return true;
+            }
+            mPos = delimiter + 1;
+          }
+        }
+
+      private:
+        char mDelimiter;
+        char mQuote;
+        bool mEmptyAsNull;
+
+        /**
+         * @brief Parse the quoted field at @p open, collapsing doubled quotes in place.
+         * @return Position after the closing quote.
+         */
+        char* parseQuoted(char* open, std::vector<ImportCell>& record) {
+          char* start = open + 1;
+          char* read = start;
+          char* write = start;
+
+          while (true) {
+            void* found = std::memchr(read, mQuote, static_cast<std::size_t>(mEnd - read));
+            if (!found) {
+              fail("CSV", "unterminated quoted field");
+            }
+            char* quote = static_cast<char*>(found);
+            bool escaped = quote + 1 < mEnd && quote[1] == mQuote;
+
+            // Keep one quote of an escaped pair
+            std::size_t length = static_cast<std::size_t>(quote - read) + (escaped ? 1 : 0);
+            if (write != read) {
+              std::memmove(write, read, length);
+            }
+            write += length;
+
+            if (!escaped) {
+              record.emplace_back(SqliteStaticText { std::string_view(start, static_cast<std::size_t>(write - start)) });
+              return quote + 1;
+            }
+            read = quote + 2;
+          }
+        }
+    };
+
+    class NdjsonParser : public ImportParser {
+      public:
+        NdjsonParser(char* begin, char* end, const SqliteDb::ImportOptions& options)
+          : ImportParser(begin, end)
+          , mColumns(options.columns)
+          , mLearning(options.columns.empty()) {
+          for (std::size_t i = 0; i < options.columns.size(); ++i) {
+            mIndex.emplace(options.columns[i], i);
+          }
+        }
+
+        /**
+         * @brief Column names, known once the first record was parsed.
+         */
+        const std::vector<std::string>& getColumns() const noexcept {
+          return mColumns;
+        }
+
+        bool next(std::vector<ImportCell>& record) override {
+          skipWhitespace();
+          if (mPos >= mEnd) {
+            return false;
+          }
+          ++mRecord;
+
+          record.assign(mColumns.size(), std::monostate { });
+          expect('{');
+          skipWhitespace();
+
+          if (peek() == '}') {
+            ++mPos;
+          } else {
+            while (true) {
+              if (peek() != '"') {
+                fail("NDJSON", "expected a key");
+              }
+              std::string_view key = parseString();
+              skipWhitespace();
+              expect(':');
+              skipWhitespace();
+              ImportCell value = parseValue();
+
+              auto found = mIndex.find(key);
+              if (found != mIndex.end()) {
+                record[found->second] = value;
+              } else if (mLearning) {
+                // Keys of the first object define the columns; they stay valid in the mapping
+                mIndex.emplace(key, mColumns.size());
+                mColumns.emplace_back(key);
+                record.push_back(value);
+              }
+
+              skipWhitespace();
+              if (peek() == ',') {
+                ++mPos;
+                skipWhitespace();
+                continue;
+              }
+              expect('}');
+              break;
+            }
+          }
+
+          while (mPos < mEnd && (*mPos == ' ' || *mPos == '\t' || *mPos == '\r')) {
+            ++mPos;
+          }
+          if (mPos < mEnd && *mPos != '\n') {
+            fail("NDJSON", "trailing characters after the object");
+          }
+          mLearning = false;
+          return true;
+        }
+
+      private:
+        std::vector<std::string> mColumns;
+        std::unordered_map<std::string_view, std::size_t> mIndex;
+        bool mLearning;
+
+        char peek() const noexcept {
+          return mPos < mEnd ? *mPos : '\0';
+        }
+
+        void expect(char c) {
+          if (peek() != c) {
+            fail("NDJSON", std::string("expected '") + c + "'");
+          }
+          ++mPos;
+        }
+
+        void skipWhitespace() noexcept {
+          while (mPos < mEnd && (*mPos == ' ' || *mPos == '\t' || *mPos == '\r' || *mPos == '\n')) {
+            ++mPos;
+          }
+        }
+
+        /**
+         * @brief Find the quote closing the string whose content starts at @p from.
+         */
+        char* findClosingQuote(char* from) const {
+          while (true) {
+            void* found = std::memchr(from, '"', static_cast<std::size_t>(mEnd - from));
+            if (!found) {
+              fail("NDJSON", "unterminated string");
+            }
+            char* quote = static_cast<char*>(found);
+            std::size_t backslashes = 0;
+            for (char* c = quote; c > from && c[-1] == '\\'; --c) {
+              ++backslashes;
+            }
+            if (backslashes % 2 == 0) {
+              return quote;
+            }
+            from = quote + 1;
+          }
+        }
+
+        unsigned parseHex4(const char* p) const {
+          if (mEnd - p < 4) {
+            fail("NDJSON", "truncated \\u escape");
+          }
+          unsigned value = 0;
+          auto [end, ec] = std::from_chars(p, p + 4, value, 16);
+          if (ec != std::errc() || end != p + 4) {
+            fail("NDJSON", "invalid \\u escape");
+          }
+          return value;
+        }
+
+        /**
+         * @brief Parse the string at the current quote, unescaping it in place.
+         */
+        std::string_view parseString() {
+          char* start = mPos + 1;
+          char* close = findClosingQuote(start);
+          mPos = close + 1;
+
+          if (!std::memchr(start, '\\', static_cast<std::size_t>(close - start))) {
+            return std::string_view(start, static_cast<std::size_t>(close - start));
+          }
+
+          // Every escape is at least as long as its UTF-8 encoding
+          char* write = start;
+          for (char* read = start; read < close; ) {
+            if (*read != '\\') {
+              *write++ = *read++;
+              continue;
+            }
+            char escape = read[1];
+            read += 2;
+            switch (escape) {
+              case '"': *write++ = '"'; break;
+              case '\\': *write++ = '\\'; break;
+              case '/': *write++ = '/'; break;
+              case 'b': *write++ = '\b'; break;
+              case 'f': *write++ = '\f'; break;
+              case 'n': *write++ = '\n'; break;
+              case 'r': *write++ = '\r'; break;
+              case 't': *write++ = '\t'; break;
+              case 'u': {
+                unsigned code = parseHex4(read);
+                read += 4;
+                if (code >= 0xD800 && code <= 0xDBFF && close - read >= 6 && read[0] == '\\' && read[1] == 'u') {
+                  unsigned low = parseHex4(read + 2);
+                  if (low >= 0xDC00 && low <= 0xDFFF) {
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    read += 6;
+                  }
+                }
+                if (code < 0x80) {
+                  *write++ = static_cast<char>(code);
+                } else if (code < 0x800) {
+                  *write++ = static_cast<char>(0xC0 | (code >> 6));
+                  *write++ = static_cast<char>(0x80 | (code & 0x3F));
+                } else if (code < 0x10000) {
+                  *write++ = static_cast<char>(0xE0 | (code >> 12));
+                  *write++ = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                  *write++ = static_cast<char>(0x80 | (code & 0x3F));
+                } else {
+                  *write++ = static_cast<char>(0xF0 | (code >> 18));
+                  *write++ = static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+                  *write++ = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                  *write++ = static_cast<char>(0x80 | (code & 0x3F));
+                }
+                break;
+              }
+              default:
+                fail("NDJSON", std::string("invalid escape \\") + escape);
+            }
+          }
+          return std::string_view(start, static_cast<std::size_t>(write - start));
+        }
+
+        bool matchLiteral(std::string_view literal) {
+          if (static_cast<std::size_t>(mEnd - mPos) < literal.size()
+              || std::string_view(mPos, literal.size()) != literal) {
+            return false;
+          }
+          mPos += literal.size();
+          return true;
+        }
+
+        ImportCell parseValue() {
+          char c = peek();
+
+          if (c == '"') {
+            return SqliteStaticText { parseString() };
+          }
+
+          if (c == '{' || c == '[') {
+            // Nested values are kept as JSON text
+            char* start = mPos;
+            std::size_t depth = 0;
+            while (mPos < mEnd) {
+              char d = *mPos;
+              if (d == '"') {
+                mPos = findClosingQuote(mPos + 1) + 1;
+                continue;
+              }
+              ++mPos;
+              if (d == '{' || d == '[') {
+                ++depth;
+              } else if ((d == '}' || d == ']') && --depth == 0) {
+                return SqliteStaticText { std::string_view(start, static_cast<std::size_t>(mPos - start)) };
+              }
+            }
+            fail("NDJSON", "unterminated nested value");
+          }
+
+          if (matchLiteral("true")) {
+            return std::int64_t { 1 };
+          }
+          if (matchLiteral("false")) {
+            return std::int64_t { 0 };
+          }
+          if (matchLiteral("null")) {
+            return std::monostate { };
+          }
+
+          char* start = mPos;
+          bool real = false;
+          while (mPos < mEnd) {
+            char d = *mPos;
+            if (d == '.' || d == 'e' || d == 'E') {
+              real = true;
+            } else if (!(d == '-' || d == '+' || (d >= '0' && d <= '9'))) {
+              break;
+            }
+            ++mPos;
+          }
+          if (mPos == start) {
+            fail("NDJSON", "unexpected value");
+          }
+
+          if (!real) {
+            std::int64_t integer = 0;
+            auto [end, ec] = std::from_chars(start, mPos, integer);
+            if (ec == std::errc() && end == mPos) {
+              return integer;
+            }
+          }
+          double number = 0.0;
+          auto [end, ec] = std::from_chars(start, mPos, number);
+          if (ec != std::errc() || end != mPos) {
+            fail("NDJSON", "invalid number");
+          }
+          return number;
+        }
+    };
+
+    std::string quoteIdentifier(std::string_view name) {
+      std::string quoted = "\"";
+      for (char c : name) {
+        quoted += c;
+        if (c == '"') {
+          quoted += '"';
+        }
+      }
+      quoted += '"';
+      return quoted;
+    }
+
+  } /* namespace */
+
+  SqliteDb::ImportStats SqliteDb::importCsv(const std::filesystem::path& path, const std::string& table, const ImportOptions& options) {
+    return runImport(path, table, options, false);
+  }
+
+  SqliteDb::ImportStats SqliteDb::importCsv(const std::filesystem::path& path, const std::string& table) {
+    return importCsv(path, table, ImportOptions { });
+  }
+
+  SqliteDb::ImportStats SqliteDb::importNdjson(const std::filesystem::path& path, const std::string& table, const ImportOptions& options) {
+    return runImport(path, table, options, true);
+  }
+
+  SqliteDb::ImportStats SqliteDb::importNdjson(const std::filesystem::path& path, const std::string& table) {
+    return importNdjson(path, table, ImportOptions { });
+  }
+
+  SqliteDb::ImportStats SqliteDb::runImport(const std::filesystem::path& path, const std::string& table,
+                                            const ImportOptions& options, bool json) {
+    checkConnection();
+
+    const auto start = std::chrono::steady_clock::now();
+    ImportStats stats;
+
+    MappedInput input(path);
+    stats.bytes = input.size();
+
+    char* begin = input.begin();
+    if (input.size() >= 3 && std::memcmp(begin, "\xEF\xBB\xBF", 3) == 0) {
+      begin += 3;
+    }
+
+    // The first record is read here to settle the columns, then the parser
+    // moves to the worker thread
+    std::unique_ptr<ImportParser> parser;
+    std::vector<ImportCell> first;
+    bool hasFirst = false;
+    std::vector<std::string> columns = options.columns;
+    std::size_t width = columns.size();
+
+    if (json) {
+      auto ndjson = std::make_unique<NdjsonParser>(begin, input.end(), options);
+      hasFirst = ndjson->next(first);
+      columns = ndjson->getColumns();
+      width = columns.size();
+      parser = std::move(ndjson);
+    } else {
+      parser = std::make_unique<CsvParser>(begin, input.end(), options);
+      hasFirst = parser->next(first);
+      if (hasFirst && width == 0) {
+        width = first.size();
+      }
+      if (hasFirst && options.header) {
+        if (columns.empty()) {
+          for (std::size_t i = 0; i < first.size(); ++i) {
+            auto* name = std::get_if<SqliteStaticText>(&first[i]);
+            columns.emplace_back(name && !name->value.empty() ? std::string(name->value) : "c" + std::to_string(i + 1));
+          }
+        }
+        hasFirst = parser->next(first);
+      }
+    }
+
+    if (width == 0) {
+      stats.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+      return stats;
+    }
+
+    std::string columnList;
+    for (std::size_t i = 0; i < columns.size(); ++i) {
+      columnList += (i > 0 ? "," : "") + quoteIdentifier(columns[i]);
+    }
+
+    if (options.createTable) {
+      std::string definition = columnList;
+      if (definition.empty()) {
+        for (std::size_t i = 0; i < width; ++i) {
+          definition += (i > 0 ? "," : "") + quoteIdentifier("c" + std::to_string(i + 1));
+        }
+      }
+      execute("CREATE TABLE IF NOT EXISTS " + quoteIdentifier(table) + " (" + definition + ")");
+    }
+
+    std::string sql = "INSERT INTO " + quoteIdentifier(table);
+    if (!columnList.empty()) {
+      sql += " (" + columnList + ")";
+    }
+    sql += " VALUES (?";
+    for (std::size_t i = 1; i < width; ++i) {
+      sql += ",?";
+    }
+    sql += ")";
+
+    BatchOptions batchOptions;
+    batchOptions.useTransaction = false;
+
+    // Whole multi-row statements per batch keep the tail statement for the last batch only
+    std::size_t batchRows = std::max<std::size_t>(options.batchRows, 1);
+    std::size_t chunkRows = getBatchChunkRows(static_cast<int>(width), batchOptions);
+    if (chunkRows > 1 && batchRows > chunkRows) {
+      batchRows -= batchRows % chunkRows;
+    }
+
+    BoundedQueue<ImportBatchPtr> filled(options.queueDepth);
+    BoundedQueue<ImportBatchPtr> spare(options.queueDepth + 2);
+    std::exception_ptr parseError;
+    std::size_t parserWaits = 0;
+    std::size_t spareWaits = 0;
+
+    auto normalize = [&](std::vector<ImportCell>& record) {
+      if (record.size() != width) {
+        if (!options.allowRaggedRows && !json) {
+          throw SqliteDbException(
+              "CSV record " + std::to_string(parser->recordNumber()) + " has " + std::to_string(record.size())
+                  + " fields, expected " + std::to_string(width));
+        }
+        record.resize(width, std::monostate { });
+      }
+    };
+
+    std::thread worker([&] {
+      try {
+        std::vector<ImportCell> record = std::move(first);
+        bool pending = hasFirst;
+
+        while (pending) {
+          ImportBatchPtr batch;
+          if (auto recycled = spare.tryPop()) {
+            batch = std::move(*recycled);
+          } else {
+            batch = std::make_unique<ImportBatch>();
+            batch->cells.reserve(batchRows * width);
+          }
+          batch->columns = width;
+          batch->rows = 0;
+          batch->cells.clear();
+
+          while (pending && batch->rows < batchRows) {
+            normalize(record);
+            batch->cells.insert(batch->cells.end(), record.begin(), record.end());
+            ++batch->rows;
+            pending = parser->next(record);
+          }
+
+          if (!filled.push(std::move(batch), parserWaits)) {
+            // The writer gave up
+            break;
+          }
+        }
+      } catch (...) {
+        parseError = std::current_exception();
+      }
+      filled.close();
+    });
+
+    // Inside the caller's transaction only a savepoint may be opened and nothing committed
+    std::optional<SqliteTransaction> transaction;
+    std::optional<SqliteSavepoint> savepoint;
+    try {
+      if (isInTransaction()) {
+        savepoint.emplace(*this);
+      } else {
+        transaction.emplace(*this, options.transactionMode);
+      }
+      std::size_t rowsSinceCommit = 0;
+
+      while (auto batch = filled.pop(stats.writerWaits)) {
+        const ImportBatch& rows = **batch;
+        executeBatch(sql, rows.rowViews(), batchOptions);
+        stats.rows += rows.rows;
+        ++stats.batches;
+        rowsSinceCommit += rows.rows;
+
+        if (transaction && options.commitEvery > 0 && rowsSinceCommit >= options.commitEvery) {
+          transaction->commit();
+          ++stats.commits;
+          transaction.emplace(*this, options.transactionMode);
+          rowsSinceCommit = 0;
+        }
+        spare.push(std::move(*batch), spareWaits);
+      }
+    } catch (...) {
+      filled.close();
+      worker.join();
+      throw;
+    }
+
+    worker.join();
+    if (parseError) {
+      std::rethrow_exception(parseError);
+    }
+
+    if (transaction) {
+      transaction->commit();
+      ++stats.commits;
+    } else {
+      savepoint->release();
+    }
+
+    stats.parserWaits = parserWaits;
+    stats.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    return stats;
+  }
+
+} /* namespace sdb */
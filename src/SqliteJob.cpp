@@ -0,0 +1,82 @@
+#include <SqliteJob.hpp>
+#include <SqliteDb.hpp>
+#include <SqliteException.hpp>
+#include <SqliteSavepoint.hpp>
+
+namespace sdb {
+
+  SqliteJobBatch::SqliteJobBatch(SqliteDb& db, SqliteTransaction::Mode mode)
+    : mDb(db)
+    , mJobCount(0)
+    , mFailedCount(0) {
+    mTransaction.emplace(db, mode);
+  }
+
+  SqliteJobBatch::~SqliteJobBatch() {
+    if (mTransaction) {
+      abort(std::make_exception_ptr(SqliteTransactionException("Job batch abandoned before commit")));
+    }
+  }
+
+  bool SqliteJobBatch::run(SqliteJobPtr job) {
+    ++mJobCount;
+
+    if (!mTransaction) {
+      job->fail(std::make_exception_ptr(SqliteTransactionException("Job batch is no longer usable")));
+      return false;
+    }
+
+    try {
+      SqliteSavepoint savepoint(mDb);
+      try {
+        job->run(mDb);
+        savepoint.release();
+      } catch (...) {
+        auto error = std::current_exception();
+        savepoint.rollback();
+        ++mFailedCount;
+        job->fail(error);
+        return true;
+      }
+    } catch (...) {
+      // The savepoint machinery failed: the transaction cannot be trusted
+      auto error = std::current_exception();
+      job->fail(error);
+      abort(error);
+      return false;
+    }
+
+    mSucceeded.push_back(std::move(job));
+    return true;
+  }
+
+  bool SqliteJobBatch::commit() {
+    if (!mTransaction) {
+      return false;
+    }
+
+    try {
+      mTransaction->commit();
+    } catch (...) {
+      abort(std::current_exception());
+      return false;
+    }
+
+    mTransaction.reset();
+    for (auto& job : mSucceeded) {
+      job->complete();
+    }
+    mSucceeded.clear();
+    return true;
+  }
+
+  void SqliteJobBatch::abort(std::exception_ptr error) {
+    // Destroying the transaction rolls it back unless it already ended
+    mTransaction.reset();
+    for (auto& job : mSucceeded) {
+      job->fail(error);
+    }
+    mSucceeded.clear();
+  }
+
+} /* namespace sdb */
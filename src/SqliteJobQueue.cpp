@@ -0,0 +1,59 @@
+#include <SqliteJobQueue.hpp>
+#include <thread>
+
+namespace sdb {
+
+  bool SqliteJobQueue::push(SqliteJobPtr job) {
+    // Registering before the check lets close() wait for this push to land
+    bool accepted = !(mProducers.fetch_add(1, std::memory_order_acq_rel) & CLOSED);
+    if (accepted) {
+      mQueue.push(std::move(job));
+      mPending.release();
+    }
+    if (mProducers.fetch_sub(1, std::memory_order_acq_rel) & CLOSED) {
+      mProducers.notify_one();
+    }
+    return accepted;
+  }
+
+  void SqliteJobQueue::close() {
+    std::uint64_t state = mProducers.fetch_or(CLOSED, std::memory_order_acq_rel) | CLOSED;
+    while (state != CLOSED) {
+      mProducers.wait(state, std::memory_order_acquire);
+      state = mProducers.load(std::memory_order_acquire);
+    }
+    // A null job tells the worker to stop once everything before it ran
+    mQueue.push(nullptr);
+    mPending.release();
+  }
+
+  SqliteJobPtr SqliteJobQueue::pop() {
+    mPending.acquire();
+    return popCounted();
+  }
+
+  std::optional<SqliteJobPtr> SqliteJobQueue::tryPop() {
+    if (!mPending.try_acquire()) {
+      return std::nullopt;
+    }
+    return popCounted();
+  }
+
+  std::optional<SqliteJobPtr> SqliteJobQueue::tryPopUntil(std::chrono::steady_clock::time_point deadline) {
+    if (!mPending.try_acquire_until(deadline)) {
+      return std::nullopt;
+    }
+    return popCounted();
+  }
+
+  SqliteJobPtr SqliteJobQueue::popCounted() {
+    // The semaphore guarantees an element; wait for its producer to link it
+    while (true) {
+      if (auto job = mQueue.pop()) {
+        return std::move(*job);
+      }
+      std::this_thread::yield();
+    }
+  }
+
+} /* namespace sdb */
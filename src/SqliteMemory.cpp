@@ -0,0 +1,182 @@
+#include "../sqlite/sqlite3.h"
+#include <SqliteMemory.hpp>
+#include <SqliteException.hpp>
+#include <array>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+
+namespace sdb {
+
+  namespace {
+
+    // Keeps the returned pointers 16-byte aligned; holds the usable size
+    constexpr std::size_t HEADER_SIZE = 16;
+    constexpr std::size_t MIN_CLASS_SIZE = 16;
+    constexpr std::size_t CLASS_COUNT = 9; // 16 B .. 4 KiB
+
+    std::size_t gMaxCachedPerClass = 0;
+
+    struct FreeBlock {
+      FreeBlock* next;
+    };
+
+    // Trivially destructible so that it stays usable after CacheOwner ran
+    struct ThreadCache {
+      std::array<FreeBlock*, CLASS_COUNT> heads;
+      std::array<std::size_t, CLASS_COUNT> counts;
+      bool retired;
+    };
+
+    constinit thread_local ThreadCache tCache {};
+
+    struct CacheOwner {
+      ~CacheOwner() {
+        for (std::size_t i = 0; i < CLASS_COUNT; ++i) {
+          while (FreeBlock* block = tCache.heads[i]) {
+            tCache.heads[i] = block->next;
+            std::free(reinterpret_cast<unsigned char*>(block) - HEADER_SIZE);
+          }
+          tCache.counts[i] = 0;
+        }
+        // Frees during the rest of thread teardown bypass the cache
+        tCache.retired = true;
+      }
+    };
+
+    // Every path that fills the cache registers its cleanup for thread exit,
+    // including threads that only ever free blocks allocated elsewhere
+    ThreadCache& threadCache() {
+      static thread_local CacheOwner owner;
+      (void) owner;
+      return tCache;
+    }
+
+    int sizeClass(std::size_t size) {
+      std::size_t classSize = MIN_CLASS_SIZE;
+      for (std::size_t i = 0; i < CLASS_COUNT; ++i, classSize <<= 1) {
+        if (size <= classSize) {
+          return static_cast<int>(i);
+        }
+      }
+      return -1;
+    }
+
+    std::size_t roundUp(std::size_t size) {
+      int index = sizeClass(size);
+      return index >= 0 ? MIN_CLASS_SIZE << index : (size + 7) & ~std::size_t(7);
+    }
+
+    std::size_t& usableSize(void* payload) {
+      return *reinterpret_cast<std::size_t*>(static_cast<unsigned char*>(payload) - HEADER_SIZE);
+    }
+
+    void* poolMalloc(int requested) {
+      if (requested <= 0) {
+        return nullptr;
+      }
+      std::size_t size = roundUp(static_cast<std::size_t>(requested));
+
+      int index = sizeClass(size);
+      if (index >= 0 && !tCache.retired) {
+        ThreadCache& cache = threadCache();
+        if (FreeBlock* block = cache.heads[index]) {
+          cache.heads[index] = block->next;
+          --cache.counts[index];
+          return block;
+        }
+      }
+
+      auto* raw = static_cast<unsigned char*>(std::malloc(HEADER_SIZE + size));
+      if (!raw) {
+        return nullptr;
+      }
+      *reinterpret_cast<std::size_t*>(raw) = size;
+      return raw + HEADER_SIZE;
+    }
+
+    void poolFree(void* payload) {
+      if (!payload) {
+        return;
+      }
+      int index = sizeClass(usableSize(payload));
+      if (index >= 0 && !tCache.retired && tCache.counts[index] < gMaxCachedPerClass) {
+        // The link lives in the payload so the size header survives for reuse
+        ThreadCache& cache = threadCache();
+        auto* block = static_cast<FreeBlock*>(payload);
+        block->next = cache.heads[index];
+        cache.heads[index] = block;
+        ++cache.counts[index];
+        return;
+      }
+      std::free(static_cast<unsigned char*>(payload) - HEADER_SIZE);
+    }
+
+    int poolSize(void* payload) {
+      return payload ? static_cast<int>(usableSize(payload)) : 0;
+    }
+
+    void* poolRealloc(void* payload, int requested) {
+      if (payload && requested > 0 && static_cast<std::size_t>(requested) <= usableSize(payload)) {
+        return payload;
+      }
+
+      void* grown = poolMalloc(requested);
+      if (grown && payload) {
+        std::memcpy(grown, payload, usableSize(payload));
+        poolFree(payload);
+      }
+      return grown;
+    }
+
+    int poolRoundup(int size) {
+      std::size_t rounded = roundUp(static_cast<std::size_t>(size));
+      return rounded > INT_MAX ? size : static_cast<int>(rounded);
+    }
+
+    int poolInit(void*) {
+      return SQLITE_OK;
+    }
+
+    void poolShutdown(void*) {
+    }
+
+    void checkConfig(int rc, const char* option) {
+      if (rc != SQLITE_OK) {
+        throw SqliteDbException(std::string("sqlite3_config(") + option + ") failed: " + sqlite3_errstr(rc), rc);
+      }
+    }
+
+  }
+
+  void SqliteMemory::installThreadCachingPool(std::size_t maxCachedPerClass) {
+    static const sqlite3_mem_methods methods = {
+      poolMalloc, poolFree, poolRealloc, poolSize, poolRoundup, poolInit, poolShutdown, nullptr
+    };
+
+    gMaxCachedPerClass = maxCachedPerClass;
+    checkConfig(sqlite3_config(SQLITE_CONFIG_MALLOC, &methods), "SQLITE_CONFIG_MALLOC");
+  }
+
+  void SqliteMemory::installArena(std::size_t bytes, int minAllocation) {
+#ifdef SQLITE_ENABLE_MEMSYS5
+    if (bytes == 0 || bytes > static_cast<std::size_t>(INT_MAX)) {
+      throw SqliteDbException("Arena size must be in (0, " + std::to_string(INT_MAX) + "] bytes");
+    }
+
+    // SQLite keeps using the arena until the process exits
+    static std::unique_ptr<unsigned char[]> arena;
+    auto buffer = std::make_unique<unsigned char[]>(bytes);
+    checkConfig(sqlite3_config(SQLITE_CONFIG_HEAP, buffer.get(), static_cast<int>(bytes), minAllocation),
+                "SQLITE_CONFIG_HEAP");
+    arena = std::move(buffer);
+#else
+    (void) bytes;
+    (void) minAllocation;
+    throw SqliteDbException("Arena allocator requires building with SQLITE_ENABLE_MEMSYS5");
+#endif
+  }
+
+} /* namespace sdb */
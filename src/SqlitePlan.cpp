@@ -0,0 +1,87 @@
+#include <SqlitePlan.hpp>
+#include <functional>
+#include <map>
+
+namespace sdb {
+
+  namespace {
+
+    bool anyNode(const std::vector<SqlitePlanNode>& nodes, const std::function<bool(const SqlitePlanNode&)>& predicate) {
+      for (const auto& node : nodes) {
+        if (predicate(node) || anyNode(node.children, predicate)) {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    void render(const std::vector<SqlitePlanNode>& nodes, const std::string& indent, std::string& out) {
+      for (std::size_t i = 0; i < nodes.size(); ++i) {
+        bool last = i + 1 == nodes.size();
+        out += indent;
+        out += last ? "`--" : "|--";
+        out += nodes[i].detail;
+        out += '\n';
+        render(nodes[i].children, indent + (last ? "   " : "|  "), out);
+      }
+    }
+
+  }
+
+  bool SqlitePlanNode::isFullScan() const {
+    // Constant rows and materialized subqueries are not table reads
+    return detail.starts_with("SCAN ") && !detail.starts_with("SCAN CONSTANT ROW")
+        && !detail.starts_with("SCAN (");
+  }
+
+  bool SqlitePlanNode::usesAutomaticIndex() const {
+    return detail.find("AUTOMATIC") != std::string::npos;
+  }
+
+  SqlitePlan SqlitePlan::fromRows(std::vector<SqlitePlanNode> rows) {
+    std::map<int, std::vector<SqlitePlanNode*>> childrenOf;
+    for (auto& row : rows) {
+      childrenOf[row.parent].push_back(&row);
+    }
+
+    std::function<std::vector<SqlitePlanNode>(int)> build = [&](int parent) {
+      std::vector<SqlitePlanNode> nodes;
+      auto it = childrenOf.find(parent);
+      if (it == childrenOf.end()) {
+        return nodes;
+      }
+      for (SqlitePlanNode* row : it->second) {
+        SqlitePlanNode node { row->id, row->parent, std::move(row->detail), { } };
+        // Guard against a malformed plan pointing a node at itself
+        if (node.id != parent) {
+          node.children = build(node.id);
+        }
+        nodes.push_back(std::move(node));
+      }
+      return nodes;
+    };
+
+    SqlitePlan plan;
+    plan.roots = build(0);
+    return plan;
+  }
+
+  bool SqlitePlan::hasFullScan() const {
+    return anyNode(roots, [](const SqlitePlanNode& node) {
+      return node.isFullScan();
+    });
+  }
+
+  bool SqlitePlan::hasAutomaticIndex() const {
+    return anyNode(roots, [](const SqlitePlanNode& node) {
+      return node.usesAutomaticIndex();
+    });
+  }
+
+  std::string SqlitePlan::toString() const {
+    std::string out;
+    render(roots, "", out);
+    return out;
+  }
+
+} /* namespace sdb */
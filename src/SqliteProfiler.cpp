@@ -0,0 +1,227 @@
+#include "../sqlite/sqlite3.h"
+#include <SqliteProfiler.hpp>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <memory>
+#include <sstream>
+
+namespace sdb {
+
+  namespace {
+
+    void appendLabel(std::ostringstream& out, std::string_view sql) {
+      out << "sql=\"";
+      for (char c : sql) {
+        switch (c) {
+          case '\\':
+            out << "\\\\";
+            break;
+          case '"':
+            out << "\\\"";
+            break;
+          case '\n':
+            out << "\\n";
+            break;
+          default:
+            out << c;
+            break;
+        }
+      }
+      out << '"';
+    }
+
+    double toSeconds(std::chrono::nanoseconds duration) {
+      return std::chrono::duration<double>(duration).count();
+    }
+
+  }
+
+  void SqliteProfiler::Histogram::add(std::chrono::nanoseconds duration) {
+    auto micros = static_cast<std::uint64_t>((std::max<std::int64_t>(duration.count(), 0) + 999) / 1000);
+    std::size_t index = micros <= 1 ? 0 : static_cast<std::size_t>(std::bit_width(micros - 1));
+
+    ++counts[std::min(index, BUCKETS - 1)];
+    ++count;
+    sum += duration;
+    max = std::max(max, duration);
+  }
+
+  std::chrono::nanoseconds SqliteProfiler::Histogram::upperBound(std::size_t index) {
+    if (index >= BUCKETS - 1) {
+      return std::chrono::nanoseconds::max();
+    }
+    return std::chrono::microseconds(std::int64_t(1) << index);
+  }
+
+  std::chrono::nanoseconds SqliteProfiler::Histogram::quantile(double q) const {
+    if (count == 0) {
+      return std::chrono::nanoseconds(0);
+    }
+
+    auto rank = static_cast<std::uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * static_cast<double>(count)));
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < BUCKETS; ++i) {
+      seen += counts[i];
+      if (seen >= std::max<std::uint64_t>(rank, 1)) {
+        return std::min(upperBound(i), max);
+      }
+    }
+    return max;
+  }
+
+  SqliteProfiler::SqliteProfiler(Options options)
+    : mOptions(std::move(options))
+    , mDroppedExecutions(0) {
+  }
+
+  void SqliteProfiler::begin(sqlite3_stmt* stmt) {
+    // Called by the connection's thread only, so mRunning needs no lock
+    auto now = std::chrono::steady_clock::now();
+    for (auto& running : mRunning) {
+      if (running.first == stmt) {
+        running.second = now;
+        return;
+      }
+    }
+    mRunning.emplace_back(stmt, now);
+  }
+
+  void SqliteProfiler::record(sqlite3_stmt* stmt, std::chrono::nanoseconds sqliteDuration, const Counters& run) {
+    std::chrono::nanoseconds duration = sqliteDuration;
+    auto running = std::find_if(mRunning.begin(), mRunning.end(), [stmt](const auto& entry) {
+      return entry.first == stmt;
+    });
+    if (running != mRunning.end()) {
+      duration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - running->second);
+      *running = mRunning.back();
+      mRunning.pop_back();
+    }
+
+    const char* text = sqlite3_sql(stmt);
+    std::string_view sql = text ? text : "";
+
+    {
+      std::lock_guard lock(mMutex);
+
+      auto it = mEntries.find(sql);
+      if (it == mEntries.end()) {
+        if (mEntries.size() >= mOptions.maxStatements) {
+          ++mDroppedExecutions;
+        } else {
+          it = mEntries.emplace(std::string(sql), Entry { }).first;
+        }
+      }
+
+      if (it != mEntries.end()) {
+        Entry& entry = it->second;
+        entry.latency.add(duration);
+        entry.counters.fullscanSteps += run.fullscanSteps;
+        entry.counters.sorts += run.sorts;
+        entry.counters.autoindexes += run.autoindexes;
+        entry.counters.vmSteps += run.vmSteps;
+        entry.counters.memoryUsed = std::max(entry.counters.memoryUsed, run.memoryUsed);
+      }
+    }
+
+    if (mOptions.onSlowQuery && mOptions.slowThreshold.count() > 0 && duration >= mOptions.slowThreshold) {
+      SlowQuery slow;
+      slow.duration = duration;
+      slow.counters = run;
+      if (char* expanded = mOptions.expandSlowQueries ? sqlite3_expanded_sql(stmt) : nullptr) {
+        std::unique_ptr<char, decltype(&sqlite3_free)> owner(expanded, &sqlite3_free);
+        slow.sql = expanded;
+      } else {
+        slow.sql = sql;
+      }
+      mOptions.onSlowQuery(slow);
+    }
+  }
+
+  void SqliteProfiler::recordFailure() noexcept {
+    mFailedExecutions.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  SqliteProfiler::Snapshot SqliteProfiler::snapshot() const {
+    Snapshot result;
+    {
+      std::lock_guard lock(mMutex);
+      result.statements.reserve(mEntries.size());
+      for (const auto& [sql, entry] : mEntries) {
+        result.statements.push_back(StatementProfile { sql, entry.latency, entry.counters });
+      }
+      result.droppedExecutions = mDroppedExecutions;
+      result.failedExecutions = mFailedExecutions.load(std::memory_order_relaxed);
+    }
+
+    std::sort(result.statements.begin(), result.statements.end(), [](const auto& a, const auto& b) {
+      return a.latency.sum > b.latency.sum;
+    });
+    return result;
+  }
+
+  void SqliteProfiler::reset() {
+    std::lock_guard lock(mMutex);
+    mEntries.clear();
+    mDroppedExecutions = 0;
+    mFailedExecutions.store(0, std::memory_order_relaxed);
+  }
+
+  std::string SqliteProfiler::Snapshot::toPrometheus(std::string_view prefix) const {
+    std::ostringstream out;
+    out.precision(9);
+
+    const std::string duration = std::string(prefix) + "_statement_duration_seconds";
+    out << "# HELP " << duration << " Statement execution time.\n";
+    out << "# TYPE " << duration << " histogram\n";
+    for (const auto& statement : statements) {
+      std::uint64_t cumulative = 0;
+      for (std::size_t i = 0; i < Histogram::BUCKETS; ++i) {
+        cumulative += statement.latency.counts[i];
+        out << duration << "_bucket{";
+        appendLabel(out, statement.sql);
+        if (i + 1 < Histogram::BUCKETS) {
+          out << ",le=\"" << toSeconds(Histogram::upperBound(i)) << "\"} ";
+        } else {
+          out << ",le=\"+Inf\"} ";
+        }
+        out << cumulative << '\n';
+      }
+      out << duration << "_sum{";
+      appendLabel(out, statement.sql);
+      out << "} " << toSeconds(statement.latency.sum) << '\n';
+      out << duration << "_count{";
+      appendLabel(out, statement.sql);
+      out << "} " << statement.latency.count << '\n';
+    }
+
+    auto counter = [&](const char* name, const char* type, const char* help, auto field) {
+      const std::string metric = std::string(prefix) + name;
+      out << "# HELP " << metric << ' ' << help << '\n';
+      out << "# TYPE " << metric << ' ' << type << '\n';
+      for (const auto& statement : statements) {
+        out << metric << '{';
+        appendLabel(out, statement.sql);
+        out << "} " << statement.counters.*field << '\n';
+      }
+    };
+    counter("_statement_fullscan_steps_total", "counter", "Full table scan steps.", &Counters::fullscanSteps);
+    counter("_statement_sorts_total", "counter", "Sort operations.", &Counters::sorts);
+    counter("_statement_autoindexes_total", "counter", "Rows inserted into automatic indexes.", &Counters::autoindexes);
+    counter("_statement_vm_steps_total", "counter", "Virtual machine operations.", &Counters::vmSteps);
+    counter("_statement_memory_bytes", "gauge", "Peak heap used by the prepared statement.", &Counters::memoryUsed);
+
+    const std::string dropped = std::string(prefix) + "_profiler_dropped_executions_total";
+    out << "# HELP " << dropped << " Executions not recorded because too many distinct statements were tracked.\n";
+    out << "# TYPE " << dropped << " counter\n";
+    out << dropped << ' ' << droppedExecutions << '\n';
+
+    const std::string failed = std::string(prefix) + "_profiler_failed_executions_total";
+    out << "# HELP " << failed << " Executions whose recording or slow-query callback threw.\n";
+    out << "# TYPE " << failed << " counter\n";
+    out << failed << ' ' << failedExecutions << '\n';
+
+    return out.str();
+  }
+
+} /* namespace sdb */
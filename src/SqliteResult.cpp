@@ -0,0 +1,25 @@
+#include "../sqlite/sqlite3.h"
+#include <SqliteResult.hpp>
+#include <SqliteException.hpp>
+
+namespace sdb {
+
+  bool SqliteError::isBusy() const noexcept {
+    return code() == SQLITE_BUSY || code() == SQLITE_LOCKED;
+  }
+
+  std::string SqliteError::message() const {
+    std::string text = mOperation ? mOperation : "sqlite";
+    if (mIndex > 0) {
+      text += " at index " + std::to_string(mIndex);
+    }
+    text += ": ";
+    text += sqlite3_errstr(mExtendedCode);
+    return text;
+  }
+
+  void SqliteError::raise() const {
+    throw SqliteStatementException(message(), mExtendedCode);
+  }
+
+} /* namespace sdb */
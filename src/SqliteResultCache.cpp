@@ -0,0 +1,460 @@
+#include <SqliteResultCache.hpp>
+#include <SqliteDb.hpp>
+#include <SqliteException.hpp>
+#include <SqliteValueBinder.hpp>
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <utility>
+
+namespace sdb {
+
+  namespace {
+
+    struct ReadCollector {
+      std::vector<std::pair<std::string, std::string>> reads;
+      bool failed = false;
+      /** Authorizer that was installed before planning, consulted after recording. */
+      int (*next)(void*, int, const char*, const char*, const char*, const char*) = nullptr;
+      void* nextContext = nullptr;
+    };
+
+    int collectReads(void* context, int action, const char* first, const char* second, const char* schema,
+                     const char* trigger) {
+      auto* collector = static_cast<ReadCollector*>(context);
+      // count(*) and friends report the table with no column and no schema
+      if (action == SQLITE_READ && first) {
+        try {
+          collector->reads.emplace_back(schema ? schema : "", first);
+        } catch (...) {
+          // An incomplete plan would miss invalidations
+          collector->failed = true;
+          return SQLITE_DENY;
+        }
+      }
+      return collector->next ? collector->next(collector->nextContext, action, first, second, schema, trigger)
+                             : SQLITE_OK;
+    }
+
+    template<typename T>
+    void appendRaw(std::string& key, const T& value) {
+      key.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void appendBytes(std::string& key, const void* data, std::size_t size) {
+      appendRaw(key, size);
+      key.append(static_cast<const char*>(data), size);
+    }
+
+  } /* namespace */
+
+  std::size_t detail::SqliteResultData::getMemoryUsed() const noexcept {
+    std::size_t bytes = sizeof(*this) + cells.capacity() * sizeof(SqliteResultCell) + arena.capacity();
+    for (const auto& name : columnNames) {
+      bytes += sizeof(name) + name.capacity();
+    }
+    return bytes;
+  }
+
+  std::size_t SqliteCachedResult::getRowCount() const noexcept {
+    return mData->rows;
+  }
+
+  int SqliteCachedResult::getColumnCount() const noexcept {
+    return static_cast<int>(mData->columnNames.size());
+  }
+
+  const std::string& SqliteCachedResult::getColumnName(int column) const {
+    if (column < 0 || column >= getColumnCount()) {
+      throw SqliteStatementException("Column index " + std::to_string(column) + " out of range");
+    }
+    return mData->columnNames[static_cast<std::size_t>(column)];
+  }
+
+  const detail::SqliteResultCell& SqliteCachedResult::cell(std::size_t row, int column) const {
+    if (row >= mData->rows) {
+      throw SqliteStatementException("Row index " + std::to_string(row) + " out of range");
+    }
+    if (column < 0 || column >= getColumnCount()) {
+      throw SqliteStatementException("Column index " + std::to_string(column) + " out of range");
+    }
+    return mData->cells[row * mData->columnNames.size() + static_cast<std::size_t>(column)];
+  }
+
+  bool SqliteCachedResult::isNull(std::size_t row, int column) const {
+    return cell(row, column).type == SQLITE_NULL;
+  }
+
+  std::int64_t SqliteCachedResult::getInt64(std::size_t row, int column) const {
+    const auto& value = cell(row, column);
+    switch (value.type) {
+      case SQLITE_INTEGER:
+        return value.integer;
+      case SQLITE_FLOAT:
+        return static_cast<std::int64_t>(value.real);
+      case SQLITE_NULL:
+        return 0;
+      default:
+        throw SqliteStatementException("Cached column " + std::to_string(column) + " is not a number");
+    }
+  }
+
+  double SqliteCachedResult::getDouble(std::size_t row, int column) const {
+    const auto& value = cell(row, column);
+    switch (value.type) {
+      case SQLITE_INTEGER:
+        return static_cast<double>(value.integer);
+      case SQLITE_FLOAT:
+        return value.real;
+      case SQLITE_NULL:
+        return 0.0;
+      default:
+        throw SqliteStatementException("Cached column " + std::to_string(column) + " is not a number");
+    }
+  }
+
+  std::string_view SqliteCachedResult::getStringView(std::size_t row, int column) const {
+    const auto& value = cell(row, column);
+    if (value.type == SQLITE_NULL) {
+      return { };
+    }
+    if (value.type != SQLITE_TEXT && value.type != SQLITE_BLOB) {
+      throw SqliteStatementException("Cached column " + std::to_string(column) + " is not text");
+    }
+    return std::string_view(reinterpret_cast<const char*>(mData->arena.data() + value.offset), value.size);
+  }
+
+  std::span<const std::byte> SqliteCachedResult::getBlobSpan(std::size_t row, int column) const {
+    const auto& value = cell(row, column);
+    if (value.type == SQLITE_NULL) {
+      return { };
+    }
+    if (value.type != SQLITE_TEXT && value.type != SQLITE_BLOB) {
+      throw SqliteStatementException("Cached column " + std::to_string(column) + " is not a blob");
+    }
+    return std::span<const std::byte>(mData->arena.data() + value.offset, value.size);
+  }
+
+  SqliteValue SqliteCachedResult::getValue(std::size_t row, int column) const {
+    const auto& value = cell(row, column);
+    switch (value.type) {
+      case SQLITE_INTEGER:
+        return value.integer;
+      case SQLITE_FLOAT:
+        return value.real;
+      case SQLITE_TEXT:
+        return std::string(reinterpret_cast<const char*>(mData->arena.data() + value.offset), value.size);
+      case SQLITE_BLOB: {
+        const std::byte* data = mData->arena.data() + value.offset;
+        return std::vector<std::byte>(data, data + value.size);
+      }
+      default:
+        return std::monostate { };
+    }
+  }
+
+  SqliteResultCache::SqliteResultCache(SqliteDb& db, Options options)
+    : mDb(db)
+    , mOptions(options) {
+  }
+
+  SqliteResultCache::Stats SqliteResultCache::getStats() const {
+    std::lock_guard lock(mMutex);
+    Stats stats = mStats;
+    stats.entries = mIndex.size();
+    return stats;
+  }
+
+  void SqliteResultCache::clear() {
+    mEpoch.fetch_add(1, std::memory_order_acq_rel);
+    std::lock_guard lock(mMutex);
+    mIndex.clear();
+    mEntries.clear();
+    mPlans.clear();
+    mStats.bytes = 0;
+  }
+
+  void SqliteResultCache::invalidate(const std::string& table) {
+    std::lock_guard lock(mMutex);
+    tableCounter(table).fetch_add(1, std::memory_order_acq_rel);
+  }
+
+  void SqliteResultCache::onUpdate(ChangeOperation, std::string_view, std::string_view table, std::int64_t) {
+    mHookedChanges.fetch_add(1, std::memory_order_relaxed);
+    mDirty.store(true, std::memory_order_relaxed);
+
+    // Bulk writes hit the same table row after row: skip the map lookup
+    if (!mLastCounter || table != mLastTable) {
+      try {
+        mLastCounter = nullptr;
+        std::lock_guard lock(mMutex);
+        mLastTable = table;
+        mLastCounter = &tableCounter(mLastTable);
+      } catch (...) {
+        // The table could not be tracked: every entry has to go
+        mEpoch.fetch_add(1, std::memory_order_acq_rel);
+        return;
+      }
+    }
+    mLastCounter->fetch_add(1, std::memory_order_acq_rel);
+  }
+
+  void SqliteResultCache::onCommit() {
+    mDirty.store(false, std::memory_order_relaxed);
+  }
+
+  void SqliteResultCache::onRollback() {
+    mDirty.store(false, std::memory_order_relaxed);
+  }
+
+  SqliteCachedResult SqliteResultCache::query(const std::string& sql, const std::vector<SqliteValue>& parameters) {
+    checkUnhookedChanges();
+    std::string key = makeKey(sql, parameters);
+
+    std::shared_ptr<const detail::SqliteResultData> data;
+    std::shared_ptr<const Plan> plan;
+    Snapshot stored;
+    {
+      std::lock_guard lock(mMutex);
+      if (auto found = mIndex.find(key); found != mIndex.end()) {
+        data = found->second->data;
+        plan = found->second->plan;
+        stored = found->second->snapshot;
+      }
+    }
+
+    if (data) {
+      Snapshot now = takeSnapshot(*plan);
+      bool current = now.epoch == stored.epoch && now.tables == stored.tables && now.dataVersions == stored.dataVersions;
+
+      std::lock_guard lock(mMutex);
+      auto found = mIndex.find(key);
+      if (current) {
+        ++mStats.hits;
+        if (found != mIndex.end()) {
+          mEntries.splice(mEntries.begin(), mEntries, found->second);
+        }
+        return SqliteCachedResult(std::move(data), true);
+      }
+      if (found != mIndex.end() && found->second->data == data) {
+        eraseEntry(found->second);
+        ++mStats.invalidations;
+      }
+    }
+
+    {
+      std::lock_guard lock(mMutex);
+      ++mStats.misses;
+    }
+
+    plan = planFor(sql);
+    bool clean = !mDirty.load(std::memory_order_relaxed);
+    Snapshot before = takeSnapshot(*plan);
+
+    auto result = std::make_shared<detail::SqliteResultData>();
+    {
+      auto cached = mDb.cachedPrepare(sql);
+      SqliteStatement& stmt = *cached;
+      SqliteValueBinder binder(stmt);
+      for (std::size_t i = 0; i < parameters.size(); ++i) {
+        binder.bind(static_cast<int>(i) + 1, parameters[i]);
+      }
+
+      sqlite3_stmt* raw = stmt.mStatement.get();
+      int columns = sqlite3_column_count(raw);
+      for (int column = 0; column < columns; ++column) {
+        const char* name = sqlite3_column_name(raw, column);
+        result->columnNames.emplace_back(name ? name : "");
+      }
+
+      while (stmt.step()) {
+        for (int column = 0; column < columns; ++column) {
+          detail::SqliteResultCell cell { };
+          cell.type = static_cast<std::uint8_t>(sqlite3_column_type(raw, column));
+          switch (cell.type) {
+            case SQLITE_INTEGER:
+              cell.integer = sqlite3_column_int64(raw, column);
+              break;
+            case SQLITE_FLOAT:
+              cell.real = sqlite3_column_double(raw, column);
+              break;
+            case SQLITE_TEXT:
+            case SQLITE_BLOB: {
+              const void* bytes = cell.type == SQLITE_TEXT
+                ? static_cast<const void*>(sqlite3_column_text(raw, column))
+                : sqlite3_column_blob(raw, column);
+              cell.size = static_cast<std::uint32_t>(sqlite3_column_bytes(raw, column));
+              cell.offset = result->arena.size();
+              if (cell.size > 0) {
+                result->arena.resize(cell.offset + cell.size);
+                std::memcpy(result->arena.data() + cell.offset, bytes, cell.size);
+              }
+              break;
+            }
+            default:
+              break;
+          }
+          result->cells.push_back(cell);
+        }
+        ++result->rows;
+      }
+    }
+    result->cells.shrink_to_fit();
+    result->arena.shrink_to_fit();
+
+    // A result read over uncommitted writes could outlive a rollback
+    clean = clean && !mDirty.load(std::memory_order_relaxed);
+    std::size_t bytes = result->getMemoryUsed() + sizeof(Entry) + 2 * key.size()
+                        + before.tables.size() * sizeof(std::uint64_t)
+                        + before.dataVersions.size() * sizeof(std::int64_t);
+    if (clean && bytes <= mOptions.maxEntryBytes && bytes <= mOptions.maxBytes) {
+      Entry entry;
+      entry.key = std::move(key);
+      entry.data = result;
+      entry.plan = std::move(plan);
+      entry.snapshot = std::move(before);
+      entry.bytes = bytes;
+      store(std::move(entry));
+    }
+    return SqliteCachedResult(std::move(result), false);
+  }
+
+  std::shared_ptr<const SqliteResultCache::Plan> SqliteResultCache::planFor(const std::string& sql) {
+    {
+      std::lock_guard lock(mMutex);
+      if (auto found = mPlans.find(sql); found != mPlans.end()) {
+        return found->second;
+      }
+    }
+
+    ReadCollector collector;
+    SqliteStatementPtr stmt;
+    {
+      auto lock = mDb.lockConnection();
+      sqlite3* connection = mDb.mConnection.get();
+      if (mDb.mAuthorizer) {
+        collector.next = &SqliteDb::dispatchAuthorizer;
+        collector.nextContext = &mDb;
+      }
+
+      // Cached statements are never re-authorized, so plan with a fresh prepare
+      sqlite3_stmt* raw = nullptr;
+      sqlite3_set_authorizer(connection, &collectReads, &collector);
+      int rc = sqlite3_prepare_v2(connection, sql.c_str(), -1, &raw, nullptr);
+      mDb.updateAuthorizer();
+      stmt.reset(raw);
+      if (collector.failed) {
+        throw std::bad_alloc();
+      }
+      if (rc != SQLITE_OK) {
+        throw SqliteDbException("Failed to prepare statement: " + std::string(sqlite3_errmsg(connection)), rc);
+      }
+    }
+    if (!stmt || sqlite3_stmt_readonly(stmt.get()) == 0) {
+      throw SqliteStatementException("Only read-only statements can be cached: " + sql);
+    }
+    // Hand the statement to the statement cache for the execution that follows
+    SqliteCachedStatement lease(mDb.mStatementCache, sql, SqliteStatement(std::move(stmt)));
+    lease.release();
+
+    auto plan = std::make_shared<Plan>();
+    std::sort(collector.reads.begin(), collector.reads.end());
+    collector.reads.erase(std::unique(collector.reads.begin(), collector.reads.end()), collector.reads.end());
+
+    auto addSchema = [&plan](const std::string& schema) {
+      // TEMP is private to this connection, so the update hook sees all of its writes
+      if (schema != "temp" && std::find(plan->schemas.begin(), plan->schemas.end(), schema) == plan->schemas.end()) {
+        plan->schemas.push_back(schema);
+      }
+    };
+
+    std::lock_guard lock(mMutex);
+    for (const auto& [schema, table] : collector.reads) {
+      // Keyed by name alone: the same name in two schemas only over-invalidates
+      plan->tables.push_back(&tableCounter(table));
+      if (!mOptions.detectExternalWrites) {
+        continue;
+      }
+      if (!schema.empty()) {
+        addSchema(schema);
+        continue;
+      }
+      for (int index = 0; const char* name = sqlite3_db_name(mDb.mConnection.get(), index); ++index) {
+        addSchema(name);
+      }
+    }
+    std::sort(plan->tables.begin(), plan->tables.end());
+    plan->tables.erase(std::unique(plan->tables.begin(), plan->tables.end()), plan->tables.end());
+    mPlans.emplace(sql, plan);
+    return plan;
+  }
+
+  SqliteResultCache::Snapshot SqliteResultCache::takeSnapshot(const Plan& plan) {
+    Snapshot snapshot;
+    snapshot.epoch = mEpoch.load(std::memory_order_acquire);
+    snapshot.tables.reserve(plan.tables.size());
+    for (Counter* counter : plan.tables) {
+      snapshot.tables.push_back(counter->load(std::memory_order_acquire));
+    }
+    for (const auto& schema : plan.schemas) {
+      auto stmt = mDb.cachedPrepare("PRAGMA \"" + schema + "\".data_version");
+      stmt->step();
+      snapshot.dataVersions.push_back(stmt->getInt64(0));
+    }
+    return snapshot;
+  }
+
+  void SqliteResultCache::checkUnhookedChanges() {
+    std::int64_t total = sqlite3_total_changes64(mDb.mConnection.get());
+    std::int64_t unhooked = total - static_cast<std::int64_t>(mHookedChanges.load(std::memory_order_relaxed));
+    if (mUnhookedChanges.exchange(unhooked, std::memory_order_acq_rel) != unhooked) {
+      // Rows changed that no hook reported: the tables are unknown, drop everything
+      mEpoch.fetch_add(1, std::memory_order_acq_rel);
+    }
+  }
+
+  SqliteResultCache::Counter& SqliteResultCache::tableCounter(std::string key) {
+    return mTableVersions.try_emplace(std::move(key), 0).first->second;
+  }
+
+  void SqliteResultCache::store(Entry entry) {
+    std::lock_guard lock(mMutex);
+    if (auto found = mIndex.find(entry.key); found != mIndex.end()) {
+      eraseEntry(found->second);
+    }
+
+    while (!mEntries.empty() && mStats.bytes + entry.bytes > mOptions.maxBytes) {
+      eraseEntry(std::prev(mEntries.end()));
+      ++mStats.evictions;
+    }
+
+    mStats.bytes += entry.bytes;
+    ++mStats.stores;
+    mEntries.push_front(std::move(entry));
+    mIndex.emplace(mEntries.front().key, mEntries.begin());
+  }
+
+  void SqliteResultCache::eraseEntry(std::list<Entry>::iterator it) {
+    mStats.bytes -= it->bytes;
+    mIndex.erase(it->key);
+    mEntries.erase(it);
+  }
+
+  std::string SqliteResultCache::makeKey(const std::string& sql, const std::vector<SqliteValue>& parameters) {
+    std::string key = sql;
+    key.push_back('\0');
+    for (const auto& parameter : parameters) {
+      key.push_back(static_cast<char>(parameter.index()));
+      std::visit([&key](const auto& value) {
+        using Type = std::decay_t<decltype(value)>;
+        if constexpr (std::is_same_v<Type, std::int64_t> || std::is_same_v<Type, double>) {
+          appendRaw(key, value);
+        } else if constexpr (std::is_same_v<Type, std::string> || std::is_same_v<Type, std::vector<std::byte>>) {
+          appendBytes(key, value.data(), value.size());
+        }
+      }, parameter);
+    }
+    return key;
+  }
+
+} /* namespace sdb */
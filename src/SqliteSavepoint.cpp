@@ -0,0 +1,87 @@
+#include <SqliteSavepoint.hpp>
+#include <SqliteDb.hpp>
+#include <SqliteException.hpp>
+
+namespace sdb {
+
+  namespace {
+
+    std::string savepointName(std::size_t depth) {
+      return "sdb_sp_" + std::to_string(depth);
+    }
+
+  }
+
+  SqliteSavepoint::SqliteSavepoint(SqliteDb& sqliteDb)
+    : mSqliteDb(sqliteDb)
+    , mDepth(sqliteDb.mSavepointDepth + 1)
+    , mActive(false) {
+    if (!sqliteDb.isOpen()) {
+      throw SqliteTransactionException("No database");
+    }
+
+    try {
+      sqliteDb.executeCached("SAVEPOINT " + savepointName(mDepth));
+    } catch (SqliteException& e) {
+      throw SqliteTransactionException(e.what());
+    }
+    sqliteDb.mSavepointDepth = mDepth;
+    mActive = true;
+    if (sqliteDb.mChangeCapture) {
+      mChangeMark = sqliteDb.mChangeCapture->getMark(sqliteDb.mConnection.get());
+    }
+  }
+
+  SqliteSavepoint::~SqliteSavepoint() {
+    if (mActive) {
+      try {
+        finish(false);
+      } catch (...) {
+        // Log error silently
+      }
+    }
+  }
+
+  void SqliteSavepoint::release() {
+    finish(true);
+  }
+
+  void SqliteSavepoint::rollback() {
+    finish(false);
+  }
+
+  bool SqliteSavepoint::isActive() const noexcept {
+    return mActive;
+  }
+
+  std::size_t SqliteSavepoint::getDepth() const noexcept {
+    return mDepth;
+  }
+
+  void SqliteSavepoint::finish(bool commit) {
+    if (!mActive) {
+      return;
+    }
+
+    // The savepoint is over whatever happens: a failed RELEASE or ROLLBACK TO
+    // usually means an enclosing transaction already ended and took it along
+    mActive = false;
+    if (mSqliteDb.mSavepointDepth >= mDepth) {
+      mSqliteDb.mSavepointDepth = mDepth - 1;
+    }
+
+    const std::string name = savepointName(mDepth);
+    try {
+      if (!commit) {
+        mSqliteDb.executeCached("ROLLBACK TO " + name);
+        if (mSqliteDb.mChangeCapture) {
+          mSqliteDb.mChangeCapture->discardSince(mSqliteDb.mConnection.get(), mChangeMark);
+        }
+      }
+      mSqliteDb.executeCached("RELEASE " + name);
+    } catch (SqliteException& e) {
+      throw SqliteTransactionException(e.what());
+    }
+  }
+
+} /* namespace sdb */
@@ -0,0 +1,760 @@
+#include <SqliteShardSet.hpp>
+#include <SqliteException.hpp>
+#include <SqliteStatementCache.hpp>
+#include <SqliteValueBinder.hpp>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace sdb {
+
+  namespace detail {
+
+    struct SqliteShardTask {
+      std::shared_ptr<SqliteShardQuery> query;
+      std::size_t shard;
+    };
+
+    /**
+     * @brief Fixed pool of workers, each with its own task deque.
+     *
+     * A worker runs its newest task first (the shard it just requeued stays
+     * hot in its cache) and, when its deque is empty, steals the oldest task
+     * of another worker.  Tasks submitted from outside the pool are spread
+     * round-robin over the deques.
+     */
+    class SqliteShardPool {
+      public:
+        explicit SqliteShardPool(std::size_t threads);
+
+        SqliteShardPool(const SqliteShardPool&) = delete;
+        SqliteShardPool& operator=(const SqliteShardPool&) = delete;
+
+        /**
+         * @brief Stop the workers; queued tasks are dropped.
+         */
+        ~SqliteShardPool();
+
+        void submit(SqliteShardTask task);
+
+        std::size_t size() const noexcept {
+          return mWorkers.size();
+        }
+
+      private:
+        struct Worker {
+          std::mutex mutex;
+          std::deque<SqliteShardTask> tasks;
+        };
+
+        std::vector<std::unique_ptr<Worker>> mWorkers;
+        std::vector<std::thread> mThreads;
+        std::atomic<std::size_t> mQueued { 0 };
+        std::atomic<std::size_t> mNextWorker { 0 };
+        std::mutex mSleepMutex;
+        std::condition_variable mWake;
+        bool mStopping = false;
+
+        std::optional<SqliteShardTask> take(std::size_t self);
+        void workerLoop(std::size_t self);
+    };
+
+    struct SqliteShardChunk {
+      std::vector<SqliteValue> values;
+      std::size_t rows = 0;
+      int columns = 0;
+    };
+
+    /**
+     * @brief State shared by a cursor and the tasks stepping its shards.
+     *
+     * `statement` is only touched by the task currently running the shard;
+     * `chunks`, `finished`, `parked` and `error` are guarded by `mutex`; the
+     * rest belongs to the consumer.
+     */
+    struct SqliteShardQuery : std::enable_shared_from_this<SqliteShardQuery> {
+      struct Shard {
+        SqliteDb* db = nullptr;
+        std::optional<SqliteCachedStatement> statement;
+
+        std::deque<SqliteShardChunk> chunks;
+        bool finished = false;
+        bool parked = false;
+
+        SqliteShardChunk current;
+        std::size_t position = 0;
+      };
+
+      std::string sql;
+      std::vector<SqliteValue> parameters;
+      std::vector<SqliteShardSet::SortKey> orderBy;
+      std::size_t chunkRows = 0;
+      std::size_t maxBufferedChunks = 0;
+      SqliteShardPool* pool = nullptr;
+
+      std::vector<Shard> shards;
+      std::mutex mutex;
+      std::condition_variable ready;
+      std::exception_ptr error;
+      std::atomic<bool> cancelled { false };
+
+      bool started = false;
+      /** next() returned true and the cursor sits on a row. */
+      bool onRow = false;
+      bool exhausted = false;
+      int columnCount = -1;
+      std::size_t currentShard = 0;
+      std::vector<std::size_t> heap;
+
+      void run(std::size_t index);
+      void start(std::size_t index);
+
+      bool next();
+      bool nextUnordered();
+      bool nextOrdered();
+      bool takeChunk(std::size_t index);
+      void checkColumns(const SqliteShardChunk& chunk);
+      int compareRows(std::size_t left, std::size_t right) const;
+
+      const SqliteValue* rowAt(std::size_t index) const {
+        const Shard& shard = shards[index];
+        return shard.current.values.data() + shard.position * static_cast<std::size_t>(shard.current.columns);
+      }
+    };
+
+    namespace {
+
+      thread_local SqliteShardPool* currentPool = nullptr;
+      thread_local std::size_t currentWorker = 0;
+
+    } /* namespace */
+
+    SqliteShardPool::SqliteShardPool(std::size_t threads) {
+      for (std::size_t i = 0; i < threads; ++i) {
+        mWorkers.push_back(std::make_unique<Worker>());
+      }
+      for (std::size_t i = 0; i < threads; ++i) {
+        mThreads.emplace_back(&SqliteShardPool::workerLoop, this, i);
+      }
+    }
+
+    SqliteShardPool::~SqliteShardPool() {
+      {
+        std::lock_guard lock(mSleepMutex);
+        mStopping = true;
+      }
+      mWake.notify_all();
+      for (auto& thread : mThreads) {
+        thread.join();
+      }
+    }
+
+    void SqliteShardPool::submit(SqliteShardTask task) {
+      std::size_t target = currentPool == this
+        ? currentWorker
+        : mNextWorker.fetch_add(1, std::memory_order_relaxed) % mWorkers.size();
+      {
+        std::lock_guard lock(mWorkers[target]->mutex);
+        mWorkers[target]->tasks.push_back(std::move(task));
+      }
+      mQueued.fetch_add(1, std::memory_order_release);
+      {
+        // Pairs with the predicate check in workerLoop so the wake-up is not lost
+        std::lock_guard lock(mSleepMutex);
+      }
+      mWake.notify_one();
+    }
+
+    std::optional<SqliteShardTask> SqliteShardPool::take(std::size_t self) {
+      {
+        Worker& own = *mWorkers[self];
+        std::lock_guard lock(own.mutex);
+        if (!own.tasks.empty()) {
+          SqliteShardTask task = std::move(own.tasks.back());
+          own.tasks.pop_back();
+          return task;
+        }
+      }
+      for (std::size_t offset = 1; offset < mWorkers.size(); ++offset) {
+        Worker& victim = *mWorkers[(self + offset) % mWorkers.size()];
+        std::lock_guard lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+          SqliteShardTask task = std::move(victim.tasks.front());
+          victim.tasks.pop_front();
+          return task;
+        }
+      }
+      return std::nullopt;
+    }
+
+    void SqliteShardPool::workerLoop(std::size_t self) {
+      currentPool = this;
+      currentWorker = self;
+
+      for (;;) {
+        if (auto task = take(self)) {
+          mQueued.fetch_sub(1, std::memory_order_relaxed);
+          task->query->run(task->shard);
+          continue;
+        }
+
+        std::unique_lock lock(mSleepMutex);
+        mWake.wait(lock, [this] {
+          return mStopping || mQueued.load(std::memory_order_acquire) > 0;
+        });
+        if (mStopping) {
+          return;
+        }
+      }
+    }
+
+    void SqliteShardQuery::start(std::size_t index) {
+      Shard& shard = shards[index];
+      shard.statement.emplace(shard.db->cachedPrepare(sql));
+      SqliteStatement& statement = **shard.statement;
+
+      if (statement.getParameterCount() != static_cast<int>(parameters.size())) {
+        throw SqliteStatementException("Shard query expects " + std::to_string(statement.getParameterCount())
+                                       + " parameters, " + std::to_string(parameters.size()) + " given");
+      }
+      SqliteValueBinder binder(statement);
+      for (std::size_t i = 0; i < parameters.size(); ++i) {
+        binder.bind(static_cast<int>(i) + 1, parameters[i]);
+      }
+
+      int columns = statement.getColumnCount();
+      for (const auto& key : orderBy) {
+        if (key.column < 0 || key.column >= columns) {
+          throw SqliteStatementException("Shard merge column " + std::to_string(key.column) + " is out of range");
+        }
+      }
+    }
+
+    void SqliteShardQuery::run(std::size_t index) {
+      if (cancelled.load(std::memory_order_relaxed)) {
+        return;
+      }
+
+      Shard& shard = shards[index];
+      SqliteShardChunk chunk;
+      bool done = false;
+      try {
+        if (!shard.statement) {
+          start(index);
+        }
+        SqliteStatement& statement = **shard.statement;
+        chunk.columns = statement.getColumnCount();
+        chunk.values.reserve(chunkRows * static_cast<std::size_t>(chunk.columns));
+        while (chunk.rows < chunkRows) {
+          if (!statement.step()) {
+            done = true;
+            break;
+          }
+          for (int column = 0; column < chunk.columns; ++column) {
+            chunk.values.push_back(statement.getValue(column));
+          }
+          ++chunk.rows;
+        }
+      } catch (...) {
+        shard.statement.reset();
+        cancelled.store(true, std::memory_order_relaxed);
+        {
+          std::lock_guard lock(mutex);
+          if (!error) {
+            error = std::current_exception();
+          }
+          shard.finished = true;
+        }
+        ready.notify_all();
+        return;
+      }
+
+      if (done) {
+        // Ends the read transaction on this shard now rather than with the cursor
+        shard.statement.reset();
+      }
+
+      bool requeue = false;
+      {
+        std::lock_guard lock(mutex);
+        if (chunk.rows > 0) {
+          shard.chunks.push_back(std::move(chunk));
+        }
+        if (done) {
+          shard.finished = true;
+        } else if (shard.chunks.size() >= maxBufferedChunks) {
+          shard.parked = true;
+        } else {
+          requeue = true;
+        }
+      }
+      ready.notify_all();
+
+      if (requeue) {
+        pool->submit(SqliteShardTask { shared_from_this(), index });
+      }
+    }
+
+    bool SqliteShardQuery::takeChunk(std::size_t index) {
+      Shard& shard = shards[index];
+      bool resume = false;
+      {
+        std::unique_lock lock(mutex);
+        ready.wait(lock, [&] {
+          return error || !shard.chunks.empty() || shard.finished;
+        });
+        if (error) {
+          std::rethrow_exception(error);
+        }
+        if (shard.chunks.empty()) {
+          return false;
+        }
+        shard.current = std::move(shard.chunks.front());
+        shard.chunks.pop_front();
+        shard.position = 0;
+        resume = std::exchange(shard.parked, false);
+      }
+      if (resume) {
+        pool->submit(SqliteShardTask { shared_from_this(), index });
+      }
+      checkColumns(shard.current);
+      return true;
+    }
+
+    void SqliteShardQuery::checkColumns(const SqliteShardChunk& chunk) {
+      if (columnCount < 0) {
+        columnCount = chunk.columns;
+      } else if (columnCount != chunk.columns) {
+        throw SqliteStatementException("Shards returned " + std::to_string(columnCount) + " and "
+                                       + std::to_string(chunk.columns) + " columns");
+      }
+    }
+
+    bool SqliteShardQuery::next() {
+      // Past the end the last chunk may be gone, or there may be no shard at all
+      if (exhausted) {
+        return false;
+      }
+      onRow = false;
+      onRow = orderBy.empty() ? nextUnordered() : nextOrdered();
+      exhausted = !onRow;
+      return onRow;
+    }
+
+    bool SqliteShardQuery::nextUnordered() {
+      if (started) {
+        Shard& shard = shards[currentShard];
+        if (++shard.position < shard.current.rows) {
+          return true;
+        }
+      }
+      started = true;
+
+      std::size_t index = 0;
+      bool resume = false;
+      {
+        std::unique_lock lock(mutex);
+        for (;;) {
+          if (error) {
+            std::rethrow_exception(error);
+          }
+          bool pending = false;
+          bool found = false;
+          for (std::size_t offset = 1; offset <= shards.size(); ++offset) {
+            index = (currentShard + offset) % shards.size();
+            if (!shards[index].chunks.empty()) {
+              found = true;
+              break;
+            }
+            pending = pending || !shards[index].finished;
+          }
+          if (found) {
+            break;
+          }
+          if (!pending) {
+            return false;
+          }
+          ready.wait(lock);
+        }
+
+        Shard& shard = shards[index];
+        shard.current = std::move(shard.chunks.front());
+        shard.chunks.pop_front();
+        shard.position = 0;
+        resume = std::exchange(shard.parked, false);
+      }
+      if (resume) {
+        pool->submit(SqliteShardTask { shared_from_this(), index });
+      }
+      currentShard = index;
+      checkColumns(shards[index].current);
+      return true;
+    }
+
+    int SqliteShardQuery::compareRows(std::size_t left, std::size_t right) const {
+      const SqliteValue* a = rowAt(left);
+      const SqliteValue* b = rowAt(right);
+      for (const auto& key : orderBy) {
+        int order = compareSqliteValues(a[key.column], b[key.column]);
+        if (order != 0) {
+          return key.descending ? -order : order;
+        }
+      }
+      return left < right ? -1 : (left > right ? 1 : 0);
+    }
+
+    bool SqliteShardQuery::nextOrdered() {
+      // std heaps keep the largest element in front: "after" puts the next row there
+      auto after = [this](std::size_t left, std::size_t right) {
+        return compareRows(left, right) > 0;
+      };
+
+      if (!started) {
+        started = true;
+        for (std::size_t index = 0; index < shards.size(); ++index) {
+          if (takeChunk(index)) {
+            heap.push_back(index);
+          }
+        }
+        std::make_heap(heap.begin(), heap.end(), after);
+      } else if (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), after);
+        std::size_t index = heap.back();
+        Shard& shard = shards[index];
+        if (++shard.position < shard.current.rows || takeChunk(index)) {
+          std::push_heap(heap.begin(), heap.end(), after);
+        } else {
+          heap.pop_back();
+        }
+      }
+
+      if (heap.empty()) {
+        return false;
+      }
+      currentShard = heap.front();
+      return true;
+    }
+
+  } /* namespace detail */
+
+  namespace {
+
+    int compareNumbers(const SqliteValue& left, const SqliteValue& right) noexcept {
+      if (std::holds_alternative<std::int64_t>(left) && std::holds_alternative<std::int64_t>(right)) {
+        std::int64_t a = std::get<std::int64_t>(left);
+        std::int64_t b = std::get<std::int64_t>(right);
+        return a < b ? -1 : (a > b ? 1 : 0);
+      }
+      if (std::holds_alternative<double>(left) && std::holds_alternative<double>(right)) {
+        double a = std::get<double>(left);
+        double b = std::get<double>(right);
+        return a < b ? -1 : (a > b ? 1 : 0);
+      }
+
+      // Integer against real: exact for integers beyond 2^53, like SQLite
+      bool swapped = std::holds_alternative<double>(left);
+      std::int64_t i = std::get<std::int64_t>(swapped ? right : left);
+      double r = std::get<double>(swapped ? left : right);
+      int order;
+      if (r < -9223372036854775808.0) {
+        order = 1;
+      } else if (r >= 9223372036854775808.0) {
+        order = -1;
+      } else {
+        std::int64_t truncated = static_cast<std::int64_t>(r);
+        if (i != truncated) {
+          order = i < truncated ? -1 : 1;
+        } else {
+          double fraction = r - static_cast<double>(truncated);
+          order = fraction > 0 ? -1 : (fraction < 0 ? 1 : 0);
+        }
+      }
+      return swapped ? -order : order;
+    }
+
+    template<typename Bytes>
+    int compareBytes(const Bytes& left, const Bytes& right) noexcept {
+      std::size_t size = std::min(left.size(), right.size());
+      int order = size == 0 ? 0 : std::memcmp(left.data(), right.data(), size);
+      if (order != 0) {
+        return order < 0 ? -1 : 1;
+      }
+      return left.size() < right.size() ? -1 : (left.size() > right.size() ? 1 : 0);
+    }
+
+    /** Storage class rank in SQLite's ORDER BY: NULL, numbers, text, blob. */
+    int storageRank(const SqliteValue& value) noexcept {
+      switch (value.index()) {
+        case 0:
+          return 0;
+        case 1:
+        case 2:
+          return 1;
+        case 3:
+          return 2;
+        default:
+          return 3;
+      }
+    }
+
+    struct SqliteValuesLess {
+      bool operator()(const std::vector<SqliteValue>& left, const std::vector<SqliteValue>& right) const noexcept {
+        for (std::size_t i = 0; i < left.size(); ++i) {
+          int order = compareSqliteValues(left[i], right[i]);
+          if (order != 0) {
+            return order < 0;
+          }
+        }
+        return false;
+      }
+    };
+
+    void combineSum(SqliteValue& total, const SqliteValue& partial) {
+      if (std::holds_alternative<std::monostate>(partial)) {
+        return;
+      }
+      if (storageRank(partial) != 1) {
+        throw SqliteStatementException("Shard partial sum is not a number");
+      }
+      if (std::holds_alternative<std::monostate>(total)) {
+        total = partial;
+        return;
+      }
+      if (std::holds_alternative<std::int64_t>(total) && std::holds_alternative<std::int64_t>(partial)) {
+        std::int64_t& sum = std::get<std::int64_t>(total);
+        std::int64_t value = std::get<std::int64_t>(partial);
+        if ((value > 0 && sum > std::numeric_limits<std::int64_t>::max() - value)
+            || (value < 0 && sum < std::numeric_limits<std::int64_t>::min() - value)) {
+          throw SqliteStatementException("integer overflow", SQLITE_ERROR);
+        }
+        sum += value;
+        return;
+      }
+      auto asDouble = [](const SqliteValue& value) {
+        return std::holds_alternative<double>(value)
+          ? std::get<double>(value)
+          : static_cast<double>(std::get<std::int64_t>(value));
+      };
+      total = asDouble(total) + asDouble(partial);
+    }
+
+  } /* namespace */
+
+  int compareSqliteValues(const SqliteValue& left, const SqliteValue& right) noexcept {
+    int leftRank = storageRank(left);
+    int rightRank = storageRank(right);
+    if (leftRank != rightRank) {
+      return leftRank < rightRank ? -1 : 1;
+    }
+    switch (leftRank) {
+      case 1:
+        return compareNumbers(left, right);
+      case 2:
+        return compareBytes(std::get<std::string>(left), std::get<std::string>(right));
+      case 3:
+        return compareBytes(std::get<std::vector<std::byte>>(left), std::get<std::vector<std::byte>>(right));
+      default:
+        return 0;
+    }
+  }
+
+  SqliteShardCursor::SqliteShardCursor(std::shared_ptr<detail::SqliteShardQuery> query)
+    : mQuery(std::move(query)) {
+  }
+
+  SqliteShardCursor::SqliteShardCursor(SqliteShardCursor&&) noexcept = default;
+
+  SqliteShardCursor& SqliteShardCursor::operator=(SqliteShardCursor&& other) noexcept {
+    if (this != &other) {
+      if (mQuery) {
+        mQuery->cancelled.store(true, std::memory_order_relaxed);
+      }
+      mQuery = std::move(other.mQuery);
+    }
+    return *this;
+  }
+
+  SqliteShardCursor::~SqliteShardCursor() {
+    if (mQuery) {
+      mQuery->cancelled.store(true, std::memory_order_relaxed);
+    }
+  }
+
+  bool SqliteShardCursor::next() {
+    if (!mQuery) {
+      throw SqliteDbException("Shard cursor was moved from");
+    }
+    return mQuery->next();
+  }
+
+  SqliteShardCursor::Row SqliteShardCursor::getRow() const {
+    checkRow();
+    return Row(mQuery->rowAt(mQuery->currentShard), static_cast<std::size_t>(mQuery->columnCount));
+  }
+
+  const SqliteValue& SqliteShardCursor::getValue(int column) const {
+    checkRow();
+    if (column < 0 || column >= mQuery->columnCount) {
+      throw SqliteStatementException("Column index " + std::to_string(column) + " out of range");
+    }
+    return mQuery->rowAt(mQuery->currentShard)[column];
+  }
+
+  void SqliteShardCursor::checkRow() const {
+    if (!mQuery || !mQuery->onRow) {
+      throw SqliteDbException("Shard cursor has no current row; call next() first");
+    }
+  }
+
+  int SqliteShardCursor::getColumnCount() const noexcept {
+    return mQuery->columnCount;
+  }
+
+  std::size_t SqliteShardCursor::getShard() const noexcept {
+    return mQuery->currentShard;
+  }
+
+  SqliteShardSet::SqliteShardSet(const std::vector<std::filesystem::path>& shards)
+    : SqliteShardSet(shards, Options { }) {
+  }
+
+  SqliteShardSet::SqliteShardSet(const std::vector<std::filesystem::path>& shards, Options options)
+    : mOptions(std::move(options)) {
+    if (mOptions.chunkRows == 0 || mOptions.maxBufferedChunks == 0) {
+      throw SqliteDbException("Shard chunkRows and maxBufferedChunks must be positive");
+    }
+
+    mShards.reserve(shards.size());
+    for (std::size_t i = 0; i < shards.size(); ++i) {
+      auto db = SqliteDb::open(shards[i], mOptions.open);
+      if (mOptions.onConnect) {
+        mOptions.onConnect(*db, i);
+      }
+      mShards.push_back(std::move(db));
+    }
+
+    std::size_t threads = mOptions.threads;
+    if (threads == 0) {
+      threads = std::min<std::size_t>(std::max(1u, std::thread::hardware_concurrency()), shards.size());
+    }
+    mPool = std::make_unique<detail::SqliteShardPool>(std::max<std::size_t>(threads, 1));
+  }
+
+  SqliteShardSet::~SqliteShardSet() = default;
+
+  SqliteShardCursor SqliteShardSet::query(const std::string& sql) {
+    return query(sql, QueryOptions { });
+  }
+
+  SqliteShardCursor SqliteShardSet::query(const std::string& sql, const QueryOptions& options) {
+    auto query = std::make_shared<detail::SqliteShardQuery>();
+    query->sql = sql;
+    query->parameters = options.parameters;
+    query->orderBy = options.orderBy;
+    query->chunkRows = mOptions.chunkRows;
+    query->maxBufferedChunks = mOptions.maxBufferedChunks;
+    query->pool = mPool.get();
+    query->shards.resize(mShards.size());
+    for (std::size_t i = 0; i < mShards.size(); ++i) {
+      query->shards[i].db = mShards[i].get();
+    }
+    for (std::size_t i = 0; i < mShards.size(); ++i) {
+      mPool->submit(detail::SqliteShardTask { query, i });
+    }
+    return SqliteShardCursor(std::move(query));
+  }
+
+  std::vector<std::vector<SqliteValue>> SqliteShardSet::aggregate(const std::string& sql, const std::vector<Combine>& combine) {
+    return aggregate(sql, combine, QueryOptions { });
+  }
+
+  std::vector<std::vector<SqliteValue>> SqliteShardSet::aggregate(const std::string& sql, const std::vector<Combine>& combine,
+                                                                  const QueryOptions& options) {
+    QueryOptions unordered;
+    unordered.parameters = options.parameters;
+    SqliteShardCursor cursor = query(sql, unordered);
+
+    std::map<std::vector<SqliteValue>, std::vector<SqliteValue>, SqliteValuesLess> groups;
+    std::vector<SqliteValue> key;
+    while (cursor.next()) {
+      auto row = cursor.getRow();
+      if (row.size() != combine.size()) {
+        throw SqliteStatementException("Shard aggregate returns " + std::to_string(row.size()) + " columns, "
+                                       + std::to_string(combine.size()) + " combine rules given");
+      }
+
+      key.clear();
+      for (std::size_t i = 0; i < row.size(); ++i) {
+        if (combine[i] == Combine::GROUP) {
+          key.push_back(row[i]);
+        }
+      }
+      auto [group, inserted] = groups.try_emplace(key);
+      std::vector<SqliteValue>& totals = group->second;
+      if (inserted) {
+        totals.resize(row.size());
+      }
+
+      for (std::size_t i = 0; i < row.size(); ++i) {
+        switch (combine[i]) {
+          case Combine::GROUP:
+            if (inserted) {
+              totals[i] = row[i];
+            }
+            break;
+          case Combine::SUM:
+          case Combine::COUNT:
+            combineSum(totals[i], row[i]);
+            break;
+          case Combine::MIN:
+            if (!std::holds_alternative<std::monostate>(row[i])
+                && (std::holds_alternative<std::monostate>(totals[i]) || compareSqliteValues(row[i], totals[i]) < 0)) {
+              totals[i] = row[i];
+            }
+            break;
+          case Combine::MAX:
+            if (compareSqliteValues(row[i], totals[i]) > 0) {
+              totals[i] = row[i];
+            }
+            break;
+        }
+      }
+    }
+
+    std::vector<std::vector<SqliteValue>> result;
+    result.reserve(groups.size());
+    for (auto& [groupKey, totals] : groups) {
+      for (std::size_t i = 0; i < totals.size(); ++i) {
+        if (combine[i] == Combine::COUNT && std::holds_alternative<std::monostate>(totals[i])) {
+          totals[i] = std::int64_t { 0 };
+        }
+      }
+      result.push_back(std::move(totals));
+    }
+    return result;
+  }
+
+  std::size_t SqliteShardSet::getShardCount() const noexcept {
+    return mShards.size();
+  }
+
+  SqliteDb& SqliteShardSet::getShard(std::size_t index) {
+    if (index >= mShards.size()) {
+      throw SqliteDbException("Shard index " + std::to_string(index) + " out of range");
+    }
+    return *mShards[index];
+  }
+
+  std::size_t SqliteShardSet::getThreadCount() const noexcept {
+    return mPool->size();
+  }
+
+} /* namespace sdb */
@@ -1,11 +1,29 @@
 #include "../sqlite/sqlite3.h"
 #include <SqliteStatement.hpp>
+#include <SqliteChangeCapture.hpp>
 #include <SqliteException.hpp>
+#include <cctype>
+#include <cstdint>
 #include <type_traits>
 #include <variant>
 
 namespace sdb {
 
+  namespace {
+
+    sqlite3_destructor_type toDestructor(BindLifetime lifetime) {
+      return lifetime == BindLifetime::STATIC ? SQLITE_STATIC : SQLITE_TRANSIENT;
+    }
+
+    SqliteResult<void> bindResult(int result, int index) noexcept {
+      if (result != SQLITE_OK) {
+        return SqliteError(result, "bind", index);
+      }
+      return { };
+    }
+
+  }
+
   SqliteStatement::SqliteStatement(SqliteStatementPtr stmt)
       : mStatement(std::move(stmt)) {
   }
@@ -35,11 +53,7 @@ namespace sdb {
   }
 
   void SqliteStatement::bind(int index, const std::string& value) {
-    checkParameterIndex(index);
-    int result = sqlite3_bind_text(mStatement.get(), index, value.c_str(), -1, SQLITE_TRANSIENT);
-    if (result != SQLITE_OK) {
-      throw SqliteStatementException("Failed to bind text at index " + std::to_string(index));
-    }
+    bind(index, std::string_view(value));
   }
 
   void SqliteStatement::bind(int index, const char* value) {
@@ -51,14 +65,35 @@ namespace sdb {
   }
 
   void SqliteStatement::bind(int index, const std::vector<std::byte>& blob) {
+    bind(index, std::span<const std::byte>(blob));
+  }
+
+  void SqliteStatement::bind(int index, std::string_view value, BindLifetime lifetime) {
     checkParameterIndex(index);
-    int result = sqlite3_bind_blob(mStatement.get(), index, blob.data(),
-                                   static_cast<int>(blob.size()), SQLITE_TRANSIENT);
+    // A null data pointer would bind NULL instead of an empty string
+    const char* text = value.data() ? value.data() : "";
+    int result = sqlite3_bind_text64(mStatement.get(), index, text, value.size(), toDestructor(lifetime), SQLITE_UTF8);
     if (result != SQLITE_OK) {
       throw SqliteStatementException("Failed to bind text at index " + std::to_string(index));
     }
   }
 
+  void SqliteStatement::bind(int index, std::span<const std::byte> blob, BindLifetime lifetime) {
+    checkParameterIndex(index);
+    int result = sqlite3_bind_blob64(mStatement.get(), index, blob.data(), blob.size(), toDestructor(lifetime));
+    if (result != SQLITE_OK) {
+      throw SqliteStatementException("Failed to bind blob at index " + std::to_string(index));
+    }
+  }
+
+  void SqliteStatement::bindZeroBlob(int index, std::uint64_t size) {
+    checkParameterIndex(index);
+    int result = sqlite3_bind_zeroblob64(mStatement.get(), index, size);
+    if (result != SQLITE_OK) {
+      throw SqliteStatementException("Failed to bind zero blob at index " + std::to_string(index), result);
+    }
+  }
+
   void SqliteStatement::bindNull(int index) {
     checkParameterIndex(index);
     int result = sqlite3_bind_null(mStatement.get(), index);
@@ -67,6 +102,50 @@ namespace sdb {
     }
   }
 
+  SqliteResult<void> SqliteStatement::tryBind(int index, int value) noexcept {
+    int result = sqlite3_bind_int(mStatement.get(), index, value);
+    return bindResult(result, index);
+  }
+
+  SqliteResult<void> SqliteStatement::tryBind(int index, std::int64_t value) noexcept {
+    int result = sqlite3_bind_int64(mStatement.get(), index, value);
+    return bindResult(result, index);
+  }
+
+  SqliteResult<void> SqliteStatement::tryBind(int index, double value) noexcept {
+    int result = sqlite3_bind_double(mStatement.get(), index, value);
+    return bindResult(result, index);
+  }
+
+  SqliteResult<void> SqliteStatement::tryBind(int index, const std::string& value) noexcept {
+    return tryBind(index, std::string_view(value));
+  }
+
+  SqliteResult<void> SqliteStatement::tryBind(int index, const char* value) noexcept {
+    int result = sqlite3_bind_text(mStatement.get(), index, value, -1, SQLITE_TRANSIENT);
+    return bindResult(result, index);
+  }
+
+  SqliteResult<void> SqliteStatement::tryBind(int index, const std::vector<std::byte>& blob) noexcept {
+    return tryBind(index, std::span<const std::byte>(blob));
+  }
+
+  SqliteResult<void> SqliteStatement::tryBind(int index, std::string_view value, BindLifetime lifetime) noexcept {
+    const char* text = value.data() ? value.data() : "";
+    int result = sqlite3_bind_text64(mStatement.get(), index, text, value.size(), toDestructor(lifetime), SQLITE_UTF8);
+    return bindResult(result, index);
+  }
+
+  SqliteResult<void> SqliteStatement::tryBind(int index, std::span<const std::byte> blob, BindLifetime lifetime) noexcept {
+    int result = sqlite3_bind_blob64(mStatement.get(), index, blob.data(), blob.size(), toDestructor(lifetime));
+    return bindResult(result, index);
+  }
+
+  SqliteResult<void> SqliteStatement::tryBindNull(int index) noexcept {
+    int result = sqlite3_bind_null(mStatement.get(), index);
+    return bindResult(result, index);
+  }
+
   int SqliteStatement::getInt(int column) const {
     checkColumnIndex(column);
     return sqlite3_column_int(mStatement.get(), column);
@@ -98,6 +177,50 @@ namespace sdb {
     return std::vector<std::byte>(data, data + size);
   }
 
+  std::string_view SqliteStatement::getStringView(int column) const {
+    checkColumnIndex(column);
+    checkCurrentRow();
+    const unsigned char* text = sqlite3_column_text(mStatement.get(), column);
+    if (text) {
+      int size = sqlite3_column_bytes(mStatement.get(), column);
+      return std::string_view(reinterpret_cast<const char*>(text), static_cast<std::size_t>(size));
+    }
+    return { };
+  }
+
+  std::span<const std::byte> SqliteStatement::getBlobSpan(int column) const {
+    checkColumnIndex(column);
+    checkCurrentRow();
+    const std::byte* data = reinterpret_cast<const std::byte*>(sqlite3_column_blob(mStatement.get(), column));
+    if (data) {
+      int size = sqlite3_column_bytes(mStatement.get(), column);
+      return std::span<const std::byte>(data, static_cast<std::size_t>(size));
+    }
+    return { };
+  }
+
+  SqliteValue SqliteStatement::getValue(int column) const {
+    checkColumnIndex(column);
+    checkCurrentRow();
+    sqlite3_stmt* statement = mStatement.get();
+    switch (sqlite3_column_type(statement, column)) {
+      case SQLITE_INTEGER:
+        return sqlite3_column_int64(statement, column);
+      case SQLITE_FLOAT:
+        return sqlite3_column_double(statement, column);
+      case SQLITE_TEXT: {
+        const char* text = reinterpret_cast<const char*>(sqlite3_column_text(statement, column));
+        return std::string(text, static_cast<std::size_t>(sqlite3_column_bytes(statement, column)));
+      }
+      case SQLITE_BLOB: {
+        const std::byte* data = reinterpret_cast<const std::byte*>(sqlite3_column_blob(statement, column));
+        return std::vector<std::byte>(data, data + sqlite3_column_bytes(statement, column));
+      }
+      default:
+        return std::monostate { };
+    }
+  }
+
   bool SqliteStatement::isNull(int column) const {
     checkColumnIndex(column);
     return sqlite3_column_type(mStatement.get(), column) == SQLITE_NULL;
@@ -123,6 +246,14 @@ namespace sdb {
     return getBlob(getColumnIndex(columnName));
   }
 
+  std::string_view SqliteStatement::getStringView(const std::string& columnName) const {
+    return getStringView(getColumnIndex(columnName));
+  }
+
+  std::span<const std::byte> SqliteStatement::getBlobSpan(const std::string& columnName) const {
+    return getBlobSpan(getColumnIndex(columnName));
+  }
+
   bool SqliteStatement::isNull(const std::string& columnName) const {
     return isNull(getColumnIndex(columnName));
   }
@@ -135,10 +266,184 @@ namespace sdb {
     }
   }
 
+  void SqliteStatement::checkCurrentRow() const {
+#ifndef NDEBUG
+    // Views point into the current row, so asking for one without a row
+    // would hand out a dangling buffer.  A view kept past the next step()
+    // is a plain std::string_view or std::span and cannot be checked.
+    if (!mHasRow) {
+      throw SqliteStatementException("Column view requested without a current row");
+    }
+#endif
+  }
+
   std::string SqliteStatement::getSql() const {
       return sqlite3_sql(mStatement.get());
   }
 
+  SqlitePlan SqliteStatement::explainPlan() {
+    sqlite3_stmt* stmt = mStatement.get();
+    reset();
+
+    if (sqlite3_stmt_explain(stmt, 2) != SQLITE_OK) {
+      throw SqliteStatementException("Failed to explain statement: " + std::string(sqlite3_errmsg(sqlite3_db_handle(stmt))));
+    }
+
+    // Columns of EXPLAIN QUERY PLAN: id, parent, notused, detail
+    std::vector<SqlitePlanNode> rows;
+    int result;
+    while ((result = sqlite3_step(stmt)) == SQLITE_ROW) {
+      const auto* detail = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
+      rows.push_back(SqlitePlanNode { sqlite3_column_int(stmt, 0), sqlite3_column_int(stmt, 1),
+                                      detail ? detail : "", { } });
+    }
+
+    sqlite3_reset(stmt);
+    sqlite3_stmt_explain(stmt, 0);
+
+    if (result != SQLITE_DONE) {
+      throw SqliteStatementException("Explain failed with error code: " + std::to_string(result));
+    }
+    return SqlitePlan::fromRows(std::move(rows));
+  }
+
+  SqliteColumnarBatch SqliteStatement::fetchColumnar(std::size_t batchRows) {
+    return fetchColumnar(batchRows, { });
+  }
+
+  SqliteColumnarBatch SqliteStatement::fetchColumnar(std::size_t batchRows, const std::vector<SqliteColumnType>& types) {
+    sqlite3_stmt* stmt = mStatement.get();
+    const int columnCount = sqlite3_column_count(stmt);
+    if (!types.empty() && types.size() != static_cast<std::size_t>(columnCount)) {
+      throw SqliteStatementException("Expected " + std::to_string(columnCount) + " column types, got "
+          + std::to_string(types.size()));
+    }
+
+    // Text and blob columns always start with offset 0, so an empty batch still has rows + 1 offsets
+    auto setType = [batchRows](SqliteColumnBuffer& column, SqliteColumnType type) {
+      column.type = type;
+      switch (type) {
+        case SqliteColumnType::INT64:
+          column.int64s.reserve(batchRows);
+          break;
+        case SqliteColumnType::DOUBLE:
+          column.doubles.reserve(batchRows);
+          break;
+        default:
+          column.offsets.reserve(batchRows + 1);
+          column.offsets.push_back(0);
+          break;
+      }
+    };
+
+    // Names and explicit types are set up front so that an empty batch has the same schema
+    SqliteColumnarBatch batch;
+    batch.columns.resize(static_cast<std::size_t>(columnCount));
+    for (int c = 0; c < columnCount; ++c) {
+      auto& column = batch.columns[static_cast<std::size_t>(c)];
+      const char* name = sqlite3_column_name(stmt, c);
+      column.name = name ? name : "";
+      if (!types.empty()) {
+        setType(column, types[static_cast<std::size_t>(c)]);
+      }
+    }
+
+    // Stepping a finished statement would silently run it again
+    if (mDone) {
+      return batch;
+    }
+
+    for (auto& column : batch.columns) {
+      column.validity.reserve((batchRows + 7) / 8);
+    }
+
+    for (std::size_t row = 0; row < batchRows && step(); ++row) {
+      for (int c = 0; c < columnCount; ++c) {
+        auto& column = batch.columns[static_cast<std::size_t>(c)];
+
+        if (row == 0 && types.empty()) {
+          setType(column, inferColumnType(c));
+        }
+
+        if (row % 8 == 0) {
+          column.validity.push_back(0);
+        }
+        const bool isNull = sqlite3_column_type(stmt, c) == SQLITE_NULL;
+        if (isNull) {
+          ++column.nullCount;
+        } else {
+          column.validity.back() |= static_cast<std::uint8_t>(1u << (row % 8));
+        }
+
+        switch (column.type) {
+          case SqliteColumnType::INT64:
+            column.int64s.push_back(isNull ? 0 : sqlite3_column_int64(stmt, c));
+            break;
+          case SqliteColumnType::DOUBLE:
+            column.doubles.push_back(isNull ? 0.0 : sqlite3_column_double(stmt, c));
+            break;
+          default: {
+            if (!isNull) {
+              // Fetch the pointer before the size, as SQLite's conversion rules require
+              const void* bytes = column.type == SqliteColumnType::TEXT
+                  ? static_cast<const void*>(sqlite3_column_text(stmt, c))
+                  : sqlite3_column_blob(stmt, c);
+              auto size = static_cast<std::size_t>(sqlite3_column_bytes(stmt, c));
+              if (column.data.size() + size > static_cast<std::size_t>(INT32_MAX)) {
+                throw SqliteStatementException("Column '" + column.name + "' exceeds 2 GiB in one columnar batch");
+              }
+              const auto* first = static_cast<const std::byte*>(bytes);
+              column.data.insert(column.data.end(), first, first + size);
+            }
+            column.offsets.push_back(static_cast<std::int32_t>(column.data.size()));
+            break;
+          }
+        }
+      }
+      ++batch.rows;
+    }
+
+    return batch;
+  }
+
+  SqliteColumnType SqliteStatement::inferColumnType(int column) const {
+    sqlite3_stmt* stmt = mStatement.get();
+
+    // Declared type affinity rules, see "Determination Of Column Affinity"
+    if (const char* declared = sqlite3_column_decltype(stmt, column)) {
+      std::string type;
+      for (const char* c = declared; *c; ++c) {
+        type += static_cast<char>(std::toupper(static_cast<unsigned char>(*c)));
+      }
+      if (type.find("INT") != std::string::npos) {
+        return SqliteColumnType::INT64;
+      }
+      if (type.find("CHAR") != std::string::npos || type.find("CLOB") != std::string::npos
+          || type.find("TEXT") != std::string::npos) {
+        return SqliteColumnType::TEXT;
+      }
+      if (type.find("BLOB") != std::string::npos) {
+        return SqliteColumnType::BLOB;
+      }
+      if (type.find("REAL") != std::string::npos || type.find("FLOA") != std::string::npos
+          || type.find("DOUB") != std::string::npos) {
+        return SqliteColumnType::DOUBLE;
+      }
+    }
+
+    // Expressions, untyped columns and NUMERIC affinity: follow the first value
+    switch (sqlite3_column_type(stmt, column)) {
+      case SQLITE_INTEGER:
+        return SqliteColumnType::INT64;
+      case SQLITE_FLOAT:
+        return SqliteColumnType::DOUBLE;
+      case SQLITE_BLOB:
+        return SqliteColumnType::BLOB;
+      default:
+        return SqliteColumnType::TEXT;
+    }
+  }
+
   int SqliteStatement::getParameterCount() const {
     return sqlite3_bind_parameter_count(mStatement.get());
   }
@@ -171,17 +476,36 @@ namespace sdb {
 
   bool SqliteStatement::step() {
     int result = sqlite3_step(mStatement.get());
+    mHasRow = result == SQLITE_ROW;
+    mDone = result == SQLITE_DONE;
 
     if (result == SQLITE_ROW) {
       return true;
     } else if (result == SQLITE_DONE) {
       return false;
     } else {
+      SqliteChangeCapture::discardFailedStatement(mStatement.get());
       throw SqliteStatementException("Step failed with error code: " + std::to_string(result));
     }
   }
 
+  SqliteResult<bool> SqliteStatement::tryStep() noexcept {
+    int result = sqlite3_step(mStatement.get());
+    mHasRow = result == SQLITE_ROW;
+    mDone = result == SQLITE_DONE;
+
+    if (result == SQLITE_ROW || result == SQLITE_DONE) {
+      return mHasRow;
+    }
+    // step() returns the primary code unless extended codes are enabled
+    int extended = sqlite3_extended_errcode(sqlite3_db_handle(mStatement.get()));
+    SqliteChangeCapture::discardFailedStatement(mStatement.get());
+    return SqliteError((extended & 0xff) == result ? extended : result, "step");
+  }
+
   void SqliteStatement::reset() {
+    mHasRow = false;
+    mDone = false;
     sqlite3_reset(mStatement.get());
   }
 
@@ -201,15 +525,25 @@ namespace sdb {
     }
   }
 
-  int SqliteStatement::getColumnIndex(const std::string& name) const {
-    int count = getColumnCount();
-    for (int i = 0; i < count; ++i) {
-      if (getColumnName(i) == name) {
-        return i;
+  int SqliteStatement::getColumnIndex(std::string_view name) const {
+    int prepare = sqlite3_stmt_status(mStatement.get(), SQLITE_STMTSTATUS_REPREPARE, 0);
+    if (prepare != mColumnIndicesPrepare) {
+      mColumnIndices.clear();
+      mColumnIndicesPrepare = prepare;
+      int count = getColumnCount();
+      mColumnIndices.reserve(static_cast<std::size_t>(count));
+      for (int i = 0; i < count; ++i) {
+        const char* columnName = sqlite3_column_name(mStatement.get(), i);
+        mColumnIndices.emplace(columnName ? columnName : "", i);
       }
     }
 
-    throw SqliteStatementException("Column not found: " + name);
+    auto it = mColumnIndices.find(name);
+    if (it == mColumnIndices.end()) {
+      throw SqliteStatementException("Column not found: " + std::string(name));
+    }
+
+    return it->second;
   }
 
 } /* namespace sql */
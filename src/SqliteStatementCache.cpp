@@ -0,0 +1,126 @@
+#include <SqliteStatementCache.hpp>
+
+namespace sdb {
+
+  SqliteStatementCache::SqliteStatementCache(std::size_t capacity)
+    : mCapacity(capacity) {
+  }
+
+  std::optional<SqliteStatement> SqliteStatementCache::take(const std::string& sql) {
+    auto guard = lock();
+
+    auto it = mIndex.find(sql);
+    if (it == mIndex.end()) {
+      ++mMisses;
+      return std::nullopt;
+    }
+
+    ++mHits;
+    auto entry = it->second;
+    mIndex.erase(it);
+    std::optional<SqliteStatement> stmt(std::move(entry->second));
+    mEntries.erase(entry);
+    return stmt;
+  }
+
+  void SqliteStatementCache::put(const std::string& sql, SqliteStatement stmt) {
+    stmt.reset();
+    stmt.clearBindings();
+
+    auto guard = lock();
+
+    if (mCapacity == 0) {
+      return;
+    }
+
+    mEntries.emplace_front(sql, std::move(stmt));
+    mIndex.emplace(sql, mEntries.begin());
+    evict(mCapacity);
+  }
+
+  void SqliteStatementCache::setCapacity(std::size_t capacity) {
+    auto guard = lock();
+    mCapacity = capacity;
+    evict(mCapacity);
+  }
+
+  void SqliteStatementCache::clear() {
+    auto guard = lock();
+    evict(0);
+  }
+
+  SqliteStatementCache::Stats SqliteStatementCache::getStats() const {
+    auto guard = lock();
+    return Stats { mHits, mMisses, mEvictions, mEntries.size(), mCapacity };
+  }
+
+  void SqliteStatementCache::setThreadConfined(bool confined) noexcept {
+    mThreadConfined = confined;
+  }
+
+  std::unique_lock<std::mutex> SqliteStatementCache::lock() const {
+    if (mThreadConfined) {
+      return std::unique_lock<std::mutex>(mMutex, std::defer_lock);
+    }
+    return std::unique_lock<std::mutex>(mMutex);
+  }
+
+  void SqliteStatementCache::evict(std::size_t capacity) {
+    while (mEntries.size() > capacity) {
+      auto last = std::prev(mEntries.end());
+      auto range = mIndex.equal_range(last->first);
+      for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == last) {
+          mIndex.erase(it);
+          break;
+        }
+      }
+      mEntries.erase(last);
+      ++mEvictions;
+    }
+  }
+
+  SqliteCachedStatement::SqliteCachedStatement(SqliteStatementCache& cache, std::string sql, SqliteStatement stmt)
+    : mCache(&cache)
+    , mSql(std::move(sql))
+    , mStatement(std::move(stmt)) {
+  }
+
+  SqliteCachedStatement::~SqliteCachedStatement() {
+    try {
+      release();
+    } catch (...) {
+      // Never throw from the destructor
+    }
+  }
+
+  SqliteCachedStatement::SqliteCachedStatement(SqliteCachedStatement&& other) noexcept
+    : mCache(other.mCache)
+    , mSql(std::move(other.mSql))
+    , mStatement(std::move(other.mStatement)) {
+    other.mStatement.reset();
+  }
+
+  SqliteCachedStatement& SqliteCachedStatement::operator=(SqliteCachedStatement&& other) noexcept {
+    if (this != &other) {
+      try {
+        release();
+      } catch (...) {
+      }
+      mCache = other.mCache;
+      mSql = std::move(other.mSql);
+      mStatement = std::move(other.mStatement);
+      other.mStatement.reset();
+    }
+    return *this;
+  }
+
+  void SqliteCachedStatement::release() {
+    if (mStatement) {
+      SqliteStatement stmt(std::move(*mStatement));
+      mStatement.reset();
+      mCache->put(mSql, std::move(stmt));
+    }
+  }
+
+} /* namespace sdb */
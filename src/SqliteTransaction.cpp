@@ -1,4 +1,5 @@
 #include <SqliteTransaction.hpp>
+#include <SqliteDb.hpp>
 #include <SqliteException.hpp>
 
 namespace sdb {
@@ -12,21 +13,26 @@ namespace sdb {
 
     const std::string sql = [mode] {
       switch (mode) {
-        case Mode::Deferred:  return "BEGIN DEFERRED;";
-        case Mode::Exclusive: return "BEGIN EXCLUSIVE;";
-        default: return "BEGIN IMMEDIATE;";
+        case Mode::Deferred:  return "BEGIN DEFERRED";
+        case Mode::Exclusive: return "BEGIN EXCLUSIVE";
+        default: return "BEGIN IMMEDIATE";
       }
     }();
 
-    sqliteDb.execute(sql);
+    try {
+      sqliteDb.executeCached(sql);
+    } catch (SqliteException& e) {
+      throw SqliteTransactionException(e.what());
+    }
     mIntransaction = true;
   }
 
   SqliteTransaction::~SqliteTransaction() {
     if (mIntransaction) {
       try {
-        mSqliteDb.execute("ROLLBACK");
         mIntransaction = false;
+        mSqliteDb.mSavepointDepth = 0;
+        mSqliteDb.executeCached("ROLLBACK");
       } catch (...) {
         // Log error silently
       }
@@ -48,8 +54,9 @@ namespace sdb {
   void SqliteTransaction::exec(const std::string& sql) {
     if (mIntransaction) {
       try {
-        mSqliteDb.execute(sql);
+        mSqliteDb.executeCached(sql);
         mIntransaction = false;
+        mSqliteDb.mSavepointDepth = 0;
       } catch (SqliteException& e) {
         throw SqliteTransactionException(e.what());
       }